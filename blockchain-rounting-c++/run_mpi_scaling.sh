@@ -0,0 +1,93 @@
+#!/bin/bash
+
+# Strong-Scaling Study for the Distributed (MPI) Mode
+# Runs one scenario under mpirun with increasing rank counts on a single
+# multicore machine and reports wall time and speedup versus one rank.
+# Requires ns-3 configured with --enable-mpi (./ns3 configure --enable-mpi).
+#
+# Usage: ./run_mpi_scaling.sh [NODES] [FLOWS] [BLACKHOLES] [SIDE] [SIM_TIME] ["RANKS"]
+# Example: ./run_mpi_scaling.sh 5000 500 1150 3880 600 "1 2 4 8 16"
+
+# Default parameters (same node density as the 300-node dense scenario)
+NODES=${1:-5000}
+FLOWS=${2:-500}
+BLACKHOLES=${3:-1150}
+SIDE=${4:-3880}
+SIM_TIME=${5:-60.0}
+RANKS=${6:-"1 2 4 8"}
+RNG_SEED=1
+RNG_RUN=1
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+BUILD_DIR="$SCRIPT_DIR/../ns3/ns-3-dev/build/scratch"
+SIM_EXECUTABLE="ns3.46-sixg-wigig-sim-default"
+MPIRUN=${MPIRUN:-mpirun}
+
+OUTPUT_FILE="mpi_scaling_results.csv"
+LOG_DIR="mpi_scaling_logs_$(date +"%Y%m%d_%H%M%S")"
+mkdir -p "$LOG_DIR"
+
+echo "================================================================"
+echo "MPI Strong-Scaling Study - 6G MANET Blockchain Routing"
+echo "================================================================"
+echo "Parameters:"
+echo "  Nodes: $NODES"
+echo "  Flows: $FLOWS"
+echo "  Blackholes: $BLACKHOLES"
+echo "  Area: ${SIDE}m x ${SIDE}m"
+echo "  Simulation Time: $SIM_TIME seconds"
+echo "  Ranks: $RANKS"
+echo "Output file: $OUTPUT_FILE"
+echo "Log directory: $LOG_DIR"
+echo "================================================================"
+
+if [ ! -x "$BUILD_DIR/$SIM_EXECUTABLE" ]; then
+    echo "ERROR: $BUILD_DIR/$SIM_EXECUTABLE not found. Build ns-3 with --enable-mpi first."
+    exit 1
+fi
+
+echo "Ranks,WallTimeS,Speedup,Efficiency,PortalLinks,LookaheadUs,MaxRankNodes,PDR" > "$OUTPUT_FILE"
+
+BASE_WALL=""
+for NP in $RANKS; do
+    LOG_FILE="$LOG_DIR/ranks_${NP}.log"
+    echo "Running with $NP rank(s)..."
+    "$MPIRUN" -np "$NP" "$BUILD_DIR/$SIM_EXECUTABLE" \
+        --distributed=true \
+        --numNodes=$NODES \
+        --numFlows=$FLOWS \
+        --numBlackholes=$BLACKHOLES \
+        --sideLength=$SIDE \
+        --simTime=$SIM_TIME \
+        --RngSeed=$RNG_SEED \
+        --RngRun=$RNG_RUN > "$LOG_FILE" 2>&1
+    if [ $? -ne 0 ]; then
+        echo "  ERROR: run with $NP rank(s) failed (see $LOG_FILE)"
+        continue
+    fi
+
+    # [PERF] WallTimeS is the slowest rank; [MPI] describes the partitioning
+    WALL=$(grep "^\[PERF\] " "$LOG_FILE" | sed -n 's/.*WallTimeS=\([0-9.]*\).*/\1/p')
+    PORTALS=$(grep "^\[MPI\] " "$LOG_FILE" | sed -n 's/.*PortalLinks=\([0-9]*\).*/\1/p')
+    LOOKAHEAD=$(grep "^\[MPI\] " "$LOG_FILE" | sed -n 's/.*LookaheadUs=\([0-9.]*\).*/\1/p')
+    MAX_NODES=$(grep "^\[MPI\] " "$LOG_FILE" | sed -n 's/.*MaxRankNodes=\([0-9]*\).*/\1/p')
+    PDR=$(grep "^RESULT_DATA" "$LOG_FILE" | awk -F', ' '{print $4}')
+    if [ -z "$WALL" ]; then
+        echo "  ERROR: no [PERF] line in $LOG_FILE"
+        continue
+    fi
+
+    if [ -z "$BASE_WALL" ]; then
+        BASE_WALL=$WALL
+    fi
+    SPEEDUP=$(awk -v b="$BASE_WALL" -v w="$WALL" 'BEGIN { printf "%.2f", (w > 0) ? b / w : 0 }')
+    EFFICIENCY=$(awk -v s="$SPEEDUP" -v n="$NP" 'BEGIN { printf "%.2f", s / n }')
+
+    echo "$NP,$WALL,$SPEEDUP,$EFFICIENCY,$PORTALS,$LOOKAHEAD,$MAX_NODES,$PDR" >> "$OUTPUT_FILE"
+    echo "  Wall: ${WALL}s | Speedup: ${SPEEDUP}x | Efficiency: $EFFICIENCY | Portals: $PORTALS | PDR: ${PDR}%"
+done
+
+echo "================================================================"
+echo "Speedup is relative to the first rank count ($(echo $RANKS | awk '{print $1}'))."
+echo "Results written to $OUTPUT_FILE"
+echo "================================================================"
@@ -0,0 +1,37 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Build script for the sixg_core extension (pybind11 bindings of the C++ routing core)
+
+The C++ sources are shared with the ns-3 scenario (ns3/ns-3-dev/scratch/sixg-wigig-core.h).
+
+Usage:
+  pip install pybind11 numpy
+  python3 setup.py build_ext --inplace
+"""
+
+import os
+
+from pybind11.setup_helpers import Pybind11Extension, build_ext
+from setuptools import setup
+
+PROJECT_DIR = os.path.dirname(os.path.abspath(__file__))
+CORE_DIR = os.path.join(PROJECT_DIR, '..', 'ns3', 'ns-3-dev', 'scratch')
+
+ext_modules = [
+    Pybind11Extension(
+        'sixg_core',
+        [os.path.join('src', 'bindings', 'sixg_core.cpp')],
+        include_dirs=[CORE_DIR],
+        cxx_std=17,
+        extra_compile_args=['-O3'],
+    ),
+]
+
+setup(
+    name='sixg-core',
+    version='0.1.0',
+    description='Python bindings for the 6G MANET blockchain routing core',
+    ext_modules=ext_modules,
+    cmdclass={'build_ext': build_ext},
+)
@@ -0,0 +1,278 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Python bindings for the routing and trust core of the ns-3 scenario
+ * (ns3/ns-3-dev/scratch/sixg-wigig-core.h). Python prototypes get the same
+ * BuildGraph cost function, ledger trust rules and Dijkstra as the C++ runs.
+ */
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "sixg-wigig-core.h"
+
+namespace py = pybind11;
+
+// Counters referenced by the core (defined by the scenario in the ns-3 build)
+uint64_t g_trustPenalties = 0;
+bool g_lowTrustLogged = false;
+bool g_costDebugLogged = false;
+double g_avgSnrCostPart = 0.0;
+double g_avgTrustCostPart = 0.0;
+uint32_t g_pathCalculations = 0;
+
+static_assert(sizeof(NodePosition) == 3 * sizeof(double), "NodePosition must be three packed doubles");
+
+namespace {
+
+/**
+ * Topology: Mobility snapshot with a fixed node count
+ * The positions buffer never reallocates, so NumPy views of it stay valid for
+ * the lifetime of the object (the views keep the object alive).
+ */
+class Topology {
+public:
+    explicit Topology(uint32_t numNodes) {
+        m_snapshot.positions.resize(numNodes);
+        m_snapshot.valid.assign(numNodes, 1);
+    }
+
+    uint32_t GetNumNodes() const {
+        return m_snapshot.positions.size();
+    }
+
+    /**
+     * Mark the positions as a new snapshot (epoch + timestamp)
+     */
+    void Commit(double time) {
+        m_snapshot.epoch++;
+        m_snapshot.time = time;
+    }
+
+    MobilitySnapshot& GetSnapshot() {
+        return m_snapshot;
+    }
+
+private:
+    MobilitySnapshot m_snapshot;
+};
+
+/**
+ * Undirected edges of the current graph as (src, dst, weight, trust) arrays
+ */
+py::dict ExportEdges(const RoutingEngine& engine, const BlockchainLedger& ledger) {
+    const auto& weights = engine.GetWeights();
+    size_t count = 0;
+    for (const auto& entry : weights) {
+        if (entry.first.first < entry.first.second) count++;
+    }
+    py::array_t<uint32_t> src(count);
+    py::array_t<uint32_t> dst(count);
+    py::array_t<double> weight(count);
+    py::array_t<double> trust(count);
+    auto srcView = src.mutable_unchecked<1>();
+    auto dstView = dst.mutable_unchecked<1>();
+    auto weightView = weight.mutable_unchecked<1>();
+    auto trustView = trust.mutable_unchecked<1>();
+    size_t e = 0;
+    for (const auto& entry : weights) {
+        if (entry.first.first >= entry.first.second) continue;
+        srcView(e) = entry.first.first;
+        dstView(e) = entry.first.second;
+        weightView(e) = entry.second;
+        trustView(e) = ledger.GetTrust(entry.first.first, entry.first.second);
+        e++;
+    }
+    py::dict edges;
+    edges["src"] = src;
+    edges["dst"] = dst;
+    edges["weight"] = weight;
+    edges["trust"] = trust;
+    return edges;
+}
+
+} // namespace
+
+PYBIND11_MODULE(sixg_core, m) {
+    m.doc() = "Routing and trust core of the 6G MANET ns-3 scenario";
+
+    py::class_<Topology>(m, "Topology")
+        .def(py::init<uint32_t>(), py::arg("num_nodes"))
+        .def_property_readonly("num_nodes", &Topology::GetNumNodes)
+        .def_property_readonly("positions", [](py::object self) {
+            // Zero-copy, writable (N, 3) float64 view of the snapshot positions
+            auto& positions = self.cast<Topology&>().GetSnapshot().positions;
+            return py::array_t<double>({positions.size(), static_cast<size_t>(3)},
+                                       {sizeof(NodePosition), sizeof(double)},
+                                       reinterpret_cast<double*>(positions.data()), self);
+        }, "Writable (N, 3) view of node positions (metres)")
+        .def_property_readonly("valid", [](py::object self) {
+            // Zero-copy, writable (N,) uint8 view; 0 excludes a node from the graph
+            auto& valid = self.cast<Topology&>().GetSnapshot().valid;
+            return py::array_t<uint8_t>({valid.size()}, {sizeof(uint8_t)}, valid.data(), self);
+        }, "Writable (N,) view of node validity flags")
+        .def_property_readonly("epoch", [](Topology& t) { return t.GetSnapshot().epoch; })
+        .def("commit", &Topology::Commit, py::arg("time") = 0.0,
+             "Mark the current positions as a new snapshot");
+
+    py::class_<BlockchainLedger>(m, "BlockchainLedger")
+        .def(py::init<>())
+        .def_property("trust_floor", &BlockchainLedger::GetTrustFloor, &BlockchainLedger::SetTrustFloor)
+        .def("set_trust_model", [](BlockchainLedger& ledger, const std::string& name, uint32_t window,
+                                   double enterLossRatio, double exitLossRatio, uint32_t enterLossRun,
+                                   uint32_t exitDeliveryRun) {
+            TrustModel model;
+            if (!ParseTrustModel(name, model)) {
+                throw std::invalid_argument("trust model must be 'decay' or 'window'");
+            }
+            WindowTrustConfig config;
+            config.window = window;
+            config.enterLossRatio = enterLossRatio;
+            config.exitLossRatio = exitLossRatio;
+            config.enterLossRun = enterLossRun;
+            config.exitDeliveryRun = exitDeliveryRun;
+            ledger.SetTrustModel(model, config);
+        }, py::arg("model"), py::arg("window") = 64, py::arg("enter_loss_ratio") = 0.5,
+           py::arg("exit_loss_ratio") = 0.2, py::arg("enter_loss_run") = 3, py::arg("exit_delivery_run") = 8,
+           "Trust update rule: 'decay' (halve per drop) or 'window' (windowed delivery ratio with hysteresis)")
+        .def_property_readonly("trust_model", [](const BlockchainLedger& ledger) {
+            return std::string(TrustModelName(ledger.GetTrustModel()));
+        })
+        .def("update_metric", &BlockchainLedger::UpdateMetric,
+             py::arg("src"), py::arg("dst"), py::arg("snr"), py::arg("is_drop"), py::arg("use_blockchain") = true)
+        .def("get_trust", &BlockchainLedger::GetTrust, py::arg("src"), py::arg("dst"))
+        .def("get_snr", &BlockchainLedger::GetSnr, py::arg("src"), py::arg("dst"))
+        .def("delivery_ratio", &BlockchainLedger::GetDeliveryRatio, py::arg("src"), py::arg("dst"))
+        .def("loss_run", &BlockchainLedger::GetLossRun, py::arg("src"), py::arg("dst"))
+        .def("is_blackhole", &BlockchainLedger::IsBlackhole, py::arg("node_id"))
+        .def("trust_of", [](const BlockchainLedger& ledger, py::array_t<uint32_t> src, py::array_t<uint32_t> dst) {
+            // Vectorised trust lookup for link arrays
+            auto srcView = src.unchecked<1>();
+            auto dstView = dst.unchecked<1>();
+            if (srcView.shape(0) != dstView.shape(0)) {
+                throw std::invalid_argument("src and dst must have the same length");
+            }
+            py::array_t<double> trust(srcView.shape(0));
+            auto trustView = trust.mutable_unchecked<1>();
+            for (py::ssize_t i = 0; i < srcView.shape(0); i++) {
+                trustView(i) = ledger.GetTrust(srcView(i), dstView(i));
+            }
+            return trust;
+        }, py::arg("src"), py::arg("dst"))
+        .def("apply_outcomes", [](BlockchainLedger& ledger, py::array_t<uint32_t> src, py::array_t<uint32_t> dst,
+                                  py::array_t<bool> isDrop, bool useBlockchain) {
+            // One heartbeat of packet outcomes, written once per link (same result as update_metric per outcome)
+            auto srcView = src.unchecked<1>();
+            auto dstView = dst.unchecked<1>();
+            auto dropView = isDrop.unchecked<1>();
+            if (srcView.shape(0) != dstView.shape(0) || srcView.shape(0) != dropView.shape(0)) {
+                throw std::invalid_argument("src, dst and is_drop must have the same length");
+            }
+            TrustUpdateBatch batch;
+            for (py::ssize_t i = 0; i < srcView.shape(0); i++) {
+                batch.Add(srcView(i), dstView(i), dropView(i));
+            }
+            return batch.Apply(ledger, useBlockchain);
+        }, py::arg("src"), py::arg("dst"), py::arg("is_drop"), py::arg("use_blockchain") = true,
+           "Apply outcomes in order with one write per link; returns the number of links updated")
+        .def("__len__", &BlockchainLedger::GetNumLinks);
+
+    py::class_<RoutingEngine>(m, "RoutingEngine")
+        .def(py::init<double, double>(), py::arg("alpha") = 1.0, py::arg("beta") = 500.0)
+        .def_property_readonly("alpha", &RoutingEngine::GetAlpha)
+        .def_property("beta", &RoutingEngine::GetBeta, &RoutingEngine::SetBeta)
+        .def("set_use_blockchain", &RoutingEngine::SetUseBlockchain, py::arg("use_blockchain"))
+        .def("set_hierarchical", &RoutingEngine::SetHierarchical, py::arg("hierarchical"), py::arg("cell_size"))
+        .def_property_readonly("hierarchical", &RoutingEngine::IsHierarchical)
+        .def("set_contraction_hierarchy", &RoutingEngine::SetContractionHierarchy, py::arg("contracted"),
+             py::arg("range_slack") = 1.2, py::arg("threads") = 1,
+             "Route over a customizable contraction hierarchy (re-customized per build, re-contracted on new links)")
+        .def_property_readonly("contraction_hierarchy", &RoutingEngine::IsContracted)
+        .def_property_readonly("cch_stats", [](const RoutingEngine& engine) {
+            const CchRouter& cch = engine.GetCchRouter();
+            py::dict stats;
+            stats["contractions"] = cch.GetContractions();
+            stats["customizations"] = cch.GetCustomizations();
+            stats["arcs"] = cch.GetNumArcs();
+            stats["height"] = cch.GetHeight();
+            stats["queries"] = cch.GetQueries();
+            return stats;
+        })
+        .def("set_link_cost", [](RoutingEngine& engine, const std::string& mode, uint32_t packetSize) {
+            LinkCostMode costMode;
+            if (!ParseLinkCostMode(mode, costMode)) {
+                throw std::invalid_argument("link cost must be 'snr' or 'ett'");
+            }
+            engine.SetLinkCost(costMode, packetSize);
+        }, py::arg("mode"), py::arg("packet_size") = 1024,
+           "Link quality term: 'snr' (SNR penalty) or 'ett' (expected transmission time in microseconds)")
+        .def_property_readonly("link_cost", [](const RoutingEngine& engine) {
+            return std::string(LinkCostModeName(engine.GetLinkCostMode()));
+        })
+        .def("build_graph", [](RoutingEngine& engine, Topology& topology, BlockchainLedger& ledger,
+                               double maxRange, const std::set<uint32_t>& blackholes, double defaultSnr) {
+            py::gil_scoped_release release;
+            engine.BuildGraph(topology.GetSnapshot(), ledger, maxRange, blackholes, defaultSnr);
+        }, py::arg("topology"), py::arg("ledger"), py::arg("max_range"),
+           py::arg("blackholes") = std::set<uint32_t>(), py::arg("default_snr") = 20.0)
+        .def("calculate_path", [](RoutingEngine& engine, uint32_t source, uint32_t dest, BlockchainLedger* ledger) {
+            py::gil_scoped_release release;
+            return engine.CalculatePath(source, dest, ledger);
+        }, py::arg("source"), py::arg("dest"), py::arg("ledger") = nullptr)
+        .def("calculate_paths", [](RoutingEngine& engine, const std::vector<std::pair<uint32_t, uint32_t>>& flows,
+                                   BlockchainLedger* ledger) {
+            // One call for many flows (avoids per-path Python overhead)
+            std::vector<std::vector<uint32_t>> paths;
+            {
+                py::gil_scoped_release release;
+                paths.reserve(flows.size());
+                for (const auto& flow : flows) {
+                    paths.push_back(engine.CalculatePath(flow.first, flow.second, ledger));
+                }
+            }
+            return paths;
+        }, py::arg("flows"), py::arg("ledger") = nullptr)
+        .def("neighbors", [](const RoutingEngine& engine, uint32_t nodeId) {
+            const std::set<uint32_t>* neighbors = engine.GetNeighbors(nodeId);
+            return neighbors ? std::vector<uint32_t>(neighbors->begin(), neighbors->end()) : std::vector<uint32_t>();
+        }, py::arg("node_id"))
+        .def("edges", &ExportEdges, py::arg("ledger"),
+             "Undirected edges as dict of arrays: src, dst, weight, trust");
+
+    py::class_<MprSelector>(m, "MprSelector")
+        .def(py::init<>())
+        .def("update", [](MprSelector& selector, const RoutingEngine& engine, uint32_t numNodes) {
+            return selector.Update(engine.GetGraph(), numNodes);
+        }, py::arg("engine"), py::arg("num_nodes"),
+           "Take the engine's current graph; returns the number of MPR sets recomputed")
+        .def("mprs", &MprSelector::GetMprs, py::arg("node_id"))
+        .def("disseminate", [](MprSelector& selector, uint32_t origin, uint64_t blockHash) {
+            MprSelector::Dissemination result = selector.Disseminate(origin, blockHash);
+            py::dict out;
+            out["reached"] = result.reached;
+            out["mpr_transmissions"] = result.mprTransmissions;
+            out["flood_transmissions"] = result.floodTransmissions;
+            return out;
+        }, py::arg("origin"), py::arg("block_hash"),
+           "Broadcast one block over MPR relays (block_hash non-zero, unique per block)")
+        .def_property_readonly("mean_mpr_set_size", &MprSelector::GetMeanMprSetSize);
+
+    m.def("cost_counters", []() {
+        py::dict counters;
+        counters["path_calculations"] = g_pathCalculations;
+        counters["snr_cost_sum"] = g_avgSnrCostPart;
+        counters["trust_cost_sum"] = g_avgTrustCostPart;
+        counters["trust_penalties"] = g_trustPenalties;
+        return counters;
+    }, "Cost composition and trust penalty counters accumulated by the core");
+    m.def("reset_counters", []() {
+        g_pathCalculations = 0;
+        g_avgSnrCostPart = 0.0;
+        g_avgTrustCostPart = 0.0;
+        g_trustPenalties = 0;
+    });
+}
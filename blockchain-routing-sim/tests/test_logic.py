@@ -16,6 +16,13 @@ from src.core.ledger import BlockchainLedger
 from src.core.link_state import LinkStateBuffer
 from src.core.routing import RoutingEngine
 
+# Compiled core (python3 setup.py build_ext --inplace); tests are skipped without it
+try:
+    import numpy as np
+    import sixg_core
+except ImportError:
+    sixg_core = None
+
 
 class TestBlockchainLedger(unittest.TestCase):
     """Tests for BlockchainLedger"""
@@ -189,6 +196,156 @@ class TestIntegration(unittest.TestCase):
             pass
 
 
+@unittest.skipIf(sixg_core is None, "sixg_core extension not built")
+class TestCompiledCore(unittest.TestCase):
+    """Tests for the pybind11 bindings of the C++ routing core"""
+    
+    def setUp(self):
+        """Initialize before each test"""
+        self.topology = sixg_core.Topology(5)
+        self.ledger = sixg_core.BlockchainLedger()
+        self.routing = sixg_core.RoutingEngine(alpha=1.0, beta=500.0)
+        
+        # Chain 0-1-2-3 plus detour node 4 (in range of 1, 2 and 3)
+        self.topology.positions[:] = [[0.0, 0.0, 0.0],
+                                      [100.0, 0.0, 0.0],
+                                      [200.0, 0.0, 0.0],
+                                      [300.0, 0.0, 0.0],
+                                      [200.0, 100.0, 0.0]]
+        self.topology.commit(0.0)
+    
+    def test_positions_are_zero_copy(self):
+        """Test that positions views share the C++ snapshot buffer"""
+        view_a = self.topology.positions
+        view_b = self.topology.positions
+        self.assertTrue(np.shares_memory(view_a, view_b))
+        view_a[3, 0] = 1000.0  # Move node 3 out of range
+        self.routing.build_graph(self.topology, self.ledger, max_range=150.0)
+        self.assertEqual(self.routing.neighbors(3), [])
+    
+    def test_trust_rules_match_ns3(self):
+        """Test hard drop / slow recovery trust rules"""
+        self.ledger.update_metric(1, 2, 0.0, True)
+        self.assertAlmostEqual(self.ledger.get_trust(1, 2), 0.5)
+        self.ledger.update_metric(2, 1, 0.0, False)  # Links are undirected
+        self.assertAlmostEqual(self.ledger.get_trust(1, 2), 0.505)
+        for _ in range(10):
+            self.ledger.update_metric(1, 2, 0.0, True)
+        self.assertAlmostEqual(self.ledger.get_trust(1, 2), self.ledger.trust_floor)
+        trust = self.ledger.trust_of(np.array([1, 0], dtype=np.uint32), np.array([2, 1], dtype=np.uint32))
+        self.assertAlmostEqual(trust[0], self.ledger.trust_floor)
+        self.assertAlmostEqual(trust[1], 1.0)
+    
+    def test_batched_outcomes_match_sequential_updates(self):
+        """Test that apply_outcomes equals one update_metric per outcome"""
+        src = np.array([1, 2, 1, 3, 1, 2, 1], dtype=np.uint32)
+        dst = np.array([2, 1, 2, 4, 2, 1, 2], dtype=np.uint32)
+        is_drop = np.array([True, True, False, False, True, False, False])
+        sequential = sixg_core.BlockchainLedger()
+        for s, d, drop in zip(src, dst, is_drop):
+            sequential.update_metric(int(s), int(d), 0.0, bool(drop))
+        self.assertEqual(self.ledger.apply_outcomes(src, dst, is_drop), 2)
+        self.assertEqual(self.ledger.get_trust(1, 2), sequential.get_trust(1, 2))
+        self.assertEqual(self.ledger.get_trust(3, 4), sequential.get_trust(3, 4))
+    
+    def test_window_trust_flags_on_loss_run_and_clears_with_hysteresis(self):
+        """Test that the window trust model tracks the windowed delivery ratio and clears only after a delivery run"""
+        self.ledger.set_trust_model("window", window=64)
+        self.assertEqual(self.ledger.trust_model, "window")
+        for _ in range(20):
+            self.ledger.update_metric(1, 2, 0.0, False)
+        self.ledger.update_metric(1, 2, 0.0, True)
+        self.assertAlmostEqual(self.ledger.get_trust(1, 2), 20.0 / 21.0)
+        self.ledger.update_metric(1, 2, 0.0, True)
+        self.ledger.update_metric(1, 2, 0.0, True)
+        self.assertEqual(self.ledger.loss_run(1, 2), 3)
+        self.assertAlmostEqual(self.ledger.get_trust(1, 2), self.ledger.trust_floor)
+        for _ in range(7):
+            self.ledger.update_metric(1, 2, 0.0, False)
+        self.assertAlmostEqual(self.ledger.get_trust(1, 2), self.ledger.trust_floor)  # Hysteresis holds the flag
+        self.ledger.update_metric(1, 2, 0.0, False)
+        self.assertAlmostEqual(self.ledger.get_trust(1, 2), 28.0 / 31.0)
+        self.assertEqual(self.ledger.loss_run(1, 2), 0)
+        
+        batched = sixg_core.BlockchainLedger()
+        batched.set_trust_model("window", window=64)
+        is_drop = np.array([False] * 20 + [True] * 3 + [False] * 8)
+        batched.apply_outcomes(np.ones(31, dtype=np.uint32), np.full(31, 2, dtype=np.uint32), is_drop)
+        self.assertEqual(batched.get_trust(1, 2), self.ledger.get_trust(1, 2))
+        with self.assertRaises(ValueError):
+            self.ledger.set_trust_model("ewma")
+    
+    def test_mpr_dissemination_reaches_all_with_fewer_transmissions(self):
+        """Test that MPR relaying covers every node with fewer transmissions than flooding"""
+        self.routing.build_graph(self.topology, self.ledger, max_range=150.0)
+        mpr = sixg_core.MprSelector()
+        self.assertEqual(mpr.update(self.routing, 5), 5)
+        self.assertEqual(mpr.mprs(0), [1])
+        self.assertEqual(mpr.mprs(1), [2])
+        result = mpr.disseminate(0, 1)
+        self.assertEqual(result["reached"], 5)
+        self.assertEqual(result["flood_transmissions"], 5)
+        self.assertEqual(result["mpr_transmissions"], 3)
+        self.assertEqual(mpr.update(self.routing, 5), 0)  # Unchanged graph: nothing recomputed
+    
+    def test_ett_prefers_fast_hops_and_follows_delivery_ratio(self):
+        """Test that ETT costs take two fast hops over one slow hop until the fast link loses packets"""
+        topology = sixg_core.Topology(3)
+        topology.positions[:] = [[0.0, 0.0, 0.0], [50.0, 0.0, 0.0], [140.0, 0.0, 0.0]]
+        topology.commit(0.0)
+        self.routing.set_use_blockchain(False)
+        self.routing.build_graph(topology, self.ledger, max_range=150.0)
+        self.assertEqual(self.routing.calculate_path(0, 2), [0, 2])  # Hop count
+        
+        self.routing.set_link_cost("ett", packet_size=1024)
+        self.routing.build_graph(topology, self.ledger, max_range=150.0)
+        self.assertEqual(self.routing.calculate_path(0, 2), [0, 1, 2])  # 2 x 18 Mb/s beats 6 Mb/s
+        edges = self.routing.edges(self.ledger)
+        self.assertAlmostEqual(float(edges["weight"][(edges["src"] == 0) & (edges["dst"] == 2)][0]),
+                               1024 * 8 / 6e6 * 1e6, places=3)
+        
+        for _ in range(2):
+            self.ledger.update_metric(0, 1, 0.0, True)
+        self.assertAlmostEqual(self.ledger.delivery_ratio(1, 0), 1.0 / 3.0)
+        self.routing.build_graph(topology, self.ledger, max_range=150.0)
+        self.assertEqual(self.routing.calculate_path(0, 2), [0, 2])  # ETX 3 on the first hop
+        with self.assertRaises(ValueError):
+            self.routing.set_link_cost("rate")
+    
+    def test_proposed_path_avoids_low_trust_link(self):
+        """Test that compiled routing detours around a low-trust link"""
+        self.routing.build_graph(self.topology, self.ledger, max_range=150.0)
+        self.assertEqual(self.routing.calculate_path(0, 3, self.ledger), [0, 1, 2, 3])
+        
+        for _ in range(3):
+            self.ledger.update_metric(2, 3, 0.0, True)
+        self.routing.build_graph(self.topology, self.ledger, max_range=150.0)
+        self.assertEqual(self.routing.calculate_paths([(0, 3)], self.ledger), [[0, 1, 2, 4, 3]])
+        
+        edges = self.routing.edges(self.ledger)
+        low = (edges["src"] == 2) & (edges["dst"] == 3)
+        self.assertAlmostEqual(float(edges["trust"][low][0]), self.ledger.trust_floor)
+    
+    def test_contraction_hierarchy_matches_flat_and_only_recustomizes(self):
+        """Test that CCH routing returns the flat paths and trust changes do not re-contract"""
+        flat = sixg_core.RoutingEngine(alpha=1.0, beta=500.0)
+        flat.build_graph(self.topology, self.ledger, max_range=150.0)
+        self.routing.set_contraction_hierarchy(True)
+        self.assertTrue(self.routing.contraction_hierarchy)
+        self.routing.build_graph(self.topology, self.ledger, max_range=150.0)
+        self.assertEqual(self.routing.calculate_path(0, 3, self.ledger), [0, 1, 2, 3])
+        flows = [(s, d) for s in range(5) for d in range(5) if s != d]
+        self.assertEqual(self.routing.calculate_paths(flows), flat.calculate_paths(flows))
+        
+        for _ in range(3):
+            self.ledger.update_metric(2, 3, 0.0, True)
+        self.routing.build_graph(self.topology, self.ledger, max_range=150.0)
+        self.assertEqual(self.routing.calculate_path(0, 3, self.ledger), [0, 1, 2, 4, 3])
+        stats = self.routing.cch_stats
+        self.assertEqual(stats["contractions"], 1)
+        self.assertEqual(stats["customizations"], 2)
+
+
 if __name__ == "__main__":
     unittest.main()
 
@@ -0,0 +1,172 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Blockchain-assisted QoS Routing in 6G MANET (WiGig Edition)
+ * Offline replay of a ledger chain written by sixg-wigig-sim --chainStore
+ */
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define SIXG_CORE_WARN(msg) NS_LOG_WARN(msg)
+#include "sixg-wigig-core.h"
+#include "sixg-chain-store.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("SixGChainReplay");
+
+// Counters referenced by the core (only the scenario reports them)
+uint64_t g_trustPenalties = 0;
+bool g_lowTrustLogged = false;
+bool g_costDebugLogged = false;
+double g_avgSnrCostPart = 0.0;
+double g_avgTrustCostPart = 0.0;
+uint32_t g_pathCalculations = 0;
+
+// ============================================================================
+// Link History
+// ============================================================================
+
+/**
+ * Print every recorded value of one link up to untilNs
+ */
+void PrintLinkHistory(const ChainReader& reader, int64_t untilNs, uint32_t nodeA, uint32_t nodeB) {
+    uint32_t lo = std::min(nodeA, nodeB);
+    uint32_t hi = std::max(nodeA, nodeB);
+    size_t blocks = reader.CountBlocksUntil(untilNs);
+    for (size_t b = 0; b < blocks; b++) {
+        ChainBlockView block = reader.GetBlock(b);
+        for (uint32_t e = 0; e < block.count; e++) {
+            const ChainEntry& entry = block.entries[e];
+            if (entry.nodeA != lo || entry.nodeB != hi) continue;
+            std::cout << "[LINK] " << lo << "-" << hi
+                      << " | TimeS=" << std::fixed << std::setprecision(3) << block.timeNs / 1e9
+                      << " | Height=" << block.height
+                      << " | Trust=" << std::fixed << std::setprecision(4) << entry.trust
+                      << " | Snr=" << std::fixed << std::setprecision(2) << entry.movingAvgSnr
+                      << " | Drops=" << entry.drops
+                      << " | Deliveries=" << entry.deliveries << std::endl;
+        }
+    }
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(int argc, char* argv[]) {
+    std::string chain = "";
+    double time = -1.0;  // Replay up to this simulated time in seconds (negative = whole chain)
+    uint32_t numNodes = 0;  // Report flagged nodes among 0..numNodes-1 (0 = highest node ID in the ledger + 1)
+    uint32_t top = 10;  // Lowest-trust links to list
+    bool verify = false;  // Check every block checksum before replaying
+    std::string link = "";  // "a-b": print the recorded history of this link
+    double trustFloor = 0.2;  // Must match the run's --trustFloor for the blackhole flags to agree
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("chain", "Path prefix given to sixg-wigig-sim --chainStore", chain);
+    cmd.AddValue("time", "Rebuild the ledger as of this simulated time in seconds (negative = end of chain)", time);
+    cmd.AddValue("numNodes", "Node count for the flagged-node report (0 = infer from the ledger)", numNodes);
+    cmd.AddValue("top", "Number of lowest-trust links to list", top);
+    cmd.AddValue("verify", "Verify block checksums before replaying", verify);
+    cmd.AddValue("link", "Print the history of one link, given as a-b", link);
+    cmd.AddValue("trustFloor", "Trust floor of the recorded run", trustFloor);
+    cmd.Parse(argc, argv);
+
+    if (chain.empty()) {
+        NS_FATAL_ERROR("--chain=<prefix> is required");
+    }
+
+    auto openStart = std::chrono::steady_clock::now();
+    ChainReader reader;
+    std::string error;
+    if (!reader.Open(chain, error)) {
+        NS_FATAL_ERROR("cannot open chain: " << error);
+    }
+    double openMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - openStart).count();
+
+    if (verify) {
+        size_t corrupt = reader.Verify();
+        if (corrupt > 0) {
+            NS_FATAL_ERROR(corrupt << " blocks failed checksum verification");
+        }
+    }
+
+    int64_t untilNs = time < 0.0 ? reader.GetLastTimeNs() : static_cast<int64_t>(time * 1e9);
+    BlockchainLedger ledger;
+    ledger.SetTrustFloor(trustFloor);
+    auto replayStart = std::chrono::steady_clock::now();
+    uint64_t applied = ReplayLedger(reader, untilNs, ledger);
+    double replayS = std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count();
+    uint64_t replayedBytes = applied * sizeof(ChainEntry);
+
+    std::cout << "[CHAIN_REPLAY] Prefix=" << chain
+              << " | Segments=" << reader.GetNumSegments()
+              << " | RecoveredSegments=" << reader.GetRecoveredSegments()
+              << " | Blocks=" << reader.GetNumBlocks()
+              << " | Bytes=" << reader.GetBytes()
+              << " | OpenMs=" << std::fixed << std::setprecision(2) << openMs << std::endl;
+    std::cout << "[LEDGER] TimeS=" << std::fixed << std::setprecision(3) << untilNs / 1e9
+              << " | BlocksApplied=" << reader.CountBlocksUntil(untilNs)
+              << " | RecordsApplied=" << applied
+              << " | Links=" << ledger.GetNumLinks()
+              << " | ReplayMs=" << std::fixed << std::setprecision(2) << replayS * 1e3
+              << " | ReplayMBps=" << std::fixed << std::setprecision(1)
+              << (replayS > 0.0 ? replayedBytes / replayS / 1e6 : 0.0) << std::endl;
+
+    // Trust distribution and lowest-trust links
+    std::vector<std::pair<double, std::pair<uint32_t, uint32_t>>> links;
+    std::array<uint32_t, 5> buckets{};  // [0,0.2) [0.2,0.4) [0.4,0.6) [0.6,0.8) [0.8,1]
+    uint32_t maxNode = 0;
+    ledger.ForEachLink([&](uint32_t a, uint32_t b, const LinkMetric& metric) {
+        buckets[std::min<size_t>(static_cast<size_t>(metric.trust * 5.0), 4)]++;
+        links.push_back({metric.trust, {a, b}});
+        maxNode = std::max(maxNode, b);
+    });
+    if (numNodes == 0 && !links.empty()) {
+        numNodes = maxNode + 1;
+    }
+    std::cout << "[TRUST_HIST] 0.0-0.2=" << buckets[0] << " | 0.2-0.4=" << buckets[1] << " | 0.4-0.6=" << buckets[2]
+              << " | 0.6-0.8=" << buckets[3] << " | 0.8-1.0=" << buckets[4] << std::endl;
+
+    size_t shown = std::min<size_t>(top, links.size());
+    std::partial_sort(links.begin(), links.begin() + shown, links.end());
+    for (size_t i = 0; i < shown; i++) {
+        uint32_t a = links[i].second.first;
+        uint32_t b = links[i].second.second;
+        std::cout << "[LOW_TRUST] " << a << "-" << b
+                  << " | Trust=" << std::fixed << std::setprecision(4) << links[i].first
+                  << " | Snr=" << std::fixed << std::setprecision(2) << ledger.GetSnr(a, b) << std::endl;
+    }
+
+    std::cout << "[FLAGGED]";
+    uint32_t flagged = 0;
+    for (uint32_t n = 0; n < numNodes; n++) {
+        if (ledger.IsBlackhole(n)) {
+            std::cout << " " << n;
+            flagged++;
+        }
+    }
+    std::cout << " | Count=" << flagged << std::endl;
+
+    if (!link.empty()) {
+        uint32_t nodeA = 0;
+        uint32_t nodeB = 0;
+        char separator = 0;
+        std::istringstream in(link);
+        if (!(in >> nodeA >> separator >> nodeB) || separator != '-') {
+            NS_FATAL_ERROR("--link expects a-b, got " << link);
+        }
+        PrintLinkHistory(reader, untilNs, nodeA, nodeB);
+    }
+    return 0;
+}
@@ -0,0 +1,561 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Blockchain-assisted QoS Routing in 6G MANET (WiGig Edition)
+ * Append-only on-disk chain store for the ledger update log
+ */
+
+#ifndef SIXG_CHAIN_STORE_H
+#define SIXG_CHAIN_STORE_H
+
+#include "sixg-wigig-core.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// Segment File Format
+// ============================================================================
+// A chain is a sequence of segment files <prefix>.000000.chain, .000001.chain,
+// ... Each segment starts with a 64-byte header followed by frames. A frame is
+// a 16-byte frame header (payload length, type, FNV-1a checksum) and a payload
+// padded to 8 bytes, so every block can be read in place from the mapping.
+//  - Block frame: block header (time, height, entry count) + 48-byte entries,
+//    one per ledger link changed since the previous block.
+//  - Index frame: written every indexInterval blocks and when a segment is
+//    sealed; lists (time, height, offset) of the blocks since the previous
+//    index frame and links back to it.
+//  - Trailer frame: last frame of a sealed segment, points at the last index
+//    frame, so a reader walks index frames only and never touches block data.
+// Segments that were not sealed (crash, run still in progress) are recovered
+// by hopping frame headers up to the first torn frame. Integers are stored in
+// host byte order (little-endian on all supported platforms).
+
+const char kChainMagic[8] = {'S', 'I', 'X', 'G', 'C', 'H', 'N', '1'};
+const uint32_t kChainVersion = 2;  // 2: entries carry the outcome history words
+
+enum ChainFrameType : uint32_t {
+    kChainFrameBlock = 1,
+    kChainFrameIndex = 2,
+    kChainFrameTrailer = 3,
+    kChainFrameSnapshot = 4    // Heartbeat snapshot file (sixg-snapshot-log.h)
+};
+
+struct ChainSegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t segmentIndex;
+    uint32_t indexInterval;
+    uint64_t firstHeight;      // Height of the first block in this segment
+    uint8_t reserved[32];
+};
+
+struct ChainFrameHeader {
+    uint32_t length;           // Payload bytes (multiple of 8)
+    uint32_t type;             // ChainFrameType
+    uint32_t checksum;         // FNV-1a over the payload
+    uint32_t reserved;
+};
+
+struct ChainBlockHeader {
+    int64_t timeNs;            // Simulation time of the heartbeat
+    uint64_t height;           // Block number, contiguous from 0 across segments
+    uint32_t count;            // ChainEntry records that follow
+    uint32_t reserved;
+};
+
+struct ChainEntry {
+    uint32_t nodeA;
+    uint32_t nodeB;
+    double movingAvgSnr;
+    double trust;
+    uint32_t drops;
+    uint32_t deliveries;
+    uint64_t historyRecent;    // OutcomeHistory words (zero unless the window trust model is used)
+    uint64_t historyOlder;
+};
+
+struct ChainIndexEntry {
+    int64_t timeNs;
+    uint64_t height;
+    uint64_t offset;           // Frame offset within the segment
+};
+
+struct ChainIndexHeader {
+    uint64_t previousIndex;    // Offset of the previous index frame (0 = none)
+    uint64_t count;            // ChainIndexEntry records that follow
+};
+
+struct ChainTrailer {
+    uint64_t lastIndex;        // Offset of the last index frame
+    uint64_t blocks;           // Blocks in this segment
+};
+
+static_assert(sizeof(ChainSegmentHeader) == 64, "segment header must be 64 bytes");
+static_assert(sizeof(ChainFrameHeader) == 16, "frame header must be 16 bytes");
+static_assert(sizeof(ChainBlockHeader) == 24, "block header must be 24 bytes");
+static_assert(sizeof(ChainEntry) == 48, "chain entry must be 48 bytes");
+
+inline uint32_t ChainChecksum(const uint8_t* data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+inline std::string ChainSegmentPath(const std::string& prefix, uint32_t segmentIndex) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%06u.chain", segmentIndex);
+    return prefix + suffix;
+}
+
+// ============================================================================
+// Writer (group commit from a background thread)
+// ============================================================================
+
+/**
+ * ChainWriter: Appends ledger blocks; a background thread writes them in groups
+ * AppendBlock only encodes into a shared buffer. The writer thread takes every
+ * block queued since its last pass and writes them with one write() per segment
+ * (optionally followed by one fdatasync), so the simulation never waits on I/O.
+ */
+class ChainWriter {
+public:
+    ChainWriter(const std::string& prefix, uint64_t segmentBytes, uint32_t indexInterval = 64, bool durable = false)
+        : m_prefix(prefix), m_segmentBytes(segmentBytes), m_indexInterval(std::max(indexInterval, 1u)),
+          m_durable(durable), m_stop(false), m_height(0), m_fd(-1), m_segmentIndex(0), m_offset(0),
+          m_previousIndex(0), m_segmentBlocks(0), m_bytes(0), m_groupCommits(0), m_segments(0), m_failed(false) {
+        OpenSegment();
+        m_thread = std::thread(&ChainWriter::Run, this);
+    }
+
+    ~ChainWriter() {
+        Close();
+    }
+
+    ChainWriter(const ChainWriter&) = delete;
+    ChainWriter& operator=(const ChainWriter&) = delete;
+
+    /**
+     * Queue one block (records changed since the previous block)
+     */
+    void AppendBlock(int64_t timeNs, const std::vector<LedgerRecord>& records) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t start = m_queue.size();
+        size_t payload = sizeof(ChainBlockHeader) + records.size() * sizeof(ChainEntry);
+        m_queue.resize(start + sizeof(ChainFrameHeader) + payload);
+        uint8_t* frame = m_queue.data() + start;
+
+        ChainBlockHeader block{timeNs, m_height++, static_cast<uint32_t>(records.size()), 0};
+        std::memcpy(frame + sizeof(ChainFrameHeader), &block, sizeof(block));
+        uint8_t* out = frame + sizeof(ChainFrameHeader) + sizeof(block);
+        for (const LedgerRecord& record : records) {
+            ChainEntry entry{record.nodeA, record.nodeB, record.movingAvgSnr, record.trust, record.drops, record.deliveries,
+                             record.historyRecent, record.historyOlder};
+            std::memcpy(out, &entry, sizeof(entry));
+            out += sizeof(entry);
+        }
+        const uint8_t* body = frame + sizeof(ChainFrameHeader);
+        ChainFrameHeader header{static_cast<uint32_t>(payload), kChainFrameBlock, ChainChecksum(body, payload), 0};
+        std::memcpy(frame, &header, sizeof(header));
+        m_queuedBlocks.push_back(QueuedBlock{timeNs, block.height, start});
+        m_wake.notify_one();
+    }
+
+    /**
+     * Write everything queued, seal the last segment and stop the thread
+     */
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stop) return;
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+        SealSegment();
+    }
+
+    uint64_t GetBlocks() const { return m_height; }
+    uint64_t GetBytes() const { return m_bytes; }
+    uint64_t GetGroupCommits() const { return m_groupCommits; }
+    uint32_t GetSegments() const { return m_segments; }
+    bool Failed() const { return m_failed; }
+
+private:
+    struct QueuedBlock {
+        int64_t timeNs;
+        uint64_t height;
+        size_t position;       // Frame start in the queue buffer
+    };
+
+    void Run() {
+        std::vector<uint8_t> frames;
+        std::vector<QueuedBlock> blocks;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stop || !m_queuedBlocks.empty(); });
+                if (m_queuedBlocks.empty() && m_stop) return;
+                frames.swap(m_queue);
+                blocks.swap(m_queuedBlocks);
+            }
+            WriteGroup(frames, blocks);
+            frames.clear();
+            blocks.clear();
+        }
+    }
+
+    void WriteGroup(const std::vector<uint8_t>& frames, const std::vector<QueuedBlock>& blocks) {
+        m_group.clear();
+        for (size_t b = 0; b < blocks.size(); b++) {
+            size_t end = (b + 1 < blocks.size()) ? blocks[b + 1].position : frames.size();
+            size_t size = end - blocks[b].position;
+            if (m_segmentBlocks > 0 && m_offset + m_group.size() + size > m_segmentBytes) {
+                Flush();
+                SealSegment();
+                OpenSegment(blocks[b].height);
+            }
+            m_pendingIndex.push_back(ChainIndexEntry{blocks[b].timeNs, blocks[b].height, m_offset + m_group.size()});
+            m_group.insert(m_group.end(), frames.begin() + blocks[b].position, frames.begin() + end);
+            m_segmentBlocks++;
+            if (m_pendingIndex.size() >= m_indexInterval) {
+                AppendIndex();
+            }
+        }
+        Flush();
+        m_groupCommits++;
+    }
+
+    void AppendIndex() {
+        if (m_pendingIndex.empty()) return;
+        size_t payload = sizeof(ChainIndexHeader) + m_pendingIndex.size() * sizeof(ChainIndexEntry);
+        uint64_t frameOffset = m_offset + m_group.size();
+        ChainIndexHeader index{m_previousIndex, m_pendingIndex.size()};
+        std::vector<uint8_t> body(payload);
+        std::memcpy(body.data(), &index, sizeof(index));
+        std::memcpy(body.data() + sizeof(index), m_pendingIndex.data(), m_pendingIndex.size() * sizeof(ChainIndexEntry));
+        AppendFrame(kChainFrameIndex, body);
+        m_previousIndex = frameOffset;
+        m_pendingIndex.clear();
+    }
+
+    void AppendFrame(uint32_t type, const std::vector<uint8_t>& body) {
+        ChainFrameHeader header{static_cast<uint32_t>(body.size()), type, ChainChecksum(body.data(), body.size()), 0};
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(&header);
+        m_group.insert(m_group.end(), raw, raw + sizeof(header));
+        m_group.insert(m_group.end(), body.begin(), body.end());
+    }
+
+    void Flush() {
+        if (m_group.empty() || m_fd < 0) return;
+        size_t written = 0;
+        while (written < m_group.size()) {
+            ssize_t n = ::write(m_fd, m_group.data() + written, m_group.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                m_failed = true;
+                break;
+            }
+            written += n;
+        }
+        if (m_durable) {
+            ::fdatasync(m_fd);
+        }
+        m_offset += written;
+        m_bytes += written;
+        m_group.clear();
+    }
+
+    void OpenSegment(uint64_t firstHeight = 0) {
+        std::string path = ChainSegmentPath(m_prefix, m_segmentIndex);
+        m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0) {
+            m_failed = true;
+            return;
+        }
+        ChainSegmentHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kChainMagic, sizeof(header.magic));
+        header.version = kChainVersion;
+        header.headerSize = sizeof(header);
+        header.segmentIndex = m_segmentIndex;
+        header.indexInterval = m_indexInterval;
+        header.firstHeight = firstHeight;
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(&header);
+        m_group.assign(raw, raw + sizeof(header));
+        m_offset = 0;
+        m_previousIndex = 0;
+        m_segmentBlocks = 0;
+        Flush();
+        m_segments++;
+    }
+
+    /**
+     * Final index frame and trailer, then close the file
+     */
+    void SealSegment() {
+        if (m_fd < 0) return;
+        AppendIndex();
+        ChainTrailer trailer{m_previousIndex, m_segmentBlocks};
+        std::vector<uint8_t> body(sizeof(trailer));
+        std::memcpy(body.data(), &trailer, sizeof(trailer));
+        AppendFrame(kChainFrameTrailer, body);
+        Flush();
+        ::fsync(m_fd);
+        ::close(m_fd);
+        m_fd = -1;
+        m_segmentIndex++;
+    }
+
+    std::string m_prefix;
+    uint64_t m_segmentBytes;
+    uint32_t m_indexInterval;
+    bool m_durable;               // fdatasync after every group commit
+
+    // Shared with the producer
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<uint8_t> m_queue;
+    std::vector<QueuedBlock> m_queuedBlocks;
+    bool m_stop;
+    uint64_t m_height;
+
+    // Writer thread only
+    std::thread m_thread;
+    std::vector<uint8_t> m_group;
+    std::vector<ChainIndexEntry> m_pendingIndex;
+    int m_fd;
+    uint32_t m_segmentIndex;
+    uint64_t m_offset;            // Bytes in the current segment
+    uint64_t m_previousIndex;
+    uint64_t m_segmentBlocks;
+    uint64_t m_bytes;
+    uint64_t m_groupCommits;
+    uint32_t m_segments;
+    bool m_failed;
+};
+
+// ============================================================================
+// Reader (memory-mapped, zero-copy)
+// ============================================================================
+
+/**
+ * ChainBlockView: A block read in place from the mapping
+ */
+struct ChainBlockView {
+    int64_t timeNs;
+    uint64_t height;
+    uint32_t count;
+    const ChainEntry* entries;
+};
+
+/**
+ * ChainReader: Maps all segments of a chain and indexes its blocks by time
+ */
+class ChainReader {
+public:
+    ChainReader() : m_bytes(0), m_recovered(0) {}
+
+    ~ChainReader() {
+        for (const Segment& segment : m_segments) {
+            ::munmap(const_cast<uint8_t*>(segment.base), segment.size);
+        }
+    }
+
+    ChainReader(const ChainReader&) = delete;
+    ChainReader& operator=(const ChainReader&) = delete;
+
+    /**
+     * Map <prefix>.000000.chain onwards; returns false (with a message) on a bad header
+     */
+    bool Open(const std::string& prefix, std::string& error) {
+        for (uint32_t s = 0;; s++) {
+            std::string path = ChainSegmentPath(prefix, s);
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) break;
+            struct stat info;
+            if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ChainSegmentHeader)) {
+                ::close(fd);
+                error = path + ": truncated segment header";
+                return false;
+            }
+            void* base = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (base == MAP_FAILED) {
+                error = path + ": mmap failed";
+                return false;
+            }
+            ::madvise(base, info.st_size, MADV_SEQUENTIAL);
+            m_segments.push_back(Segment{static_cast<const uint8_t*>(base), static_cast<size_t>(info.st_size)});
+            m_bytes += info.st_size;
+            const ChainSegmentHeader* header = reinterpret_cast<const ChainSegmentHeader*>(base);
+            if (std::memcmp(header->magic, kChainMagic, sizeof(kChainMagic)) != 0 || header->version != kChainVersion) {
+                error = path + ": not a chain segment (bad magic or version)";
+                return false;
+            }
+            if (!LoadIndex(s)) {
+                ScanSegment(s);
+                m_recovered++;
+            }
+        }
+        if (m_segments.empty()) {
+            error = ChainSegmentPath(prefix, 0) + ": not found";
+            return false;
+        }
+        return true;
+    }
+
+    size_t GetNumBlocks() const { return m_blocks.size(); }
+    size_t GetNumSegments() const { return m_segments.size(); }
+    uint64_t GetBytes() const { return m_bytes; }
+    uint32_t GetRecoveredSegments() const { return m_recovered; }
+
+    int64_t GetLastTimeNs() const {
+        return m_blocks.empty() ? 0 : m_blocks.back().timeNs;
+    }
+
+    ChainBlockView GetBlock(size_t i) const {
+        const BlockRef& ref = m_blocks[i];
+        const uint8_t* frame = m_segments[ref.segment].base + ref.offset;
+        ChainBlockHeader header;
+        std::memcpy(&header, frame + sizeof(ChainFrameHeader), sizeof(header));
+        const ChainEntry* entries = reinterpret_cast<const ChainEntry*>(
+            frame + sizeof(ChainFrameHeader) + sizeof(ChainBlockHeader));
+        return ChainBlockView{header.timeNs, header.height, header.count, entries};
+    }
+
+    /**
+     * Number of blocks with time <= untilNs (blocks are in time order)
+     */
+    size_t CountBlocksUntil(int64_t untilNs) const {
+        auto it = std::upper_bound(m_blocks.begin(), m_blocks.end(), untilNs,
+                                   [](int64_t t, const BlockRef& ref) { return t < ref.timeNs; });
+        return it - m_blocks.begin();
+    }
+
+    /**
+     * Verify every block checksum; returns the number of corrupt blocks
+     */
+    size_t Verify() const {
+        size_t corrupt = 0;
+        for (const BlockRef& ref : m_blocks) {
+            const uint8_t* frame = m_segments[ref.segment].base + ref.offset;
+            ChainFrameHeader header;
+            std::memcpy(&header, frame, sizeof(header));
+            if (ChainChecksum(frame + sizeof(header), header.length) != header.checksum) corrupt++;
+        }
+        return corrupt;
+    }
+
+private:
+    struct Segment {
+        const uint8_t* base;
+        size_t size;
+    };
+
+    struct BlockRef {
+        int64_t timeNs;
+        uint32_t segment;
+        uint64_t offset;
+    };
+
+    const ChainFrameHeader* FrameAt(uint32_t s, uint64_t offset) const {
+        const Segment& segment = m_segments[s];
+        if (offset + sizeof(ChainFrameHeader) > segment.size) return nullptr;
+        const ChainFrameHeader* frame = reinterpret_cast<const ChainFrameHeader*>(segment.base + offset);
+        if (frame->length % 8 != 0 || offset + sizeof(ChainFrameHeader) + frame->length > segment.size) return nullptr;
+        return frame;
+    }
+
+    /**
+     * Sealed segment: follow the trailer and the index back-links (block data untouched)
+     */
+    bool LoadIndex(uint32_t s) {
+        const Segment& segment = m_segments[s];
+        uint64_t trailerOffset = segment.size - sizeof(ChainFrameHeader) - sizeof(ChainTrailer);
+        if (segment.size < sizeof(ChainSegmentHeader) + sizeof(ChainFrameHeader) + sizeof(ChainTrailer)) return false;
+        const ChainFrameHeader* frame = FrameAt(s, trailerOffset);
+        if (!frame || frame->type != kChainFrameTrailer || frame->length != sizeof(ChainTrailer)) return false;
+        ChainTrailer trailer;
+        std::memcpy(&trailer, segment.base + trailerOffset + sizeof(ChainFrameHeader), sizeof(trailer));
+
+        std::vector<BlockRef> blocks;
+        uint64_t indexOffset = trailer.lastIndex;
+        while (indexOffset != 0) {
+            const ChainFrameHeader* indexFrame = FrameAt(s, indexOffset);
+            if (!indexFrame || indexFrame->type != kChainFrameIndex) return false;
+            const uint8_t* body = segment.base + indexOffset + sizeof(ChainFrameHeader);
+            ChainIndexHeader index;
+            std::memcpy(&index, body, sizeof(index));
+            if (sizeof(index) + index.count * sizeof(ChainIndexEntry) > indexFrame->length) return false;
+            for (uint64_t e = index.count; e-- > 0; ) {
+                ChainIndexEntry entry;
+                std::memcpy(&entry, body + sizeof(index) + e * sizeof(entry), sizeof(entry));
+                blocks.push_back(BlockRef{entry.timeNs, s, entry.offset});
+            }
+            if (index.previousIndex >= indexOffset) return false;
+            indexOffset = index.previousIndex;
+        }
+        if (blocks.size() != trailer.blocks) return false;
+        m_blocks.insert(m_blocks.end(), blocks.rbegin(), blocks.rend());
+        return true;
+    }
+
+    /**
+     * Unsealed segment: hop frame headers until the end or the first torn frame
+     */
+    void ScanSegment(uint32_t s) {
+        uint64_t offset = sizeof(ChainSegmentHeader);
+        while (const ChainFrameHeader* frame = FrameAt(s, offset)) {
+            if (frame->type == kChainFrameBlock) {
+                const uint8_t* body = m_segments[s].base + offset + sizeof(ChainFrameHeader);
+                ChainBlockHeader block;
+                std::memcpy(&block, body, sizeof(block));
+                if (sizeof(block) + block.count * sizeof(ChainEntry) != frame->length) break;
+                m_blocks.push_back(BlockRef{block.timeNs, s, offset});
+            }
+            offset += sizeof(ChainFrameHeader) + frame->length;
+        }
+    }
+
+    std::vector<Segment> m_segments;
+    std::vector<BlockRef> m_blocks;   // All blocks in height order
+    uint64_t m_bytes;
+    uint32_t m_recovered;             // Segments indexed by scanning (not sealed)
+};
+
+/**
+ * Rebuild ledger state as of untilNs (every block with time <= untilNs, in order)
+ * Returns the number of entries applied.
+ */
+inline uint64_t ReplayLedger(const ChainReader& reader, int64_t untilNs, BlockchainLedger& ledger) {
+    uint64_t applied = 0;
+    size_t blocks = reader.CountBlocksUntil(untilNs);
+    for (size_t b = 0; b < blocks; b++) {
+        ChainBlockView block = reader.GetBlock(b);
+        for (uint32_t e = 0; e < block.count; e++) {
+            const ChainEntry& entry = block.entries[e];
+            ledger.ApplyRecord(LedgerRecord{entry.nodeA, entry.nodeB, entry.movingAvgSnr, entry.trust, entry.drops,
+                                            entry.deliveries, entry.historyRecent, entry.historyOlder});
+        }
+        applied += block.count;
+    }
+    return applied;
+}
+
+#endif // SIXG_CHAIN_STORE_H
@@ -0,0 +1,272 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Blockchain-assisted QoS Routing in 6G MANET (WiGig Edition)
+ * Offline routing evaluator: replays recorded heartbeat snapshots
+ * (sixg-wigig-sim --recordSnapshots) through a RoutingEngine configuration
+ */
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define SIXG_CORE_WARN(msg) NS_LOG_WARN(msg)
+#include "sixg-wigig-core.h"
+#include "sixg-snapshot-log.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("SixGRouteEval");
+
+// Counters referenced by the core
+uint64_t g_trustPenalties = 0;
+bool g_lowTrustLogged = false;
+bool g_costDebugLogged = false;
+double g_avgSnrCostPart = 0.0;
+double g_avgTrustCostPart = 0.0;
+uint32_t g_pathCalculations = 0;
+
+// ============================================================================
+// Per-Heartbeat Metrics
+// ============================================================================
+
+struct HeartbeatMetrics {
+    double pathCost = 0.0;         // Sum over routed flows of the path cost under the evaluated config
+    uint64_t hops = 0;             // Sum over routed flows
+    uint32_t routedFlows = 0;
+    uint32_t noPath = 0;           // Flows without a path
+    uint32_t flaps = 0;            // Flows whose path differs from the previous heartbeat
+    uint32_t maliciousCrossings = 0;  // Flows relaying through a malicious node
+    double buildUs = 0.0;          // BuildGraph wall time
+    double routeUs = 0.0;          // CalculatePath wall time (all flows)
+};
+
+/**
+ * Cost of a path from the engine's current edge weights
+ */
+double PathCost(const RoutingEngine& engine, const std::vector<uint32_t>& path) {
+    const auto& weights = engine.GetWeights();
+    double cost = 0.0;
+    for (size_t h = 0; h + 1 < path.size(); h++) {
+        auto it = weights.find(std::make_pair(path[h], path[h + 1]));
+        if (it != weights.end()) cost += it->second;
+    }
+    return cost;
+}
+
+double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(int argc, char* argv[]) {
+    std::string snapshots = "";
+    double alpha = -1.0;  // Negative = recorded value
+    double beta = -1.0;
+    double trustFloor = -1.0;
+    int32_t useBlockchain = -1;  // -1 = recorded, 0 = hop/SNR baseline, 1 = trust-aware
+    double maxRadioRange = -1.0;
+    std::string routingMode = "flat";
+    double clusterSize = 0.0;  // 0 = 2 x maxRadioRange
+    double cchRangeSlack = 1.2;
+    uint32_t cchThreads = 1;
+    std::string linkCost = "snr";  // Link quality term: snr or ett
+    uint32_t packetSize = 1024;  // Packet size the ETT is computed for
+    bool perHeartbeat = false;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("snapshots", "Snapshot file written by sixg-wigig-sim --recordSnapshots", snapshots);
+    cmd.AddValue("alpha", "SNR cost coefficient (negative = recorded)", alpha);
+    cmd.AddValue("beta", "Trust cost coefficient (negative = recorded)", beta);
+    cmd.AddValue("trustFloor", "Trust floor of the replayed ledger (negative = recorded)", trustFloor);
+    cmd.AddValue("useBlockchain", "Trust-aware costs: 1, 0, or -1 for the recorded setting", useBlockchain);
+    cmd.AddValue("maxRadioRange", "Neighbour range in metres (negative = recorded)", maxRadioRange);
+    cmd.AddValue("routingMode", "Route computation: flat, hierarchical or cch", routingMode);
+    cmd.AddValue("clusterSize", "Cluster cell edge length for hierarchical routing (0 = 2 x maxRadioRange)", clusterSize);
+    cmd.AddValue("cchRangeSlack", "Contraction range as a multiple of maxRadioRange for routingMode=cch", cchRangeSlack);
+    cmd.AddValue("cchThreads", "Customization threads for routingMode=cch", cchThreads);
+    cmd.AddValue("linkCost", "Link quality term: snr (SNR penalty) or ett (expected transmission time)", linkCost);
+    cmd.AddValue("packetSize", "Packet size in bytes for linkCost=ett", packetSize);
+    cmd.AddValue("perHeartbeat", "Print a [HB] line per heartbeat", perHeartbeat);
+    cmd.Parse(argc, argv);
+
+    if (snapshots.empty()) {
+        NS_FATAL_ERROR("--snapshots=<file> is required");
+    }
+    if (routingMode != "flat" && routingMode != "hierarchical" && routingMode != "cch") {
+        NS_FATAL_ERROR("Unknown routingMode '" << routingMode << "' (expected flat, hierarchical or cch)");
+    }
+    if (routingMode == "cch" && (cchRangeSlack < 1.0 || cchThreads == 0)) {
+        NS_FATAL_ERROR("cchRangeSlack must be at least 1 and cchThreads positive");
+    }
+    LinkCostMode costMode = LinkCostMode::Snr;
+    if (!ParseLinkCostMode(linkCost, costMode)) {
+        NS_FATAL_ERROR("Unknown linkCost '" << linkCost << "' (expected snr or ett)");
+    }
+
+    SnapshotReader reader;
+    std::string error;
+    if (!reader.Open(snapshots, error)) {
+        NS_FATAL_ERROR("cannot open snapshots: " << error);
+    }
+    const SnapshotFileHeader& header = reader.GetHeader();
+    alpha = alpha < 0.0 ? header.alpha : alpha;
+    beta = beta < 0.0 ? header.beta : beta;
+    trustFloor = trustFloor < 0.0 ? header.trustFloor : trustFloor;
+    bool trustAware = useBlockchain < 0 ? header.useBlockchain != 0 : useBlockchain != 0;
+    maxRadioRange = maxRadioRange < 0.0 ? header.maxRadioRange : maxRadioRange;
+    if (clusterSize <= 0.0) {
+        clusterSize = 2.0 * maxRadioRange;
+    }
+
+    RoutingEngine engine(alpha, beta);
+    engine.SetUseBlockchain(trustAware);
+    engine.SetHierarchical(routingMode == "hierarchical", clusterSize);
+    engine.SetContractionHierarchy(routingMode == "cch", cchRangeSlack, cchThreads);
+    engine.SetLinkCost(costMode, packetSize);
+    BlockchainLedger ledger;
+    ledger.SetTrustFloor(trustFloor);
+    if (header.trustWindow > 0) {
+        // Recorded delivery ratios (ETT costs) are over the run's window
+        WindowTrustConfig windowTrust;
+        windowTrust.window = header.trustWindow;
+        ledger.SetTrustModel(TrustModel::Window, windowTrust);
+    }
+
+    const auto& flows = reader.GetFlows();
+    const std::set<uint32_t>& malicious = reader.GetMalicious();
+    uint32_t numNodes = header.numNodes;
+    MobilitySnapshot mobility;
+    mobility.positions.resize(numNodes);
+    mobility.valid.resize(numNodes);
+    std::vector<std::vector<uint32_t>> previousPaths(flows.size());
+    std::vector<bool> hasPrevious(flows.size(), false);
+
+    std::cout << "[EVAL_CONFIG] Snapshots=" << snapshots
+              << " | Heartbeats=" << reader.GetNumFrames()
+              << " | Nodes=" << numNodes
+              << " | Flows=" << flows.size()
+              << " | Malicious=" << malicious.size()
+              << " | Alpha=" << alpha
+              << " | Beta=" << beta
+              << " | TrustFloor=" << trustFloor
+              << " | UseBlockchain=" << (trustAware ? 1 : 0)
+              << " | TrustWindow=" << header.trustWindow
+              << " | RoutingMode=" << routingMode
+              << " | LinkCost=" << linkCost << std::endl;
+
+    HeartbeatMetrics total;
+    std::vector<double> computeUs;
+    computeUs.reserve(reader.GetNumFrames());
+    auto wallStart = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < reader.GetNumFrames(); f++) {
+        SnapshotView frame = reader.GetFrame(f);
+        for (uint32_t c = 0; c < frame.numChanges; c++) {
+            const ChainEntry& entry = frame.changes[c];
+            ledger.ApplyRecord(LedgerRecord{entry.nodeA, entry.nodeB, entry.movingAvgSnr, entry.trust, entry.drops,
+                                            entry.deliveries, entry.historyRecent, entry.historyOlder});
+        }
+        std::copy_n(frame.positions, numNodes, mobility.positions.begin());
+        std::copy_n(frame.valid, numNodes, mobility.valid.begin());
+        mobility.epoch++;
+        mobility.time = frame.timeNs / 1e9;
+
+        HeartbeatMetrics hb;
+        auto buildStart = std::chrono::steady_clock::now();
+        engine.BuildGraph(mobility, ledger, maxRadioRange, malicious, header.defaultSnr);
+        auto routeStart = std::chrono::steady_clock::now();
+        std::vector<std::vector<uint32_t>> paths(flows.size());
+        for (size_t i = 0; i < flows.size(); i++) {
+            paths[i] = engine.CalculatePath(flows[i].first, flows[i].second, &ledger);
+        }
+        auto routeEnd = std::chrono::steady_clock::now();
+        hb.buildUs = std::chrono::duration<double, std::micro>(routeStart - buildStart).count();
+        hb.routeUs = std::chrono::duration<double, std::micro>(routeEnd - routeStart).count();
+
+        for (size_t i = 0; i < flows.size(); i++) {
+            const std::vector<uint32_t>& path = paths[i];
+            if (path.size() < 2) {
+                hb.noPath++;
+            } else {
+                hb.routedFlows++;
+                hb.hops += path.size() - 1;
+                hb.pathCost += PathCost(engine, path);
+                for (size_t h = 1; h + 1 < path.size(); h++) {
+                    if (malicious.count(path[h])) {
+                        hb.maliciousCrossings++;
+                        break;
+                    }
+                }
+            }
+            // Same rule as the simulator's route flap counter
+            if (hasPrevious[i] && path != previousPaths[i]) {
+                hb.flaps++;
+            }
+            previousPaths[i] = std::move(paths[i]);
+            hasPrevious[i] = true;
+        }
+
+        if (perHeartbeat) {
+            std::cout << "[HB] TimeS=" << std::fixed << std::setprecision(1) << mobility.time
+                      << " | LedgerChanges=" << frame.numChanges
+                      << " | MeanPathCost=" << std::fixed << std::setprecision(2)
+                      << (hb.routedFlows > 0 ? hb.pathCost / hb.routedFlows : 0.0)
+                      << " | NoPath=" << hb.noPath
+                      << " | Flaps=" << hb.flaps
+                      << " | MaliciousCrossings=" << hb.maliciousCrossings
+                      << " | BuildUs=" << std::fixed << std::setprecision(1) << hb.buildUs
+                      << " | RouteUs=" << std::fixed << std::setprecision(1) << hb.routeUs << std::endl;
+        }
+
+        total.pathCost += hb.pathCost;
+        total.hops += hb.hops;
+        total.routedFlows += hb.routedFlows;
+        total.noPath += hb.noPath;
+        total.flaps += hb.flaps;
+        total.maliciousCrossings += hb.maliciousCrossings;
+        total.buildUs += hb.buildUs;
+        total.routeUs += hb.routeUs;
+        computeUs.push_back(hb.buildUs + hb.routeUs);
+    }
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    size_t heartbeats = reader.GetNumFrames();
+    uint64_t flowHeartbeats = static_cast<uint64_t>(heartbeats) * flows.size();
+    std::cout << "[EVAL] Heartbeats=" << heartbeats
+              << " | MeanPathCost=" << std::fixed << std::setprecision(2)
+              << (total.routedFlows > 0 ? total.pathCost / total.routedFlows : 0.0)
+              << " | MeanHops=" << std::fixed << std::setprecision(2)
+              << (total.routedFlows > 0 ? static_cast<double>(total.hops) / total.routedFlows : 0.0)
+              << " | NoPathPct=" << std::fixed << std::setprecision(2)
+              << (flowHeartbeats > 0 ? 100.0 * total.noPath / flowHeartbeats : 0.0)
+              << " | Flaps=" << total.flaps
+              << " | MaliciousCrossingPct=" << std::fixed << std::setprecision(2)
+              << (total.routedFlows > 0 ? 100.0 * total.maliciousCrossings / total.routedFlows : 0.0) << std::endl;
+    std::cout << "[EVAL_TIMING] BuildMsPerHeartbeat=" << std::fixed << std::setprecision(3)
+              << (heartbeats > 0 ? total.buildUs / heartbeats / 1e3 : 0.0)
+              << " | RouteMsPerHeartbeat=" << std::fixed << std::setprecision(3)
+              << (heartbeats > 0 ? total.routeUs / heartbeats / 1e3 : 0.0)
+              << " | P50ComputeMs=" << std::fixed << std::setprecision(3) << Percentile(computeUs, 0.5) / 1e3
+              << " | P99ComputeMs=" << std::fixed << std::setprecision(3) << Percentile(computeUs, 0.99) / 1e3
+              << " | WallS=" << std::fixed << std::setprecision(3) << wallS << std::endl;
+    if (engine.IsContracted()) {
+        const CchRouter& cch = engine.GetCchRouter();
+        std::cout << "[EVAL_CCH] Contractions=" << cch.GetContractions()
+                  << " | Arcs=" << cch.GetNumArcs()
+                  << " | Height=" << cch.GetHeight()
+                  << " | ContractMs=" << std::fixed << std::setprecision(3) << cch.GetContractNs() / 1e6
+                  << " | CustomizeMs=" << std::fixed << std::setprecision(3) << cch.GetCustomizeNs() / 1e6 << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,304 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ *
+ * Blockchain-assisted QoS Routing in 6G MANET (WiGig Edition)
+ * Heartbeat snapshot file: routing inputs of every heartbeat for offline replay
+ */
+
+#ifndef SIXG_SNAPSHOT_LOG_H
+#define SIXG_SNAPSHOT_LOG_H
+
+#include "sixg-wigig-core.h"
+#include "sixg-chain-store.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// Snapshot File Format
+// ============================================================================
+// One file per run: a fixed header with the routing configuration, the flow
+// list and the malicious node IDs (both fixed for a run), then one snapshot
+// frame per heartbeat. Frames use the chain store frame header; the payload is
+// the heartbeat time, every node's position and validity flag, and the ledger
+// entries changed since the previous snapshot (ChainEntry). Replaying the
+// frames in order reproduces exactly the inputs BuildGraph and CalculatePath
+// saw during the run.
+
+const char kSnapshotMagic[8] = {'S', 'I', 'X', 'G', 'S', 'N', 'P', '1'};
+const uint32_t kSnapshotVersion = 2;  // 2: outcome history words and trust window
+
+struct SnapshotFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numNodes;
+    uint32_t numFlows;         // (source, dest) uint32 pairs after the header
+    uint32_t numMalicious;     // uint32 node IDs after the flows (padded to 8 bytes)
+    double alpha;
+    double beta;
+    double maxRadioRange;
+    double defaultSnr;
+    double trustFloor;
+    uint32_t useBlockchain;
+    uint32_t trustWindow;      // Window trust model length (0 = decay model)
+};
+
+struct SnapshotFrameHeader {
+    int64_t timeNs;
+    uint32_t numChanges;       // ChainEntry records after positions and flags
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SnapshotFileHeader) == 72, "snapshot header layout changed");
+static_assert(sizeof(NodePosition) == 24, "NodePosition must be three packed doubles");
+
+/**
+ * Routing configuration recorded with the snapshots
+ */
+struct SnapshotConfig {
+    double alpha;
+    double beta;
+    double maxRadioRange;
+    double defaultSnr;
+    double trustFloor;
+    bool useBlockchain;
+    uint32_t trustWindow;      // 0 = decay model
+};
+
+inline size_t SnapshotPad8(size_t bytes) {
+    return (bytes + 7) & ~static_cast<size_t>(7);
+}
+
+// ============================================================================
+// Recorder
+// ============================================================================
+
+/**
+ * SnapshotRecorder: Appends one frame per heartbeat through a large stdio buffer
+ */
+class SnapshotRecorder {
+public:
+    SnapshotRecorder() : m_file(nullptr), m_numNodes(0), m_frames(0), m_bytes(0) {}
+
+    ~SnapshotRecorder() {
+        Close();
+    }
+
+    SnapshotRecorder(const SnapshotRecorder&) = delete;
+    SnapshotRecorder& operator=(const SnapshotRecorder&) = delete;
+
+    /**
+     * Create the file and write the header, flows and malicious nodes
+     */
+    bool Open(const std::string& path, uint32_t numNodes, const SnapshotConfig& config,
+              const std::vector<std::pair<uint32_t, uint32_t>>& flows, const std::set<uint32_t>& malicious) {
+        m_file = std::fopen(path.c_str(), "wb");
+        if (!m_file) return false;
+        std::setvbuf(m_file, nullptr, _IOFBF, 1 << 20);
+        m_numNodes = numNodes;
+
+        SnapshotFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+        header.version = kSnapshotVersion;
+        header.numNodes = numNodes;
+        header.numFlows = flows.size();
+        header.numMalicious = malicious.size();
+        header.alpha = config.alpha;
+        header.beta = config.beta;
+        header.maxRadioRange = config.maxRadioRange;
+        header.defaultSnr = config.defaultSnr;
+        header.trustFloor = config.trustFloor;
+        header.useBlockchain = config.useBlockchain ? 1 : 0;
+        header.trustWindow = config.trustWindow;
+        Write(&header, sizeof(header));
+
+        std::vector<uint32_t> words;
+        for (const auto& flow : flows) {
+            words.push_back(flow.first);
+            words.push_back(flow.second);
+        }
+        words.insert(words.end(), malicious.begin(), malicious.end());
+        if (words.size() % 2 != 0) words.push_back(0);
+        Write(words.data(), words.size() * sizeof(uint32_t));
+        return true;
+    }
+
+    /**
+     * Append the heartbeat's positions and ledger changes
+     */
+    void Record(int64_t timeNs, const MobilitySnapshot& snapshot, const std::vector<LedgerRecord>& changes) {
+        if (!m_file) return;
+        size_t positionBytes = m_numNodes * sizeof(NodePosition);
+        size_t validBytes = SnapshotPad8(m_numNodes);
+        size_t payload = sizeof(SnapshotFrameHeader) + positionBytes + validBytes + changes.size() * sizeof(ChainEntry);
+        m_frame.assign(payload, 0);
+
+        SnapshotFrameHeader header{timeNs, static_cast<uint32_t>(changes.size()), 0};
+        uint8_t* out = m_frame.data();
+        std::memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        std::memcpy(out, snapshot.positions.data(), positionBytes);
+        out += positionBytes;
+        std::memcpy(out, snapshot.valid.data(), m_numNodes);
+        out += validBytes;
+        for (const LedgerRecord& record : changes) {
+            ChainEntry entry{record.nodeA, record.nodeB, record.movingAvgSnr, record.trust, record.drops, record.deliveries,
+                             record.historyRecent, record.historyOlder};
+            std::memcpy(out, &entry, sizeof(entry));
+            out += sizeof(entry);
+        }
+
+        ChainFrameHeader frame{static_cast<uint32_t>(payload), kChainFrameSnapshot,
+                               ChainChecksum(m_frame.data(), payload), 0};
+        Write(&frame, sizeof(frame));
+        Write(m_frame.data(), payload);
+        m_frames++;
+    }
+
+    void Close() {
+        if (m_file) {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    uint64_t GetFrames() const { return m_frames; }
+    uint64_t GetBytes() const { return m_bytes; }
+
+private:
+    void Write(const void* data, size_t bytes) {
+        std::fwrite(data, 1, bytes, m_file);
+        m_bytes += bytes;
+    }
+
+    std::FILE* m_file;
+    uint32_t m_numNodes;
+    std::vector<uint8_t> m_frame;  // Reused encode buffer
+    uint64_t m_frames;
+    uint64_t m_bytes;
+};
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+/**
+ * SnapshotView: One heartbeat read in place from the mapping
+ */
+struct SnapshotView {
+    int64_t timeNs;
+    const NodePosition* positions;
+    const uint8_t* valid;
+    uint32_t numChanges;
+    const ChainEntry* changes;
+};
+
+/**
+ * SnapshotReader: Maps a snapshot file and indexes its frames
+ */
+class SnapshotReader {
+public:
+    SnapshotReader() : m_base(nullptr), m_size(0) {}
+
+    ~SnapshotReader() {
+        if (m_base) ::munmap(const_cast<uint8_t*>(m_base), m_size);
+    }
+
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    /**
+     * Map the file; frames after a torn or corrupt frame are ignored
+     */
+    bool Open(const std::string& path, std::string& error) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = path + ": not found";
+            return false;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SnapshotFileHeader)) {
+            ::close(fd);
+            error = path + ": truncated header";
+            return false;
+        }
+        void* base = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            error = path + ": mmap failed";
+            return false;
+        }
+        m_base = static_cast<const uint8_t*>(base);
+        m_size = info.st_size;
+        std::memcpy(&m_header, m_base, sizeof(m_header));
+        if (std::memcmp(m_header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+            m_header.version != kSnapshotVersion) {
+            error = path + ": not a snapshot file (bad magic or version)";
+            return false;
+        }
+
+        size_t words = 2 * static_cast<size_t>(m_header.numFlows) + m_header.numMalicious;
+        size_t offset = sizeof(m_header) + SnapshotPad8(words * sizeof(uint32_t));
+        if (offset > m_size) {
+            error = path + ": truncated flow list";
+            return false;
+        }
+        const uint32_t* list = reinterpret_cast<const uint32_t*>(m_base + sizeof(m_header));
+        for (uint32_t f = 0; f < m_header.numFlows; f++) {
+            m_flows.push_back({list[2 * f], list[2 * f + 1]});
+        }
+        m_malicious.insert(list + 2 * m_header.numFlows, list + words);
+
+        size_t fixedBytes = sizeof(SnapshotFrameHeader) + m_header.numNodes * sizeof(NodePosition) +
+                            SnapshotPad8(m_header.numNodes);
+        while (offset + sizeof(ChainFrameHeader) <= m_size) {
+            ChainFrameHeader frame;
+            std::memcpy(&frame, m_base + offset, sizeof(frame));
+            size_t end = offset + sizeof(frame) + frame.length;
+            if (frame.type != kChainFrameSnapshot || frame.length < fixedBytes || end > m_size) break;
+            const uint8_t* body = m_base + offset + sizeof(frame);
+            if (ChainChecksum(body, frame.length) != frame.checksum) break;
+            SnapshotFrameHeader header;
+            std::memcpy(&header, body, sizeof(header));
+            if (fixedBytes + header.numChanges * sizeof(ChainEntry) != frame.length) break;
+            m_frames.push_back(offset + sizeof(frame));
+            offset = end;
+        }
+        return true;
+    }
+
+    const SnapshotFileHeader& GetHeader() const { return m_header; }
+    const std::vector<std::pair<uint32_t, uint32_t>>& GetFlows() const { return m_flows; }
+    const std::set<uint32_t>& GetMalicious() const { return m_malicious; }
+    size_t GetNumFrames() const { return m_frames.size(); }
+    uint64_t GetBytes() const { return m_size; }
+
+    SnapshotView GetFrame(size_t i) const {
+        const uint8_t* body = m_base + m_frames[i];
+        SnapshotFrameHeader header;
+        std::memcpy(&header, body, sizeof(header));
+        const uint8_t* positions = body + sizeof(header);
+        const uint8_t* valid = positions + m_header.numNodes * sizeof(NodePosition);
+        const uint8_t* changes = valid + SnapshotPad8(m_header.numNodes);
+        return SnapshotView{header.timeNs, reinterpret_cast<const NodePosition*>(positions), valid,
+                            header.numChanges, reinterpret_cast<const ChainEntry*>(changes)};
+    }
+
+private:
+    const uint8_t* m_base;
+    size_t m_size;
+    SnapshotFileHeader m_header;
+    std::vector<std::pair<uint32_t, uint32_t>> m_flows;
+    std::set<uint32_t> m_malicious;
+    std::vector<size_t> m_frames;   // Payload offsets
+};
+
+#endif // SIXG_SNAPSHOT_LOG_H
@@ -0,0 +1,2576 @@
+/*
+ * SPDX-License-Identifier: GPL-2.0-only
+ * 
+ * Blockchain-assisted QoS Routing in 6G MANET (WiGig Edition)
+ * Routing and trust core shared by the ns-3 scenario and the Python bindings
+ */
+
+#ifndef SIXG_WIGIG_CORE_H
+#define SIXG_WIGIG_CORE_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <queue>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// The core does not depend on ns-3. Warnings go through SIXG_CORE_WARN, which
+// the ns-3 scenario maps to NS_LOG_WARN; standalone builds drop them.
+#ifndef SIXG_CORE_WARN
+#define SIXG_CORE_WARN(msg) do {} while (0)
+#endif
+
+// Counters defined by the including program
+extern uint64_t g_trustPenalties;   // Number of trust penalties applied
+extern bool g_lowTrustLogged;       // Low trust logged once per BuildGraph call
+extern bool g_costDebugLogged;      // Cost components logged once per BuildGraph call
+extern double g_avgSnrCostPart;     // Sum of SNR cost parts over path calculations
+extern double g_avgTrustCostPart;   // Sum of Trust cost parts over path calculations
+extern uint32_t g_pathCalculations; // Number of path calculations (for averaging)
+
+// ============================================================================
+// Data Structures
+// ============================================================================
+
+/**
+ * OutcomeHistory: The last 128 outcomes of a link as a shift register of loss bits
+ * The newest outcome is the top bit of recent and older outcomes shift right
+ * into older. Windowed loss counts are popcounts and the current loss run is
+ * a count of leading ones, so an update or query is a few instructions.
+ */
+struct OutcomeHistory {
+    static constexpr uint32_t kCapacity = 128;
+    
+    uint64_t recent = 0;   // Outcomes 1..64 (newest at bit 63), 1 = loss
+    uint64_t older = 0;    // Outcomes 65..128
+    uint32_t samples = 0;  // Outcomes recorded, saturating at kCapacity
+    
+    /**
+     * Shift in count outcomes of the same kind
+     */
+    void Push(bool isLoss, uint32_t count = 1) {
+        if (count == 0) return;
+        uint64_t ones = ~static_cast<uint64_t>(0);
+        if (count >= kCapacity) {
+            recent = older = isLoss ? ones : 0;
+        } else if (count >= 64) {
+            older = count == 64 ? recent : recent >> (count - 64);
+            recent = isLoss ? ones : 0;
+            if (isLoss && count > 64) older |= ones << (kCapacity - count);
+        } else {
+            older = (older >> count) | (recent << (64 - count));
+            recent >>= count;
+            if (isLoss) recent |= ones << (64 - count);
+        }
+        samples = std::min(kCapacity, samples + count);
+    }
+    
+    /**
+     * Outcomes recorded among the last window (at most window)
+     */
+    uint32_t GetSamples(uint32_t window) const {
+        return std::min(samples, window);
+    }
+    
+    /**
+     * Losses among the last window outcomes (window in 1..kCapacity)
+     */
+    uint32_t GetLosses(uint32_t window) const {
+        if (window >= 64) {
+            return __builtin_popcountll(recent) + __builtin_popcountll(older & TopBits(window - 64));
+        }
+        return __builtin_popcountll(recent & TopBits(window));
+    }
+    
+    /**
+     * Consecutive losses ending with the newest outcome
+     */
+    uint32_t GetLossRun() const {
+        if (~recent != 0) return __builtin_clzll(~recent);
+        return 64 + (~older != 0 ? __builtin_clzll(~older) : 64);
+    }
+    
+    /**
+     * Consecutive deliveries ending with the newest outcome
+     */
+    uint32_t GetDeliveryRun() const {
+        uint32_t run = recent != 0 ? __builtin_clzll(recent) : 64 + (older != 0 ? __builtin_clzll(older) : 64);
+        return std::min(run, samples);  // Unrecorded slots are zero too
+    }
+    
+private:
+    static uint64_t TopBits(uint32_t count) {
+        return count == 0 ? 0 : ~static_cast<uint64_t>(0) << (64 - count);
+    }
+};
+
+/**
+ * LinkMetric: Stores metrics for a link between two nodes
+ */
+struct LinkMetric {
+    double movingAvgSnr = 0.0;  // Linear SNR (moving average)
+    uint32_t drops = 0;         // Loss counter
+    uint32_t deliveries = 0;    // Delivery counter (delivery ratio for ETT costs)
+    double trust = 1.0;         // Trust level (starts at 1.0)
+    bool dirty = false;         // Changed since the last distributed exchange
+    bool windowLow = false;     // Window trust model: link held at the trust floor (hysteresis state)
+    OutcomeHistory history;     // Window trust model: recent outcomes
+    
+    LinkMetric() : movingAvgSnr(0.0), drops(0), deliveries(0), trust(1.0) {}
+};
+
+/**
+ * LedgerRecord: Flat copy of one ledger entry for the distributed boundary exchange
+ */
+struct LedgerRecord {
+    uint32_t nodeA;
+    uint32_t nodeB;
+    double movingAvgSnr;
+    double trust;
+    uint32_t drops;
+    uint32_t deliveries;
+    uint64_t historyRecent;   // OutcomeHistory words (window trust model)
+    uint64_t historyOlder;
+};
+
+/**
+ * OutcomeRun: Consecutive packet outcomes of the same kind on one link
+ */
+struct OutcomeRun {
+    bool isDrop;
+    uint32_t count;
+};
+
+/**
+ * NodeTrustCounts: Links of one node and how many of them are at the trust floor
+ */
+struct NodeTrustCounts {
+    uint32_t links = 0;
+    uint32_t lowTrustLinks = 0;
+};
+
+/**
+ * Trust update rule of the ledger
+ * Decay halves trust per drop and adds 0.005 per delivery. Window sets trust to
+ * the delivery ratio over the last outcomes of the link's OutcomeHistory, and
+ * holds a link at the trust floor from a loss that makes the window bad until a
+ * run of deliveries makes it good again (hysteresis between enter and exit thresholds).
+ */
+enum class TrustModel {
+    Decay,
+    Window
+};
+
+inline bool ParseTrustModel(const std::string& name, TrustModel& model) {
+    if (name == "decay") {
+        model = TrustModel::Decay;
+    } else if (name == "window") {
+        model = TrustModel::Window;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline const char* TrustModelName(TrustModel model) {
+    return model == TrustModel::Window ? "window" : "decay";
+}
+
+/**
+ * WindowTrustConfig: Window length and hysteresis thresholds of TrustModel::Window
+ */
+struct WindowTrustConfig {
+    uint32_t window = 64;          // Outcomes considered (1..OutcomeHistory::kCapacity)
+    double enterLossRatio = 0.5;   // A loss leaving this windowed loss ratio or more flags the link...
+    uint32_t minSamples = 8;       // ...once the window holds this many outcomes
+    uint32_t enterLossRun = 3;     // A run of this many losses flags the link regardless (decay: 3 drops to the floor)
+    double exitLossRatio = 0.2;    // A delivery bringing the loss ratio down to this clears the flag...
+    uint32_t exitDeliveryRun = 8;  // ...if it is at least the last of this many consecutive deliveries
+};
+
+/**
+ * BlockchainLedger: Trust layer for storing link metrics
+ * Per-node link and low-trust counts are kept up to date on every write, so
+ * IsBlackhole() is O(1) and flag changes are reported as they happen.
+ */
+class BlockchainLedger {
+public:
+    /** Called when a node's IsBlackhole() result changes (nodeId, flagged) */
+    typedef std::function<void(uint32_t, bool)> BlackholeCallback;
+    
+    BlockchainLedger() : m_lossThreshold(0.5), m_defaultTrust(1.0), m_defaultSnr(20.0), m_trustFloor(0.2),
+                         m_trackDirty(false), m_trustModel(TrustModel::Decay), m_windowEnters(0), m_windowExits(0) {}
+    
+    /**
+     * Select the trust update rule (set before the first update)
+     */
+    void SetTrustModel(TrustModel model, const WindowTrustConfig& config = WindowTrustConfig()) {
+        m_trustModel = model;
+        m_window = config;
+        m_window.window = std::max<uint32_t>(1, std::min(m_window.window, OutcomeHistory::kCapacity));
+    }
+    
+    TrustModel GetTrustModel() const {
+        return m_trustModel;
+    }
+    
+    const WindowTrustConfig& GetWindowConfig() const {
+        return m_window;
+    }
+    
+    /**
+     * Remember changed entries so they can be exchanged between MPI ranks
+     */
+    void SetDirtyTracking(bool enabled) {
+        m_trackDirty = enabled;
+    }
+    
+    /**
+     * Append entries changed since the last call to out and clear their dirty flag
+     */
+    void CollectDirty(std::vector<LedgerRecord>& out) {
+        for (const auto& key : m_dirty) {
+            LinkMetric& metric = m_ledger[key];
+            metric.dirty = false;
+            out.push_back(LedgerRecord{key.first, key.second, metric.movingAvgSnr, metric.trust, metric.drops,
+                                       metric.deliveries, metric.history.recent, metric.history.older});
+        }
+        m_dirty.clear();
+    }
+    
+    /**
+     * Overwrite an entry with a record from the boundary exchange (not marked dirty)
+     */
+    void ApplyRecord(const LedgerRecord& record) {
+        auto key = MakeKey(record.nodeA, record.nodeB);
+        LinkMetric& metric = FindOrAddLink(key);
+        double oldTrust = metric.trust;
+        metric.movingAvgSnr = record.movingAvgSnr;
+        metric.trust = record.trust;
+        metric.drops = record.drops;
+        metric.deliveries = record.deliveries;
+        // The window model counts every outcome in drops or deliveries and holds flagged
+        // links exactly at the floor, so the two words restore the whole window state
+        metric.history.recent = record.historyRecent;
+        metric.history.older = record.historyOlder;
+        metric.history.samples = std::min(OutcomeHistory::kCapacity, record.drops + record.deliveries);
+        metric.windowLow = metric.trust <= m_trustFloor;
+        OnTrustChange(key, oldTrust, metric.trust);
+    }
+    
+    /**
+     * Report IsBlackhole() transitions (replaces polling the ledger)
+     */
+    void SetBlackholeCallback(BlackholeCallback callback) {
+        m_blackholeCallback = callback;
+    }
+    
+    void SetTrustFloor(double floor) {
+        m_trustFloor = floor;
+        // The low-trust classification depends on the floor: recount (no callbacks)
+        for (NodeTrustCounts& counts : m_nodeCounts) {
+            counts.lowTrustLinks = 0;
+        }
+        for (const auto& pair : m_ledger) {
+            if (pair.second.trust <= m_trustFloor) {
+                m_nodeCounts[pair.first.first].lowTrustLinks++;
+                if (pair.first.second != pair.first.first) m_nodeCounts[pair.first.second].lowTrustLinks++;
+            }
+        }
+    }
+    
+    double GetTrustFloor() const {
+        return m_trustFloor;
+    }
+    
+    void UpdateMetric(uint32_t src, uint32_t dst, double snr, bool isDrop, bool useBlockchain = true) {
+        // OPTIMIZED: Removed verbose logging - called too frequently (every packet)
+        // NS_LOG_UNCOND("LEDGER UPDATE: Link " << src << "->" << dst << " | SNR: " << snr << " | Dropped: " << isDrop);
+        
+        auto key = MakeKey(src, dst);
+        LinkMetric& metric = FindOrAddLink(key);
+        double oldTrust = metric.trust;
+        if (m_trackDirty && !metric.dirty) {
+            metric.dirty = true;
+            m_dirty.push_back(key);
+        }
+        
+        // Update SNR (exponential moving average)
+        if (snr > 0.0) {
+            double alpha = 0.3;
+            metric.movingAvgSnr = alpha * snr + (1.0 - alpha) * metric.movingAvgSnr;
+        }
+        
+        // TASK 2: Asymmetric Trust - Hard Drop, Slow Recovery
+        // Trust should never go below 0.2 to maintain connectivity even through "bad" nodes
+        // CRITICAL: Only apply trust penalties in Proposed mode (useBlockchain = true)
+        // In Baseline mode, trust is not used for routing, so penalties are unnecessary
+        if (m_trustModel == TrustModel::Window) {
+            // Windowed delivery ratio with hysteresis instead of decay and recovery steps
+            metric.history.Push(isDrop);
+            (isDrop ? metric.drops : metric.deliveries)++;
+            if (useBlockchain) {
+                g_trustPenalties += isDrop ? 1 : 0;
+                UpdateWindowTrust(metric, isDrop);
+            }
+        } else if (isDrop && useBlockchain) {
+            metric.drops++;
+            g_trustPenalties++;
+            
+            // TASK 2: Asymmetric Trust - Hard Drop, Slow Recovery
+            // Geometric decay: trust = max(m_trustFloor, trust * 0.5)
+            // Drops fast to prevent On-Off attacks
+            // Floor is configurable for ablation study
+            metric.trust = std::max(m_trustFloor, metric.trust * 0.5);
+            
+            // OPTIMIZED: Removed verbose logging - trust penalties happen frequently
+            // std::cout << "[TRUST_LOG] TRUST_PENALTY: Node " << src << " -> " << dst 
+            //           << " | Drops: " << metric.drops 
+            //           << " | Old Trust: " << std::fixed << std::setprecision(4) << oldTrust
+            //           << " | New Trust: " << std::fixed << std::setprecision(4) << metric.trust
+            //           << " | Time: " << std::fixed << std::setprecision(3) 
+            //           << Simulator::Now().GetSeconds() << "s" << std::endl;
+        } else if (isDrop) {
+            // Baseline mode: Just count drops, don't apply trust penalties
+            metric.drops++;
+        } else if (!isDrop && useBlockchain) {
+            metric.deliveries++;
+            // TASK 2: Slow Down Recovery (Final Calibration)
+            // Linear recovery: trust = min(1.0, trust + 0.005)
+            // It takes ~200 successful packets to recover full trust (from 0.2 to 1.0)
+            // This proves we handle "On-Off" attacks by requiring a long history of success
+            // Slow recovery ensures attackers cannot quickly redeem themselves after dropping packets
+            metric.trust = std::min(1.0, metric.trust + 0.005);
+        } else {
+            metric.deliveries++;
+        }
+        OnTrustChange(key, oldTrust, metric.trust);
+    }
+    
+    /**
+     * Apply a link's outcomes of one heartbeat (runs in encounter order) with one lookup
+     * Same result as calling UpdateMetric(src, dst, 0.0, isDrop) once per outcome:
+     * m halvings collapse to max(floor, t * 2^-m), which is exact for a positive floor
+     * (power-of-two scaling, clamping is monotone); recoveries keep the k-step sum
+     * because t + k * 0.005 rounds differently from k additions.
+     */
+    void ApplyOutcomeRuns(uint32_t src, uint32_t dst, const OutcomeRun* runs, size_t numRuns, bool useBlockchain = true) {
+        auto key = MakeKey(src, dst);
+        LinkMetric& metric = FindOrAddLink(key);
+        double oldTrust = metric.trust;
+        if (m_trackDirty && !metric.dirty) {
+            metric.dirty = true;
+            m_dirty.push_back(key);
+        }
+        for (size_t r = 0; r < numRuns; r++) {
+            uint32_t count = runs[r].count;
+            if (m_trustModel == TrustModel::Window) {
+                // Flags only change on the outcome kind that can change them, and
+                // both checks are monotone along a run: one check per run is exact
+                metric.history.Push(runs[r].isDrop, count);
+                (runs[r].isDrop ? metric.drops : metric.deliveries) += count;
+                if (!useBlockchain) continue;
+                g_trustPenalties += runs[r].isDrop ? count : 0;
+                UpdateWindowTrust(metric, runs[r].isDrop);
+                continue;
+            }
+            if (runs[r].isDrop) {
+                metric.drops += count;
+                if (!useBlockchain) continue;
+                g_trustPenalties += count;
+                if (m_trustFloor > 0.0) {
+                    metric.trust = std::max(m_trustFloor, std::ldexp(metric.trust, -static_cast<int>(std::min(count, 2048u))));
+                } else {
+                    for (uint32_t i = 0; i < count; i++) {
+                        metric.trust = std::max(m_trustFloor, metric.trust * 0.5);
+                    }
+                }
+            } else {
+                metric.deliveries += count;
+                if (!useBlockchain) continue;
+                for (uint32_t i = 0; i < count && metric.trust < 1.0; i++) {
+                    metric.trust = std::min(1.0, metric.trust + 0.005);
+                }
+            }
+        }
+        OnTrustChange(key, oldTrust, metric.trust);
+    }
+    
+    // DEPRECATED: SetBlackhole() is NOT used - system must detect blackholes dynamically
+    // This function exists for backward compatibility but should NOT be called
+    // The system uses PURE dynamic detection via trust decay (packet drops)
+    void SetBlackhole(uint32_t nodeId) {
+        // DO NOT USE THIS FUNCTION - it hardcodes trust values
+        // System must detect blackholes dynamically via trust decay
+        // This function is kept for backward compatibility only
+        SIXG_CORE_WARN("SetBlackhole() called - this is deprecated. System should detect blackholes dynamically via trust decay.");
+    }
+    
+    double GetTrust(uint32_t src, uint32_t dst) const {
+        // CRITICAL: Do NOT check blackholeNodes set here!
+        // System must DETECT blackholes dynamically via trust decay (packet drops)
+        // Initially, all nodes have trust = 1.0 (including blackholes)
+        // Trust will decay as blackholes drop packets, and system will detect them
+        
+        auto key = MakeKey(src, dst);
+        auto it = m_ledger.find(key);
+        if (it != m_ledger.end()) {
+            return it->second.trust;
+        }
+        return m_defaultTrust;
+    }
+    
+    /**
+     * Fold a measured SNR sample (dB) into an existing link's moving average
+     * Trust and counters are unchanged, and unknown links are not created (a
+     * link seen only at the MAC would otherwise dilute the blackhole majority).
+     */
+    bool RecordSnr(uint32_t src, uint32_t dst, double snrDb) {
+        auto key = MakeKey(src, dst);
+        auto it = m_ledger.find(key);
+        if (it == m_ledger.end()) {
+            return false;
+        }
+        LinkMetric& metric = it->second;
+        if (m_trackDirty && !metric.dirty) {
+            metric.dirty = true;
+            m_dirty.push_back(key);
+        }
+        // Seeded with the first sample; kept positive since 0 means "no sample"
+        snrDb = std::max(snrDb, 0.1);
+        metric.movingAvgSnr = metric.movingAvgSnr > 0.0 ? 0.3 * snrDb + 0.7 * metric.movingAvgSnr : snrDb;
+        return true;
+    }
+    
+    /**
+     * Moving-average SNR (dB) of a link, or 0 if no sample was recorded
+     */
+    double GetMeasuredSnr(uint32_t src, uint32_t dst) const {
+        auto it = m_ledger.find(MakeKey(src, dst));
+        return it != m_ledger.end() ? it->second.movingAvgSnr : 0.0;
+    }
+    
+    /**
+     * Fraction of outcomes delivered, with one prior delivery so unmeasured links count as 1.0
+     * The window trust model counts the outcomes in its window only.
+     */
+    double GetDeliveryRatio(uint32_t src, uint32_t dst) const {
+        auto it = m_ledger.find(MakeKey(src, dst));
+        if (it == m_ledger.end()) {
+            return 1.0;
+        }
+        const LinkMetric& metric = it->second;
+        if (m_trustModel == TrustModel::Window) {
+            uint32_t samples = metric.history.GetSamples(m_window.window);
+            return (samples - metric.history.GetLosses(m_window.window) + 1.0) / (samples + 1.0);
+        }
+        return (metric.deliveries + 1.0) / (metric.deliveries + metric.drops + 1.0);
+    }
+    
+    /**
+     * Consecutive losses ending with a link's latest outcome (window trust model)
+     */
+    uint32_t GetLossRun(uint32_t src, uint32_t dst) const {
+        auto it = m_ledger.find(MakeKey(src, dst));
+        return it != m_ledger.end() ? it->second.history.GetLossRun() : 0;
+    }
+    
+    /**
+     * Window trust model: links flagged and cleared by the hysteresis so far
+     */
+    uint64_t GetWindowEnters() const { return m_windowEnters; }
+    uint64_t GetWindowExits() const { return m_windowExits; }
+    
+    double GetSnr(uint32_t src, uint32_t dst) const {
+        auto key = MakeKey(src, dst);
+        auto it = m_ledger.find(key);
+        if (it != m_ledger.end() && it->second.movingAvgSnr > 0.0) {
+            return it->second.movingAvgSnr;
+        }
+        return m_defaultSnr;
+    }
+    
+    bool IsBlackhole(uint32_t nodeId) const {
+        // PURE DYNAMIC DETECTION: No hardcoding, only trust-based detection
+        // A node is considered a blackhole if most of its links have low trust (<= m_trustFloor)
+        // Trust decays from 1.0 -> 0.5 -> 0.25 -> m_trustFloor (floor) as packets drop
+        // After 2-3 drops, trust = m_trustFloor, which is at the threshold
+        return nodeId < m_nodeCounts.size() && IsFlagged(m_nodeCounts[nodeId]);
+    }
+    
+    /**
+     * Links of a node and how many of them are at the trust floor
+     */
+    NodeTrustCounts GetNodeTrustCounts(uint32_t nodeId) const {
+        return nodeId < m_nodeCounts.size() ? m_nodeCounts[nodeId] : NodeTrustCounts();
+    }
+    
+    size_t GetNumLinks() const {
+        return m_ledger.size();
+    }
+    
+    /**
+     * Visit every link as fn(nodeA, nodeB, metric) with nodeA < nodeB, in key order
+     */
+    template <class F>
+    void ForEachLink(F&& fn) const {
+        for (const auto& pair : m_ledger) {
+            fn(pair.first.first, pair.first.second, pair.second);
+        }
+    }
+    
+    const std::set<uint32_t>& GetBlackholes() const {
+        return m_blackholes;
+    }
+    
+private:
+    std::map<std::pair<uint32_t, uint32_t>, LinkMetric> m_ledger;
+    std::set<uint32_t> m_blackholes;
+    double m_lossThreshold;
+    double m_defaultTrust;
+    double m_defaultSnr;
+    double m_trustFloor;  // Configurable trust floor for ablation study
+    bool m_trackDirty;    // Distributed mode: record changed entries
+    std::vector<std::pair<uint32_t, uint32_t>> m_dirty;  // Keys changed since the last exchange
+    std::vector<NodeTrustCounts> m_nodeCounts;  // Node ID -> link / low-trust link counts
+    BlackholeCallback m_blackholeCallback;
+    TrustModel m_trustModel;
+    WindowTrustConfig m_window;
+    uint64_t m_windowEnters;
+    uint64_t m_windowExits;
+    
+    std::pair<uint32_t, uint32_t> MakeKey(uint32_t a, uint32_t b) const {
+        return std::make_pair(std::min(a, b), std::max(a, b));
+    }
+    
+    /**
+     * Majority of a node's links at the trust floor (links > 0 and low / links > 0.5)
+     */
+    static bool IsFlagged(const NodeTrustCounts& counts) {
+        return counts.links > 0 && 2 * static_cast<uint64_t>(counts.lowTrustLinks) > counts.links;
+    }
+    
+    /**
+     * Apply a count change to one node and report a flag transition
+     */
+    void AdjustNode(uint32_t nodeId, int32_t deltaLinks, int32_t deltaLow) {
+        NodeTrustCounts& counts = m_nodeCounts[nodeId];
+        bool before = IsFlagged(counts);
+        counts.links += deltaLinks;
+        counts.lowTrustLinks += deltaLow;
+        bool after = IsFlagged(counts);
+        if (before != after && m_blackholeCallback) {
+            m_blackholeCallback(nodeId, after);
+        }
+    }
+    
+    void AdjustLink(const std::pair<uint32_t, uint32_t>& key, int32_t deltaLinks, int32_t deltaLow) {
+        AdjustNode(key.first, deltaLinks, deltaLow);
+        if (key.second != key.first) AdjustNode(key.second, deltaLinks, deltaLow);
+    }
+    
+    /**
+     * Window trust model: apply the hysteresis after a loss (may flag) or a delivery (may clear)
+     * Unflagged links keep their windowed delivery ratio, strictly above the floor.
+     */
+    void UpdateWindowTrust(LinkMetric& metric, bool afterLoss) {
+        const OutcomeHistory& history = metric.history;
+        uint32_t samples = history.GetSamples(m_window.window);
+        double lossRatio = samples > 0 ? static_cast<double>(history.GetLosses(m_window.window)) / samples : 0.0;
+        if (afterLoss && !metric.windowLow) {
+            metric.windowLow = history.GetLossRun() >= m_window.enterLossRun ||
+                               (samples >= m_window.minSamples && lossRatio >= m_window.enterLossRatio);
+            m_windowEnters += metric.windowLow ? 1 : 0;
+        } else if (!afterLoss && metric.windowLow) {
+            metric.windowLow = lossRatio > m_window.exitLossRatio || history.GetDeliveryRun() < m_window.exitDeliveryRun;
+            m_windowExits += metric.windowLow ? 0 : 1;
+        }
+        metric.trust = metric.windowLow ? m_trustFloor : std::max(1.0 - lossRatio, std::nextafter(m_trustFloor, 2.0));
+    }
+    
+    LinkMetric& FindOrAddLink(const std::pair<uint32_t, uint32_t>& key) {
+        auto it = m_ledger.find(key);
+        if (it != m_ledger.end()) {
+            return it->second;
+        }
+        if (key.second >= m_nodeCounts.size()) {
+            m_nodeCounts.resize(key.second + 1);
+        }
+        LinkMetric& metric = m_ledger[key];
+        AdjustLink(key, 1, metric.trust <= m_trustFloor ? 1 : 0);
+        return metric;
+    }
+    
+    void OnTrustChange(const std::pair<uint32_t, uint32_t>& key, double oldTrust, double newTrust) {
+        bool wasLow = oldTrust <= m_trustFloor;
+        bool isLow = newTrust <= m_trustFloor;
+        if (wasLow != isLow) {
+            AdjustLink(key, 0, isLow ? 1 : -1);
+        }
+    }
+};
+
+/**
+ * TrustUpdateBatch: Packet outcomes collected during a heartbeat, applied once per link
+ * Outcomes go into a flat buffer; Apply() orders them by link (keeping the
+ * encounter order within a link) and hands each link's runs to the ledger.
+ */
+class TrustUpdateBatch {
+public:
+    void Add(uint32_t src, uint32_t dst, bool isDrop) {
+        uint64_t link = (static_cast<uint64_t>(std::min(src, dst)) << 32) | std::max(src, dst);
+        m_outcomes.push_back(Outcome{link, static_cast<uint32_t>(m_outcomes.size()), isDrop});
+        m_sorted = false;
+    }
+    
+    size_t GetNumOutcomes() const {
+        return m_outcomes.size();
+    }
+    
+    /**
+     * Distinct links in the batch (what Apply() will return)
+     */
+    size_t CountLinks() {
+        Sort();
+        size_t links = 0;
+        for (size_t i = 0; i < m_outcomes.size(); i++) {
+            if (i == 0 || m_outcomes[i].link != m_outcomes[i - 1].link) links++;
+        }
+        return links;
+    }
+    
+    /**
+     * Apply and clear; returns the number of distinct links updated
+     */
+    size_t Apply(BlockchainLedger& ledger, bool useBlockchain) {
+        Sort();
+        size_t links = 0;
+        for (size_t i = 0; i < m_outcomes.size(); ) {
+            uint64_t link = m_outcomes[i].link;
+            m_runs.clear();
+            for (; i < m_outcomes.size() && m_outcomes[i].link == link; i++) {
+                if (!m_runs.empty() && m_runs.back().isDrop == m_outcomes[i].isDrop) {
+                    m_runs.back().count++;
+                } else {
+                    m_runs.push_back(OutcomeRun{m_outcomes[i].isDrop, 1});
+                }
+            }
+            ledger.ApplyOutcomeRuns(static_cast<uint32_t>(link >> 32), static_cast<uint32_t>(link),
+                                    m_runs.data(), m_runs.size(), useBlockchain);
+            links++;
+        }
+        m_outcomes.clear();
+        return links;
+    }
+    
+private:
+    struct Outcome {
+        uint64_t link;   // (min << 32) | max, the ledger key order
+        uint32_t seq;    // Encounter order
+        bool isDrop;
+    };
+    
+    void Sort() {
+        if (m_sorted) return;
+        std::sort(m_outcomes.begin(), m_outcomes.end(), [](const Outcome& a, const Outcome& b) {
+            return a.link != b.link ? a.link < b.link : a.seq < b.seq;
+        });
+        m_sorted = true;
+    }
+    
+    std::vector<Outcome> m_outcomes;
+    std::vector<OutcomeRun> m_runs;
+    bool m_sorted = true;
+};
+
+/**
+ * NodePosition: Plain position record (decoupled from ns3::Vector for snapshots)
+ */
+struct NodePosition {
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+};
+
+/**
+ * MobilitySnapshot: Node positions sampled once per heartbeat
+ * All topology computations of one heartbeat use the same snapshot instead of
+ * querying every MobilityModel per node pair. The epoch increments per refresh.
+ */
+struct MobilitySnapshot {
+    std::vector<NodePosition> positions;
+    std::vector<uint8_t> valid;   // 0 = node has no MobilityModel
+    uint64_t epoch = 0;
+    double time = 0.0;
+    
+    double Distance(uint32_t a, uint32_t b) const {
+        double dx = positions[a].x - positions[b].x;
+        double dy = positions[a].y - positions[b].y;
+        double dz = positions[a].z - positions[b].z;
+        return std::sqrt(dx*dx + dy*dy + dz*dz);
+    }
+};
+
+/**
+ * ClusterRouter: Two-level (hierarchical) routing over geographic clusters
+ * 
+ * Nodes are grouped into square grid cells of m_cellSize metres; each non-empty
+ * cell is a cluster. Membership is refreshed incrementally (only nodes that
+ * changed cell are moved). Per heartbeat, the flat graph is split into
+ * intra-cluster adjacency and border links ("portals") between clusters.
+ * 
+ * A query first runs Dijkstra on the small cluster graph, then stitches the
+ * node path together with intra-cluster Dijkstra runs from the current entry
+ * node to the cheapest portal into the next cluster. Intra-cluster trees and
+ * cluster-level trees are cached per heartbeat, so per-flow cost depends on
+ * cluster size and cluster count rather than on N.
+ */
+class ClusterRouter {
+public:
+    typedef std::map<uint32_t, std::set<uint32_t>> Graph;
+    typedef std::map<std::pair<uint32_t, uint32_t>, double> Weights;
+    
+    ClusterRouter() : m_cellSize(300.0), m_moves(0), m_portalLinks(0), m_fallbacks(0) {}
+    
+    void SetCellSize(double cellSize) {
+        m_cellSize = cellSize;
+    }
+    
+    double GetCellSize() const {
+        return m_cellSize;
+    }
+    
+    /**
+     * Incremental cluster refresh: move only nodes whose grid cell changed
+     */
+    void UpdateClusters(const MobilitySnapshot& snapshot) {
+        uint32_t numNodes = snapshot.positions.size();
+        if (m_clusterOf.size() != numNodes) {
+            m_clusterOf.assign(numNodes, UINT32_MAX);
+            m_localIndex.assign(numNodes, UINT32_MAX);
+        }
+        for (uint32_t n = 0; n < numNodes; n++) {
+            uint32_t target = UINT32_MAX;
+            if (snapshot.valid[n]) {
+                target = ClusterForCell(CellKey(snapshot.positions[n]));
+            }
+            if (target == m_clusterOf[n]) {
+                continue;
+            }
+            if (m_clusterOf[n] != UINT32_MAX) {
+                RemoveMember(n);
+                m_moves++;
+            }
+            if (target != UINT32_MAX) {
+                Cluster& cluster = m_clusters[target];
+                m_localIndex[n] = cluster.members.size();
+                cluster.members.push_back(n);
+            }
+            m_clusterOf[n] = target;
+        }
+    }
+    
+    /**
+     * Split the flat graph into intra-cluster adjacency and portals, and
+     * recompute per-cluster ledger aggregates. Clears all per-heartbeat caches.
+     */
+    void Rebuild(const Graph& graph, const Weights& weights, const BlockchainLedger& ledger) {
+        m_intraTrees.clear();
+        m_clusterTrees.clear();
+        m_portalLinks = 0;
+        for (Cluster& cluster : m_clusters) {
+            cluster.adj.assign(cluster.members.size(), {});
+            cluster.portals.clear();
+            cluster.trustSum = 0.0;
+            cluster.minTrust = 1.0;
+            cluster.linkCostSum = 0.0;
+            cluster.links = 0;
+        }
+        for (const auto& entry : graph) {
+            uint32_t u = entry.first;
+            uint32_t cu = (u < m_clusterOf.size()) ? m_clusterOf[u] : UINT32_MAX;
+            if (cu == UINT32_MAX) continue;
+            Cluster& cluster = m_clusters[cu];
+            for (uint32_t v : entry.second) {
+                uint32_t cv = (v < m_clusterOf.size()) ? m_clusterOf[v] : UINT32_MAX;
+                if (cv == UINT32_MAX) continue;
+                auto wIt = weights.find(std::make_pair(u, v));
+                if (wIt == weights.end()) continue;
+                double w = wIt->second;
+                if (cu == cv) {
+                    cluster.adj[m_localIndex[u]].push_back(std::make_pair(m_localIndex[v], w));
+                    if (u < v) {
+                        // Per-cluster ledger aggregates (each undirected link once)
+                        double trust = ledger.GetTrust(u, v);
+                        cluster.trustSum += trust;
+                        cluster.minTrust = std::min(cluster.minTrust, trust);
+                        cluster.linkCostSum += w;
+                        cluster.links++;
+                    }
+                } else {
+                    cluster.portals[cv].push_back(Portal{u, v, w});
+                    m_portalLinks++;
+                }
+            }
+        }
+    }
+    
+    /**
+     * Hierarchical path query. Returns an empty path if the two-level search
+     * fails (caller falls back to flat Dijkstra).
+     */
+    std::vector<uint32_t> CalculatePath(uint32_t source, uint32_t dest) {
+        std::vector<uint32_t> path;
+        if (source >= m_clusterOf.size() || dest >= m_clusterOf.size() ||
+            m_clusterOf[source] == UINT32_MAX || m_clusterOf[dest] == UINT32_MAX) {
+            return path;
+        }
+        
+        // 1. Inter-cluster route on the cluster graph
+        std::vector<uint32_t> clusterPath = ClusterPath(m_clusterOf[source], m_clusterOf[dest]);
+        if (clusterPath.empty()) {
+            m_fallbacks++;
+            return path;
+        }
+        
+        // 2. Stitch intra-cluster segments through the cheapest reachable portal
+        uint32_t current = source;
+        path.push_back(source);
+        for (size_t k = 0; k + 1 < clusterPath.size(); k++) {
+            const Cluster& cluster = m_clusters[clusterPath[k]];
+            const IntraTree& tree = GetIntraTree(current);
+            auto portalIt = cluster.portals.find(clusterPath[k + 1]);
+            if (portalIt == cluster.portals.end()) {
+                m_fallbacks++;
+                return std::vector<uint32_t>();
+            }
+            const Portal* best = nullptr;
+            double bestCost = std::numeric_limits<double>::infinity();
+            for (const Portal& portal : portalIt->second) {
+                double cost = tree.dist[m_localIndex[portal.from]] + portal.weight;
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    best = &portal;
+                }
+            }
+            if (!best) {
+                m_fallbacks++;
+                return std::vector<uint32_t>();
+            }
+            AppendIntraPath(cluster, tree, m_localIndex[best->from], path);
+            path.push_back(best->to);
+            current = best->to;
+        }
+        const Cluster& last = m_clusters[clusterPath.back()];
+        const IntraTree& tree = GetIntraTree(current);
+        if (tree.dist[m_localIndex[dest]] == std::numeric_limits<double>::infinity()) {
+            m_fallbacks++;
+            return std::vector<uint32_t>();
+        }
+        AppendIntraPath(last, tree, m_localIndex[dest], path);
+        return path;
+    }
+    
+    uint32_t GetClusterOf(uint32_t nodeId) const {
+        return nodeId < m_clusterOf.size() ? m_clusterOf[nodeId] : UINT32_MAX;
+    }
+    
+    uint32_t GetNumActiveClusters() const {
+        uint32_t active = 0;
+        for (const Cluster& cluster : m_clusters) {
+            if (!cluster.members.empty()) active++;
+        }
+        return active;
+    }
+    
+    /**
+     * Mean trust of intra-cluster links (ledger aggregate, 1.0 if no links)
+     */
+    double GetClusterMeanTrust(uint32_t clusterId) const {
+        const Cluster& cluster = m_clusters[clusterId];
+        return cluster.links > 0 ? cluster.trustSum / cluster.links : 1.0;
+    }
+    
+    double GetClusterMinTrust(uint32_t clusterId) const {
+        return m_clusters[clusterId].minTrust;
+    }
+    
+    uint32_t GetNumClusters() const { return m_clusters.size(); }
+    uint64_t GetMoves() const { return m_moves; }
+    uint64_t GetPortalLinks() const { return m_portalLinks; }
+    uint64_t GetFallbacks() const { return m_fallbacks; }
+    
+private:
+    struct Portal {
+        uint32_t from;    // Border node inside this cluster
+        uint32_t to;      // Border node in the neighbouring cluster
+        double weight;    // Link cost
+    };
+    
+    struct Cluster {
+        std::vector<uint32_t> members;                                   // Local index -> node ID
+        std::vector<std::vector<std::pair<uint32_t, double>>> adj;       // Local adjacency (local index, cost)
+        std::map<uint32_t, std::vector<Portal>> portals;                 // Neighbour cluster -> border links
+        double trustSum = 0.0;      // Ledger aggregate: sum of intra-cluster link trust
+        double minTrust = 1.0;      // Ledger aggregate: weakest intra-cluster link
+        double linkCostSum = 0.0;   // Sum of intra-cluster link costs
+        uint32_t links = 0;         // Intra-cluster undirected links
+        
+        double MeanLinkCost() const {
+            return links > 0 ? linkCostSum / links : 0.0;
+        }
+    };
+    
+    struct IntraTree {
+        std::vector<double> dist;    // Local index -> cost from root
+        std::vector<uint32_t> prev;  // Local index -> predecessor (local index)
+    };
+    
+    struct ClusterTree {
+        std::vector<double> dist;
+        std::vector<uint32_t> prev;
+    };
+    
+    std::pair<int64_t, int64_t> CellKey(const NodePosition& pos) const {
+        return std::make_pair(static_cast<int64_t>(std::floor(pos.x / m_cellSize)),
+                              static_cast<int64_t>(std::floor(pos.y / m_cellSize)));
+    }
+    
+    uint32_t ClusterForCell(const std::pair<int64_t, int64_t>& cell) {
+        auto it = m_cellToCluster.find(cell);
+        if (it != m_cellToCluster.end()) {
+            return it->second;
+        }
+        uint32_t id = m_clusters.size();
+        m_clusters.push_back(Cluster());
+        m_cellToCluster[cell] = id;
+        return id;
+    }
+    
+    void RemoveMember(uint32_t nodeId) {
+        Cluster& cluster = m_clusters[m_clusterOf[nodeId]];
+        uint32_t idx = m_localIndex[nodeId];
+        uint32_t moved = cluster.members.back();
+        cluster.members[idx] = moved;
+        m_localIndex[moved] = idx;
+        cluster.members.pop_back();
+        m_localIndex[nodeId] = UINT32_MAX;
+    }
+    
+    /**
+     * Dijkstra restricted to the root's cluster (cached per heartbeat)
+     */
+    const IntraTree& GetIntraTree(uint32_t root) {
+        auto it = m_intraTrees.find(root);
+        if (it != m_intraTrees.end()) {
+            return it->second;
+        }
+        const Cluster& cluster = m_clusters[m_clusterOf[root]];
+        IntraTree& tree = m_intraTrees[root];
+        uint32_t size = cluster.members.size();
+        tree.dist.assign(size, std::numeric_limits<double>::infinity());
+        tree.prev.assign(size, UINT32_MAX);
+        typedef std::pair<double, uint32_t> QueueEntry;
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+        uint32_t rootIdx = m_localIndex[root];
+        tree.dist[rootIdx] = 0.0;
+        queue.push(std::make_pair(0.0, rootIdx));
+        while (!queue.empty()) {
+            QueueEntry top = queue.top();
+            queue.pop();
+            if (top.first > tree.dist[top.second]) continue;
+            for (const auto& edge : cluster.adj[top.second]) {
+                double alt = top.first + edge.second;
+                if (alt < tree.dist[edge.first]) {
+                    tree.dist[edge.first] = alt;
+                    tree.prev[edge.first] = top.second;
+                    queue.push(std::make_pair(alt, edge.first));
+                }
+            }
+        }
+        return tree;
+    }
+    
+    /**
+     * Append the intra-cluster path root -> target (root already in path)
+     */
+    void AppendIntraPath(const Cluster& cluster, const IntraTree& tree, uint32_t targetIdx,
+                         std::vector<uint32_t>& path) const {
+        size_t insertAt = path.size();
+        for (uint32_t idx = targetIdx; tree.prev[idx] != UINT32_MAX; idx = tree.prev[idx]) {
+            path.push_back(cluster.members[idx]);
+        }
+        std::reverse(path.begin() + insertAt, path.end());
+    }
+    
+    /**
+     * Dijkstra on the cluster graph (cached per source cluster per heartbeat)
+     * Edge cost = cheapest portal link + mean link cost of the entered cluster,
+     * so clusters with low ledger trust (expensive links) are avoided as a whole.
+     */
+    std::vector<uint32_t> ClusterPath(uint32_t from, uint32_t to) {
+        std::vector<uint32_t> clusterPath;
+        auto it = m_clusterTrees.find(from);
+        if (it == m_clusterTrees.end()) {
+            ClusterTree& tree = m_clusterTrees[from];
+            uint32_t numClusters = m_clusters.size();
+            tree.dist.assign(numClusters, std::numeric_limits<double>::infinity());
+            tree.prev.assign(numClusters, UINT32_MAX);
+            typedef std::pair<double, uint32_t> QueueEntry;
+            std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+            tree.dist[from] = 0.0;
+            queue.push(std::make_pair(0.0, from));
+            while (!queue.empty()) {
+                QueueEntry top = queue.top();
+                queue.pop();
+                if (top.first > tree.dist[top.second]) continue;
+                for (const auto& neighbour : m_clusters[top.second].portals) {
+                    double bestPortal = std::numeric_limits<double>::infinity();
+                    for (const Portal& portal : neighbour.second) {
+                        bestPortal = std::min(bestPortal, portal.weight);
+                    }
+                    double alt = top.first + bestPortal + m_clusters[neighbour.first].MeanLinkCost();
+                    if (alt < tree.dist[neighbour.first]) {
+                        tree.dist[neighbour.first] = alt;
+                        tree.prev[neighbour.first] = top.second;
+                        queue.push(std::make_pair(alt, neighbour.first));
+                    }
+                }
+            }
+            it = m_clusterTrees.find(from);
+        }
+        const ClusterTree& tree = it->second;
+        if (tree.dist[to] == std::numeric_limits<double>::infinity()) {
+            return clusterPath;
+        }
+        for (uint32_t c = to; c != UINT32_MAX; c = tree.prev[c]) {
+            clusterPath.push_back(c);
+        }
+        std::reverse(clusterPath.begin(), clusterPath.end());
+        return clusterPath;
+    }
+    
+    double m_cellSize;                                           // Cluster cell edge length (m)
+    std::vector<Cluster> m_clusters;                             // Cluster ID -> cluster
+    std::map<std::pair<int64_t, int64_t>, uint32_t> m_cellToCluster;  // Grid cell -> cluster ID
+    std::vector<uint32_t> m_clusterOf;                           // Node ID -> cluster ID
+    std::vector<uint32_t> m_localIndex;                          // Node ID -> index in cluster members
+    std::unordered_map<uint32_t, IntraTree> m_intraTrees;        // Per-heartbeat intra-cluster trees
+    std::unordered_map<uint32_t, ClusterTree> m_clusterTrees;    // Per-heartbeat cluster-graph trees
+    uint64_t m_moves;                                            // Nodes that changed cluster
+    uint64_t m_portalLinks;                                      // Directed border links (last rebuild)
+    uint64_t m_fallbacks;                                        // Queries that fell back to flat Dijkstra
+};
+
+// ============================================================================
+// Customizable Contraction Hierarchy
+// ============================================================================
+// Between heartbeats the topology changes slowly while the trust and SNR terms
+// of the edge weights change every heartbeat. A customizable contraction
+// hierarchy (CCH) splits route computation the same way: a metric-independent
+// preprocessing step that depends only on which links can exist, a cheap
+// customization step that applies each heartbeat's weights, and queries that
+// scan a few dozen nodes instead of running Dijkstra over the whole graph.
+
+/**
+ * CchRouter: Exact shortest paths over a customizable contraction hierarchy
+ * 
+ * Contraction: nodes are ordered by nested dissection of their positions
+ * (median split along the longer axis; the nodes with a link across the cut
+ * form the separator and rank above both halves), then contracted in that
+ * order, which links every two higher-ranked neighbours of a contracted node
+ * by a shortcut. The hierarchy is built over every node pair within
+ * rangeSlack x maxRange, so links that come into range as nodes move are
+ * usually present already; pairs without a link get infinite weight. It is
+ * rebuilt only when the graph has a link the hierarchy lacks.
+ * 
+ * Customization: every arc takes its link's weight (or infinity), then every
+ * shortcut the cheapest lower triangle, node by node in rank order. The two
+ * halves of a dissection share no arc, so the subtrees below the top
+ * separators are customized on separate threads before the separators.
+ * 
+ * Query: the upward search of source and target only visits their ancestors
+ * in the elimination tree (no priority queue); the cheapest common ancestor
+ * is the meeting node, and its shortcuts are unpacked into the node path.
+ */
+class CchRouter {
+public:
+    typedef std::map<uint32_t, std::set<uint32_t>> Graph;
+    typedef std::map<std::pair<uint32_t, uint32_t>, double> Weights;
+    
+    static constexpr uint32_t kLeafSize = 8;  // Dissection stops below this many nodes
+    
+    CchRouter() : m_rangeSlack(1.2), m_threads(1), m_parallelDepth(0), m_height(0), m_pairs(0),
+                  m_contractions(0), m_customizations(0), m_queries(0), m_contractNs(0.0),
+                  m_customizeNs(0.0) {}
+    
+    /**
+     * Pair range of the hierarchy relative to maxRange, and customization threads
+     */
+    void Configure(double rangeSlack, uint32_t threads) {
+        m_rangeSlack = std::max(rangeSlack, 1.0);
+        m_threads = std::max(threads, 1u);
+        m_parallelDepth = 0;
+        while ((1u << m_parallelDepth) < m_threads) m_parallelDepth++;
+        m_rank.clear();  // Rebuild at the next update
+    }
+    
+    /**
+     * Apply a heartbeat's graph and weights (re-contracting first if the graph has a new link)
+     */
+    void Update(const MobilitySnapshot& snapshot, const Graph& graph, const Weights& weights, double maxRange) {
+        if (!Covers(snapshot.positions.size(), weights)) {
+            auto start = std::chrono::steady_clock::now();
+            Contract(snapshot, graph, maxRange);
+            m_contractNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            m_contractions++;
+        }
+        auto start = std::chrono::steady_clock::now();
+        Customize(weights);
+        m_customizeNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        m_customizations++;
+    }
+    
+    /**
+     * Shortest path source -> dest as node IDs (empty if unreachable)
+     */
+    std::vector<uint32_t> CalculatePath(uint32_t source, uint32_t dest) {
+        std::vector<uint32_t> path;
+        uint32_t n = m_rank.size();
+        if (source >= n || dest >= n) return path;
+        m_queries++;
+        if (source == dest) {
+            path.push_back(source);
+            return path;
+        }
+        const double inf = std::numeric_limits<double>::infinity();
+        
+        // Forward search from the source with upward weights, backward from the target with downward weights
+        std::vector<uint32_t>& chain = m_chain;
+        chain.clear();
+        for (uint32_t x = m_rank[source]; x != UINT32_MAX; x = m_parent[x]) {
+            chain.push_back(x);
+            m_forward[x] = inf;
+        }
+        m_forward[m_rank[source]] = 0.0;
+        for (uint32_t x : chain) {
+            for (uint32_t a = m_upStart[x]; a < m_upStart[x + 1]; a++) {
+                double alt = m_forward[x] + m_upWeight[a];
+                if (alt < m_forward[m_upHead[a]]) {
+                    m_forward[m_upHead[a]] = alt;
+                    m_forwardArc[m_upHead[a]] = a;
+                }
+            }
+        }
+        m_stamp++;
+        for (uint32_t x : chain) m_onChain[x] = m_stamp;
+        chain.clear();
+        for (uint32_t x = m_rank[dest]; x != UINT32_MAX; x = m_parent[x]) {
+            chain.push_back(x);
+            m_backward[x] = inf;
+        }
+        m_backward[m_rank[dest]] = 0.0;
+        uint32_t meet = UINT32_MAX;
+        double best = inf;
+        for (uint32_t x : chain) {
+            if (m_onChain[x] == m_stamp && m_forward[x] + m_backward[x] < best) {
+                best = m_forward[x] + m_backward[x];
+                meet = x;
+            }
+            for (uint32_t a = m_upStart[x]; a < m_upStart[x + 1]; a++) {
+                double alt = m_backward[x] + m_downWeight[a];
+                if (alt < m_backward[m_upHead[a]]) {
+                    m_backward[m_upHead[a]] = alt;
+                    m_backwardArc[m_upHead[a]] = a;
+                }
+            }
+        }
+        if (meet == UINT32_MAX) return path;
+        
+        // Source -> meeting node over upward arcs, then meeting node -> target over downward arcs
+        std::vector<uint32_t>& arcs = m_chain;
+        arcs.clear();
+        for (uint32_t x = meet; x != m_rank[source]; x = m_upTail[m_forwardArc[x]]) {
+            arcs.push_back(m_forwardArc[x]);
+        }
+        path.push_back(source);
+        for (size_t k = arcs.size(); k-- > 0; ) {
+            UnpackUp(arcs[k], path);
+        }
+        for (uint32_t x = meet; x != m_rank[dest]; x = m_upTail[m_backwardArc[x]]) {
+            UnpackDown(m_backwardArc[x], path);
+        }
+        return path;
+    }
+    
+    uint32_t GetNumArcs() const { return m_upHead.size(); }
+    uint64_t GetNumPairs() const { return m_pairs; }          // Node pairs in range of the hierarchy (original arcs)
+    uint32_t GetHeight() const { return m_height; }           // Longest elimination-tree chain (query scan bound)
+    uint64_t GetContractions() const { return m_contractions; }
+    uint64_t GetCustomizations() const { return m_customizations; }
+    uint64_t GetQueries() const { return m_queries; }
+    double GetContractNs() const { return m_contractNs; }
+    double GetCustomizeNs() const { return m_customizeNs; }
+    uint32_t GetThreads() const { return m_threads; }
+    
+private:
+    /**
+     * True if every link of the graph has an arc (and the node count is unchanged)
+     */
+    bool Covers(uint32_t numNodes, const Weights& weights) const {
+        if (m_rank.size() != numNodes) return false;
+        for (const auto& edge : weights) {
+            uint32_t from = m_rank[edge.first.first];
+            uint32_t to = m_rank[edge.first.second];
+            if (from < to && FindArc(from, to) == UINT32_MAX) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    /**
+     * Arc between two ranks lo < hi (UINT32_MAX if the hierarchy has none)
+     */
+    uint32_t FindArc(uint32_t lo, uint32_t hi) const {
+        auto begin = m_upHead.begin() + m_upStart[lo];
+        auto end = m_upHead.begin() + m_upStart[lo + 1];
+        auto it = std::lower_bound(begin, end, hi);
+        return (it != end && *it == hi) ? static_cast<uint32_t>(it - m_upHead.begin()) : UINT32_MAX;
+    }
+    
+    /**
+     * Metric-independent preprocessing: nested dissection order and symbolic contraction
+     */
+    void Contract(const MobilitySnapshot& snapshot, const Graph& graph, double maxRange) {
+        uint32_t n = snapshot.positions.size();
+        
+        // Node pairs the hierarchy covers: within the slack range (uniform grid), plus all current links
+        double range = maxRange * m_rangeSlack;
+        std::vector<std::vector<uint32_t>> adj(n);
+        std::unordered_map<uint64_t, std::vector<uint32_t>> grid;
+        auto cellKey = [range](const NodePosition& pos, int32_t dx, int32_t dy) {
+            int32_t cx = static_cast<int32_t>(std::floor(pos.x / range)) + dx;
+            int32_t cy = static_cast<int32_t>(std::floor(pos.y / range)) + dy;
+            return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+        };
+        for (uint32_t i = 0; i < n; i++) {
+            if (snapshot.valid[i]) grid[cellKey(snapshot.positions[i], 0, 0)].push_back(i);
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (!snapshot.valid[i]) continue;
+            for (int32_t dx = -1; dx <= 1; dx++) {
+                for (int32_t dy = -1; dy <= 1; dy++) {
+                    auto it = grid.find(cellKey(snapshot.positions[i], dx, dy));
+                    if (it == grid.end()) continue;
+                    for (uint32_t j : it->second) {
+                        if (j != i && snapshot.Distance(i, j) < range) adj[i].push_back(j);
+                    }
+                }
+            }
+        }
+        for (const auto& entry : graph) {
+            for (uint32_t v : entry.second) {
+                if (entry.first < n && v < n) adj[entry.first].push_back(v);
+            }
+        }
+        m_pairs = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            std::sort(adj[i].begin(), adj[i].end());
+            adj[i].erase(std::unique(adj[i].begin(), adj[i].end()), adj[i].end());
+            m_pairs += adj[i].size();
+        }
+        m_pairs /= 2;
+        
+        // Nested dissection order
+        m_rank.assign(n, UINT32_MAX);
+        m_part.assign(n, 0);
+        m_partStamp = 0;
+        m_parallelRanges.clear();
+        m_sequentialRanges.clear();
+        std::vector<uint32_t> nodes(n);
+        for (uint32_t i = 0; i < n; i++) nodes[i] = i;
+        Dissect(snapshot, adj, nodes, 0, 0);
+        std::sort(m_sequentialRanges.begin(), m_sequentialRanges.end());
+        m_nodeAt.assign(n, 0);
+        for (uint32_t i = 0; i < n; i++) m_nodeAt[m_rank[i]] = i;
+        
+        // Symbolic contraction in rank order: the upward neighbours of a node, minus its
+        // lowest one (the elimination-tree parent), become upward neighbours of the parent
+        std::vector<std::vector<uint32_t>> up(n);
+        for (uint32_t i = 0; i < n; i++) {
+            for (uint32_t j : adj[i]) {
+                if (m_rank[i] < m_rank[j]) up[m_rank[i]].push_back(m_rank[j]);
+            }
+        }
+        m_parent.assign(n, UINT32_MAX);
+        for (uint32_t x = 0; x < n; x++) {
+            std::sort(up[x].begin(), up[x].end());
+            up[x].erase(std::unique(up[x].begin(), up[x].end()), up[x].end());
+            if (up[x].empty()) continue;
+            m_parent[x] = up[x].front();
+            up[m_parent[x]].insert(up[m_parent[x]].end(), up[x].begin() + 1, up[x].end());
+        }
+        
+        // Arcs in CSR form, upward from each rank, plus the downward lists customization pulls from
+        m_upStart.assign(n + 1, 0);
+        for (uint32_t x = 0; x < n; x++) m_upStart[x + 1] = m_upStart[x] + up[x].size();
+        uint32_t numArcs = m_upStart[n];
+        m_upHead.resize(numArcs);
+        m_upTail.resize(numArcs);
+        m_downStart.assign(n + 1, 0);
+        for (uint32_t x = 0; x < n; x++) {
+            std::copy(up[x].begin(), up[x].end(), m_upHead.begin() + m_upStart[x]);
+            std::fill(m_upTail.begin() + m_upStart[x], m_upTail.begin() + m_upStart[x + 1], x);
+            for (uint32_t y : up[x]) m_downStart[y + 1]++;
+        }
+        for (uint32_t x = 0; x < n; x++) m_downStart[x + 1] += m_downStart[x];
+        m_downArc.resize(numArcs);
+        std::vector<uint32_t> fill(m_downStart.begin(), m_downStart.end() - 1);
+        for (uint32_t a = 0; a < numArcs; a++) {
+            m_downArc[fill[m_upHead[a]]++] = a;  // Ascending tail rank per head
+        }
+        m_upWeight.assign(numArcs, 0.0);
+        m_downWeight.assign(numArcs, 0.0);
+        m_upVia.assign(numArcs, UINT32_MAX);
+        m_downVia.assign(numArcs, UINT32_MAX);
+        
+        m_height = 0;
+        std::vector<uint32_t> depth(n, 1);
+        for (uint32_t x = n; x-- > 0; ) {
+            if (m_parent[x] != UINT32_MAX) depth[x] = depth[m_parent[x]] + 1;
+            m_height = std::max(m_height, depth[x]);
+        }
+        m_forward.assign(n, 0.0);
+        m_backward.assign(n, 0.0);
+        m_forwardArc.assign(n, UINT32_MAX);
+        m_backwardArc.assign(n, UINT32_MAX);
+        m_onChain.assign(n, 0);
+        m_stamp = 0;
+    }
+    
+    /**
+     * Rank nodes [lo, lo + nodes.size()) by recursive coordinate bisection
+     * Subproblems at the parallel depth are recorded as independent rank ranges;
+     * separators above it are customized sequentially afterwards.
+     */
+    void Dissect(const MobilitySnapshot& snapshot, const std::vector<std::vector<uint32_t>>& adj,
+                 std::vector<uint32_t>& nodes, uint32_t lo, uint32_t depth) {
+        uint32_t size = nodes.size();
+        if (depth == m_parallelDepth && size > 0) {
+            m_parallelRanges.push_back(std::make_pair(lo, lo + size));
+        }
+        if (size <= kLeafSize) {
+            for (uint32_t k = 0; k < size; k++) m_rank[nodes[k]] = lo + k;
+            if (depth < m_parallelDepth && size > 0) {
+                m_parallelRanges.push_back(std::make_pair(lo, lo + size));
+            }
+            return;
+        }
+        
+        double minX = std::numeric_limits<double>::infinity(), maxX = -minX;
+        double minY = minX, maxY = -minX;
+        for (uint32_t v : nodes) {
+            const NodePosition& pos = snapshot.positions[v];
+            minX = std::min(minX, pos.x);
+            maxX = std::max(maxX, pos.x);
+            minY = std::min(minY, pos.y);
+            maxY = std::max(maxY, pos.y);
+        }
+        bool splitX = (maxX - minX) >= (maxY - minY);
+        auto mid = nodes.begin() + size / 2;
+        std::nth_element(nodes.begin(), mid, nodes.end(), [&](uint32_t a, uint32_t b) {
+            double ka = splitX ? snapshot.positions[a].x : snapshot.positions[a].y;
+            double kb = splitX ? snapshot.positions[b].x : snapshot.positions[b].y;
+            return ka < kb || (ka == kb && a < b);
+        });
+        
+        // Separator: the boundary nodes of the side with the smaller boundary
+        uint32_t leftPart = ++m_partStamp;
+        uint32_t rightPart = ++m_partStamp;
+        for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+            m_part[*it] = it < mid ? leftPart : rightPart;
+        }
+        std::vector<uint32_t> left, right, leftBoundary, rightBoundary;
+        for (auto it = nodes.begin(); it != nodes.end(); ++it) {
+            uint32_t v = *it;
+            uint32_t other = it < mid ? rightPart : leftPart;
+            bool boundary = std::any_of(adj[v].begin(), adj[v].end(), [&](uint32_t w) { return m_part[w] == other; });
+            (it < mid ? (boundary ? leftBoundary : left) : (boundary ? rightBoundary : right)).push_back(v);
+        }
+        std::vector<uint32_t>* separator = &leftBoundary;
+        if (rightBoundary.size() < leftBoundary.size()) {
+            separator = &rightBoundary;
+            left.insert(left.end(), leftBoundary.begin(), leftBoundary.end());
+        } else {
+            right.insert(right.end(), rightBoundary.begin(), rightBoundary.end());
+        }
+        
+        uint32_t sepLo = lo + left.size() + right.size();
+        std::sort(separator->begin(), separator->end());
+        for (uint32_t k = 0; k < separator->size(); k++) m_rank[(*separator)[k]] = sepLo + k;
+        if (depth < m_parallelDepth && !separator->empty()) {
+            m_sequentialRanges.push_back(std::make_pair(sepLo, lo + size));
+        }
+        uint32_t leftSize = left.size();
+        nodes.clear();
+        nodes.shrink_to_fit();
+        Dissect(snapshot, adj, left, lo, depth + 1);
+        Dissect(snapshot, adj, right, lo + leftSize, depth + 1);
+    }
+    
+    /**
+     * Metric-dependent step: link weights into the arcs, then the lower triangles in rank order
+     */
+    void Customize(const Weights& weights) {
+        const double inf = std::numeric_limits<double>::infinity();
+        std::fill(m_upWeight.begin(), m_upWeight.end(), inf);
+        std::fill(m_downWeight.begin(), m_downWeight.end(), inf);
+        std::fill(m_upVia.begin(), m_upVia.end(), UINT32_MAX);
+        std::fill(m_downVia.begin(), m_downVia.end(), UINT32_MAX);
+        for (const auto& edge : weights) {
+            uint32_t from = m_rank[edge.first.first];
+            uint32_t to = m_rank[edge.first.second];
+            if (from < to) {
+                m_upWeight[FindArc(from, to)] = edge.second;
+            } else {
+                m_downWeight[FindArc(to, from)] = edge.second;
+            }
+        }
+        
+        uint32_t n = m_rank.size();
+        if (m_threads > 1 && m_parallelRanges.size() > 1) {
+            // Independent subtrees: thread t takes every m_threads-th range
+            std::vector<std::thread> workers;
+            for (uint32_t t = 1; t < m_threads; t++) {
+                workers.emplace_back([this, t, n]() {
+                    std::vector<uint32_t> slot(n);
+                    for (size_t r = t; r < m_parallelRanges.size(); r += m_threads) {
+                        CustomizeRange(m_parallelRanges[r].first, m_parallelRanges[r].second, slot);
+                    }
+                });
+            }
+            m_slot.resize(n);
+            for (size_t r = 0; r < m_parallelRanges.size(); r += m_threads) {
+                CustomizeRange(m_parallelRanges[r].first, m_parallelRanges[r].second, m_slot);
+            }
+            for (std::thread& worker : workers) worker.join();
+        } else {
+            m_slot.resize(n);
+            for (const auto& range : m_parallelRanges) {
+                CustomizeRange(range.first, range.second, m_slot);
+            }
+        }
+        for (const auto& range : m_sequentialRanges) {
+            CustomizeRange(range.first, range.second, m_slot);
+        }
+    }
+    
+    /**
+     * Finalize the upward arcs of ranks [lo, hi) from their lower triangles
+     * Triangle u < x < y: x -> u -> y can shorten x -> y, and y -> u -> x can shorten y -> x.
+     */
+    void CustomizeRange(uint32_t lo, uint32_t hi, std::vector<uint32_t>& slot) {
+        for (uint32_t x = lo; x < hi; x++) {
+            for (uint32_t a = m_upStart[x]; a < m_upStart[x + 1]; a++) {
+                slot[m_upHead[a]] = a;
+            }
+            for (uint32_t k = m_downStart[x]; k < m_downStart[x + 1]; k++) {
+                uint32_t ux = m_downArc[k];
+                uint32_t u = m_upTail[ux];
+                // Arcs of u above x follow u -> x in u's sorted list
+                for (uint32_t uy = ux + 1; uy < m_upStart[u + 1]; uy++) {
+                    uint32_t xy = slot[m_upHead[uy]];
+                    double up = m_downWeight[ux] + m_upWeight[uy];
+                    if (up < m_upWeight[xy]) {
+                        m_upWeight[xy] = up;
+                        m_upVia[xy] = u;
+                    }
+                    double down = m_downWeight[uy] + m_upWeight[ux];
+                    if (down < m_downWeight[xy]) {
+                        m_downWeight[xy] = down;
+                        m_downVia[xy] = u;
+                    }
+                }
+            }
+        }
+    }
+    
+    /**
+     * Append the nodes after the tail of arc a traversed upward (tail -> head)
+     */
+    void UnpackUp(uint32_t a, std::vector<uint32_t>& path) const {
+        uint32_t u = m_upVia[a];
+        if (u != UINT32_MAX) {
+            UnpackDown(FindArc(u, m_upTail[a]), path);
+            UnpackUp(FindArc(u, m_upHead[a]), path);
+            return;
+        }
+        path.push_back(m_nodeAt[m_upHead[a]]);
+    }
+    
+    /**
+     * Append the nodes after the head of arc a traversed downward (head -> tail)
+     */
+    void UnpackDown(uint32_t a, std::vector<uint32_t>& path) const {
+        uint32_t u = m_downVia[a];
+        if (u != UINT32_MAX) {
+            UnpackDown(FindArc(u, m_upHead[a]), path);
+            UnpackUp(FindArc(u, m_upTail[a]), path);
+            return;
+        }
+        path.push_back(m_nodeAt[m_upTail[a]]);
+    }
+    
+    double m_rangeSlack;       // Hierarchy pair range / maxRange
+    uint32_t m_threads;        // Customization threads
+    uint32_t m_parallelDepth;  // Dissection depth whose subtrees are customized in parallel
+    std::vector<uint32_t> m_rank;     // Node ID -> rank (empty until the first contraction)
+    std::vector<uint32_t> m_nodeAt;   // Rank -> node ID
+    std::vector<uint32_t> m_parent;   // Rank -> elimination-tree parent (lowest upward neighbour)
+    std::vector<uint32_t> m_upStart;  // Rank -> first upward arc (CSR, one extra end entry)
+    std::vector<uint32_t> m_upHead;   // Arc -> higher rank (ascending per tail)
+    std::vector<uint32_t> m_upTail;   // Arc -> lower rank
+    std::vector<uint32_t> m_downStart;  // Rank -> first entry of m_downArc
+    std::vector<uint32_t> m_downArc;    // Arcs by head rank (lower triangles pulled by customization)
+    std::vector<double> m_upWeight;     // Arc -> cost tail -> head
+    std::vector<double> m_downWeight;   // Arc -> cost head -> tail
+    std::vector<uint32_t> m_upVia;      // Arc -> middle rank of the upward shortcut (UINT32_MAX = link)
+    std::vector<uint32_t> m_downVia;    // Arc -> middle rank of the downward shortcut
+    std::vector<std::pair<uint32_t, uint32_t>> m_parallelRanges;    // Independent rank ranges
+    std::vector<std::pair<uint32_t, uint32_t>> m_sequentialRanges;  // Top separators, ascending
+    std::vector<uint32_t> m_part;     // Dissection scratch: node -> side stamp
+    uint32_t m_partStamp;
+    std::vector<uint32_t> m_slot;     // Customization scratch: head rank -> arc of the current node
+    std::vector<double> m_forward;    // Query scratch (rank-indexed, reset along the chains)
+    std::vector<double> m_backward;
+    std::vector<uint32_t> m_forwardArc;
+    std::vector<uint32_t> m_backwardArc;
+    std::vector<uint64_t> m_onChain;
+    uint64_t m_stamp;
+    std::vector<uint32_t> m_chain;
+    uint32_t m_height;
+    uint64_t m_pairs;
+    uint64_t m_contractions;    // Metric-independent rebuilds
+    uint64_t m_customizations;  // Weight updates (one per BuildGraph)
+    uint64_t m_queries;
+    double m_contractNs;
+    double m_customizeNs;
+};
+
+// ============================================================================
+// Channel Assignment (Conflict Graph Colouring)
+// ============================================================================
+// With several orthogonal channels and one radio per channel on every node,
+// each link of the routing graph is given the channel it transmits on. Two
+// links conflict when they share a node or an endpoint of one is a neighbour
+// of an endpoint of the other (two-hop interference on the routing graph);
+// conflicting links on the same channel contend for airtime.
+
+/**
+ * ChannelAssigner: Greedy, incremental colouring of the link conflict graph
+ * New links are coloured in decreasing order of conflict degree, each taking
+ * the channel with the fewest conflicting links already on it (ties: the least
+ * used channel, then the lowest index). Existing links next to a new link move
+ * only if that strictly lowers their same-channel conflicts, and removed links
+ * free their channel without touching the others, so assignments stay stable
+ * while the topology changes gradually. Per-channel conflict counts are kept
+ * per link and adjusted around each change, so an update costs work in the
+ * two-hop neighbourhood of the changed links only.
+ */
+class ChannelAssigner {
+public:
+    typedef std::map<uint32_t, std::set<uint32_t>> Graph;
+    typedef std::pair<uint32_t, uint32_t> Link;  // (min, max) node IDs
+    
+    ChannelAssigner() : m_numChannels(1), m_load(1, 0), m_refreshed(0), m_recoloured(0), m_updates(0) {}
+    
+    /**
+     * Set the channel count and drop all assignments
+     */
+    void SetNumChannels(uint32_t numChannels) {
+        m_numChannels = std::max(numChannels, 1u);
+        m_links.clear();
+        m_load.assign(m_numChannels, 0);
+    }
+    
+    uint32_t GetNumChannels() const {
+        return m_numChannels;
+    }
+    
+    /**
+     * Follow the graph's link changes; returns the links (re)coloured
+     */
+    uint32_t Update(const Graph& graph) {
+        m_changedNodes.clear();
+        for (auto it = m_links.begin(); it != m_links.end();) {
+            if (!HasLink(graph, it->first)) {
+                Link removed = it->first;
+                uint32_t channel = it->second.channel;
+                m_load[channel]--;
+                it = m_links.erase(it);
+                AdjustAround(graph, removed, channel, -1);
+                m_changedNodes.push_back(removed.first);
+                m_changedNodes.push_back(removed.second);
+            } else {
+                ++it;
+            }
+        }
+        
+        std::vector<std::pair<size_t, Link>> added;
+        for (const auto& node : graph) {
+            for (uint32_t v : node.second) {
+                if (node.first < v && m_links.find(Link(node.first, v)) == m_links.end()) {
+                    Conflicts(graph, Link(node.first, v), m_scratch);
+                    added.push_back({m_scratch.size(), Link(node.first, v)});
+                }
+            }
+        }
+        if (added.empty() && m_changedNodes.empty()) {
+            return 0;
+        }
+        m_updates++;
+        std::sort(added.begin(), added.end(), [](const std::pair<size_t, Link>& a, const std::pair<size_t, Link>& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+        
+        uint32_t recoloured = 0;
+        m_touched.clear();
+        for (const auto& entry : added) {
+            Conflicts(graph, entry.second, m_scratch);
+            uint32_t channel = BestChannel(m_scratch);
+            m_links[entry.second] = LinkState{channel, std::vector<uint32_t>(m_numChannels, 0)};
+            m_load[channel]++;
+            m_touched.insert(m_touched.end(), m_scratch.begin(), m_scratch.end());
+            AdjustAround(graph, entry.second, channel, +1);
+            m_changedNodes.push_back(entry.second.first);
+            m_changedNodes.push_back(entry.second.second);
+            recoloured++;
+        }
+        
+        // Links at a node that gained or lost a neighbour have a new conflict
+        // set; recount them. Every other link's set only gained or lost the
+        // changed links themselves, which AdjustAround already counted.
+        std::sort(m_changedNodes.begin(), m_changedNodes.end());
+        m_changedNodes.erase(std::unique(m_changedNodes.begin(), m_changedNodes.end()), m_changedNodes.end());
+        m_recount.clear();
+        for (uint32_t node : m_changedNodes) {
+            AddLinksOf(graph, node, m_recount);
+        }
+        std::sort(m_recount.begin(), m_recount.end());
+        m_recount.erase(std::unique(m_recount.begin(), m_recount.end()), m_recount.end());
+        for (const Link& link : m_recount) {
+            LinkState& state = m_links[link];
+            Conflicts(graph, link, m_scratch);
+            std::fill(state.conflicts.begin(), state.conflicts.end(), 0);
+            for (const Link& other : m_scratch) {
+                auto it = m_links.find(other);
+                if (it != m_links.end()) state.conflicts[it->second.channel]++;
+            }
+        }
+        m_refreshed += m_recount.size();
+        
+        // Repair pass over the existing links that gained a conflicting link
+        std::sort(m_touched.begin(), m_touched.end());
+        m_touched.erase(std::unique(m_touched.begin(), m_touched.end()), m_touched.end());
+        for (const Link& link : m_touched) {
+            auto it = m_links.find(link);
+            if (it == m_links.end()) continue;
+            uint32_t current = it->second.channel;
+            uint32_t channel = BestChannel(it->second.conflicts, current);
+            if (channel != current) {
+                m_load[current]--;
+                m_load[channel]++;
+                it->second.channel = channel;
+                AdjustAround(graph, link, current, -1);
+                AdjustAround(graph, link, channel, +1);
+                recoloured++;
+            }
+        }
+        m_recoloured += recoloured;
+        return recoloured;
+    }
+    
+    /**
+     * Channel of a link (0 if the link is not in the graph)
+     */
+    uint32_t GetChannel(uint32_t a, uint32_t b) const {
+        auto it = m_links.find(Link(std::min(a, b), std::max(a, b)));
+        return it != m_links.end() ? it->second.channel : 0;
+    }
+    
+    /**
+     * Conflicting links sharing the link's channel
+     */
+    uint32_t GetSameChannelConflicts(uint32_t a, uint32_t b) const {
+        auto it = m_links.find(Link(std::min(a, b), std::max(a, b)));
+        return it != m_links.end() ? it->second.conflicts[it->second.channel] : 0;
+    }
+    
+    /**
+     * Sum over links of (same-channel, all) conflicting links
+     */
+    std::pair<uint64_t, uint64_t> GetConflictTotals() const {
+        std::pair<uint64_t, uint64_t> totals(0, 0);
+        for (const auto& entry : m_links) {
+            totals.first += entry.second.conflicts[entry.second.channel];
+            for (uint32_t count : entry.second.conflicts) totals.second += count;
+        }
+        return totals;
+    }
+    
+    size_t GetNumLinks() const { return m_links.size(); }
+    const std::vector<uint32_t>& GetLoad() const { return m_load; }
+    uint64_t GetRecoloured() const { return m_recoloured; }
+    uint64_t GetRefreshed() const { return m_refreshed; }
+    uint64_t GetUpdates() const { return m_updates; }
+    
+private:
+    struct LinkState {
+        uint32_t channel;
+        std::vector<uint32_t> conflicts;  // Channel -> conflicting links on it
+    };
+    
+    static bool HasLink(const Graph& graph, const Link& link) {
+        auto it = graph.find(link.first);
+        return it != graph.end() && it->second.count(link.second) > 0;
+    }
+    
+    /**
+     * Links conflicting with link (sorted, without the link itself)
+     */
+    static void Conflicts(const Graph& graph, const Link& link, std::vector<Link>& out) {
+        out.clear();
+        for (uint32_t x : {link.first, link.second}) {
+            auto it = graph.find(x);
+            if (it == graph.end()) continue;
+            // Links of x itself and of every neighbour of x
+            AddLinksOf(graph, x, out);
+            for (uint32_t y : it->second) {
+                AddLinksOf(graph, y, out);
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        out.erase(std::remove(out.begin(), out.end(), link), out.end());
+    }
+    
+    /**
+     * Count a link appearing (+1) on or leaving (-1) a channel in the
+     * per-channel counts of every link conflicting with it
+     * Conflicts are links with an endpoint in the closed neighbourhoods of the
+     * link's endpoints. Those neighbourhoods are the same with and without the
+     * link, so this also finds the conflicts of a removed link.
+     */
+    void AdjustAround(const Graph& graph, const Link& link, uint32_t channel, int32_t delta) {
+        Conflicts(graph, link, m_adjust);
+        for (const Link& other : m_adjust) {
+            auto it = m_links.find(other);
+            if (it != m_links.end()) it->second.conflicts[channel] += delta;
+        }
+    }
+    
+    static void AddLinksOf(const Graph& graph, uint32_t node, std::vector<Link>& out) {
+        auto it = graph.find(node);
+        if (it == graph.end()) return;
+        for (uint32_t v : it->second) {
+            out.push_back(Link(std::min(node, v), std::max(node, v)));
+        }
+    }
+    
+    /**
+     * Channel for a new link with these conflicting links
+     */
+    uint32_t BestChannel(const std::vector<Link>& conflicts) {
+        m_count.assign(m_numChannels, 0);
+        for (const Link& other : conflicts) {
+            auto it = m_links.find(other);
+            if (it != m_links.end()) m_count[it->second.channel]++;
+        }
+        return BestChannel(m_count, UINT32_MAX);
+    }
+    
+    /**
+     * Channel with the fewest conflicting links on it (keeps current on a tie)
+     */
+    uint32_t BestChannel(const std::vector<uint32_t>& count, uint32_t current) const {
+        uint32_t best = 0;
+        for (uint32_t c = 1; c < m_numChannels; c++) {
+            if (count[c] < count[best] || (count[c] == count[best] && m_load[c] < m_load[best])) best = c;
+        }
+        if (current != UINT32_MAX && count[current] == count[best]) {
+            return current;
+        }
+        return best;
+    }
+    
+    uint32_t m_numChannels;
+    std::map<Link, LinkState> m_links;  // Link -> channel and conflict counts
+    std::vector<uint32_t> m_load;       // Channel -> links assigned
+    std::vector<Link> m_scratch;
+    std::vector<Link> m_adjust;         // AdjustAround scratch
+    std::vector<Link> m_touched;        // Existing links next to a new link (repair candidates)
+    std::vector<Link> m_recount;        // Links at a node whose neighbourhood changed
+    std::vector<uint32_t> m_changedNodes;
+    std::vector<uint32_t> m_count;      // BestChannel scratch: channel -> conflicting links on it
+    uint64_t m_refreshed;               // Links whose conflict counts were recomputed, over all updates
+    uint64_t m_recoloured;              // Links (re)coloured over all updates
+    uint64_t m_updates;                 // Updates with a topology change
+};
+
+// ============================================================================
+// Expected Transmission Time (ETT) Link Cost
+// ============================================================================
+// ETT = ETX * S / B: the expected airtime to get one S-byte packet across a
+// link. B is the fastest 802.11a rate the link's SNR supports and ETX is the
+// inverse of the ledger's delivery ratio. Summed along a path, ETT favours
+// fewer slow hops over many fast ones only when that is actually faster.
+
+enum class LinkCostMode {
+    Snr,    // Normalised quadratic SNR penalty (alpha term), hop count without trust
+    Ett     // Expected transmission time in microseconds (alpha term), ETT alone without trust
+};
+
+inline bool ParseLinkCostMode(const std::string& name, LinkCostMode& mode) {
+    if (name == "snr") {
+        mode = LinkCostMode::Snr;
+    } else if (name == "ett") {
+        mode = LinkCostMode::Ett;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline const char* LinkCostModeName(LinkCostMode mode) {
+    return mode == LinkCostMode::Ett ? "ett" : "snr";
+}
+
+/**
+ * PhyRateTable: Best 802.11a rate per SNR, precomputed in 0.25 dB bins
+ */
+class PhyRateTable {
+public:
+    static constexpr double kBinDb = 0.25;
+    static constexpr size_t kBins = 161;  // 0 dB .. 40 dB
+    
+    static const PhyRateTable& Get() {
+        static const PhyRateTable table;
+        return table;
+    }
+    
+    /**
+     * Highest rate whose minimum SNR is met (the 6 Mb/s base rate below that)
+     */
+    double GetRateBps(double snrDb) const {
+        if (!(snrDb > 0.0)) return m_rateBps[0];
+        return m_rateBps[std::min<size_t>(static_cast<size_t>(snrDb / kBinDb), kBins - 1)];
+    }
+    
+private:
+    PhyRateTable() {
+        // Minimum SNR (dB) per 802.11a OFDM rate for ~10% PER on 1000-byte frames
+        static const std::pair<double, double> kRates[] = {
+            {6.0, 6e6}, {7.8, 9e6}, {9.0, 12e6}, {10.8, 18e6},
+            {17.0, 24e6}, {18.8, 36e6}, {24.0, 48e6}, {24.6, 54e6}};
+        for (size_t b = 0; b < kBins; b++) {
+            double snrDb = b * kBinDb;
+            m_rateBps[b] = kRates[0].second;
+            for (const auto& rate : kRates) {
+                if (snrDb >= rate.first) m_rateBps[b] = rate.second;
+            }
+        }
+    }
+    
+    std::array<double, kBins> m_rateBps;
+};
+
+/**
+ * RoutingEngine: Implements Dijkstra's algorithm for route calculation
+ */
+class RoutingEngine {
+public:
+    RoutingEngine(double alpha = 1.0, double beta = 500.0) 
+        : m_alpha(alpha), m_beta(beta), m_useBlockchain(true), m_costMode(LinkCostMode::Snr),
+          m_packetBits(8192.0), m_hierarchical(false), m_contracted(false), m_partitionOf(nullptr), m_portalPairs(nullptr),
+          m_channels(nullptr), m_channelContention(0.0) {}
+    
+    void SetUseBlockchain(bool useBlockchain) {
+        m_useBlockchain = useBlockchain;
+    }
+    
+    void SetBeta(double beta) {
+        m_beta = beta;
+    }
+    
+    double GetBeta() const {
+        return m_beta;
+    }
+    
+    double GetAlpha() const {
+        return m_alpha;
+    }
+    
+    /**
+     * Link quality term: SNR penalty or ETT for packets of packetBytes
+     */
+    void SetLinkCost(LinkCostMode mode, uint32_t packetBytes) {
+        m_costMode = mode;
+        m_packetBits = 8.0 * std::max(packetBytes, 1u);
+    }
+    
+    LinkCostMode GetLinkCostMode() const {
+        return m_costMode;
+    }
+    
+    /**
+     * ETT in microseconds (ETX capped at 10 so a link with no deliveries stays usable)
+     */
+    double EttMicroseconds(double snrDb, double deliveryRatio) const {
+        double etx = 1.0 / std::max(deliveryRatio, 0.1);
+        return etx * m_packetBits / PhyRateTable::Get().GetRateBps(snrDb) * 1e6;
+    }
+    
+    /**
+     * Multi-channel mode: BuildGraph recolours the links and scales each edge weight by
+     * 1 + contention x (conflicting links on the same channel); nullptr disables it
+     */
+    void SetChannelAssigner(ChannelAssigner* channels, double contention) {
+        m_channels = channels;
+        m_channelContention = contention;
+    }
+    
+    /**
+     * Enable two-level cluster routing (cellSize = cluster edge length in metres)
+     */
+    void SetHierarchical(bool hierarchical, double cellSize) {
+        m_hierarchical = hierarchical;
+        m_clusterRouter.SetCellSize(cellSize);
+    }
+    
+    bool IsHierarchical() const {
+        return m_hierarchical;
+    }
+    
+    const ClusterRouter& GetClusterRouter() const {
+        return m_clusterRouter;
+    }
+    
+    /**
+     * Route over a customizable contraction hierarchy covering pairs within
+     * rangeSlack x maxRange, customized on the given number of threads
+     */
+    void SetContractionHierarchy(bool contracted, double rangeSlack, uint32_t threads) {
+        m_contracted = contracted;
+        m_cchRouter.Configure(rangeSlack, threads);
+    }
+    
+    bool IsContracted() const {
+        return m_contracted;
+    }
+    
+    const CchRouter& GetCchRouter() const {
+        return m_cchRouter;
+    }
+    
+    /**
+     * Distributed mode: links between different partitions only exist as portal links
+     * (portalPairs holds (min, max) node pairs); nullptr disables the filter
+     */
+    void SetPartitions(const std::vector<uint32_t>* partitionOf,
+                       const std::set<std::pair<uint32_t, uint32_t>>* portalPairs) {
+        m_partitionOf = partitionOf;
+        m_portalPairs = portalPairs;
+    }
+    
+    /**
+     * Neighbours of a node in the current graph (nullptr if the node has no links)
+     */
+    const std::set<uint32_t>* GetNeighbors(uint32_t nodeId) const {
+        auto it = m_graph.find(nodeId);
+        return (it != m_graph.end()) ? &it->second : nullptr;
+    }
+    
+    /**
+     * Adjacency of the current graph (nodes without links are absent)
+     */
+    const std::map<uint32_t, std::set<uint32_t>>& GetGraph() const {
+        return m_graph;
+    }
+    
+    /**
+     * Directed edge costs of the current graph (both directions of every link)
+     */
+    const std::map<std::pair<uint32_t, uint32_t>, double>& GetWeights() const {
+        return m_weights;
+    }
+    
+    /**
+     * Build graph from topology using physical positions
+     * Implements Topology Discovery Logic
+     * 
+     * Candidate neighbours come from a uniform grid with cell = maxRange, so only
+     * nodes in the 3x3 surrounding cells are distance-tested. Candidates are
+     * visited in ascending ID order, exactly like the former all-pairs loop.
+     */
+    void BuildGraph(const MobilitySnapshot& snapshot, BlockchainLedger& ledger, double maxRange, 
+                    const std::set<uint32_t>& blackholeNodes, double defaultSnr = 20.0) {
+        m_graph.clear();
+        m_weights.clear();
+        m_ettParts.clear();
+        
+        // TASK 4: Reset low trust logging flag for each BuildGraph call
+        g_lowTrustLogged = false;
+        
+        // TASK 1: Reset cost debug logging flag for each BuildGraph call
+        g_costDebugLogged = false;
+        
+        uint32_t numNodes = snapshot.positions.size();
+        
+        // Spatial grid: bin nodes by (x, y) cell of size maxRange
+        std::unordered_map<uint64_t, std::vector<uint32_t>> grid;
+        auto cellOf = [maxRange](const NodePosition& pos) {
+            return std::make_pair(static_cast<int32_t>(std::floor(pos.x / maxRange)),
+                                  static_cast<int32_t>(std::floor(pos.y / maxRange)));
+        };
+        auto cellKey = [](int32_t cx, int32_t cy) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+        };
+        for (uint32_t n = 0; n < numNodes; n++) {
+            if (!snapshot.valid[n]) continue;
+            auto cell = cellOf(snapshot.positions[n]);
+            grid[cellKey(cell.first, cell.second)].push_back(n);
+        }
+        
+        std::vector<uint32_t> candidates;
+        for (uint32_t i = 0; i < numNodes; i++) {
+            if (!snapshot.valid[i]) continue;
+            
+            // Collect candidates j > i from the 3x3 neighbouring cells
+            candidates.clear();
+            auto cell = cellOf(snapshot.positions[i]);
+            for (int32_t cx = cell.first - 1; cx <= cell.first + 1; cx++) {
+                for (int32_t cy = cell.second - 1; cy <= cell.second + 1; cy++) {
+                    auto it = grid.find(cellKey(cx, cy));
+                    if (it == grid.end()) continue;
+                    for (uint32_t j : it->second) {
+                        if (j > i) candidates.push_back(j);
+                    }
+                }
+            }
+            std::sort(candidates.begin(), candidates.end());
+            
+            for (uint32_t j : candidates) {
+                // Distributed mode: radio links between strips are carried by portal links only
+                if (m_partitionOf && (*m_partitionOf)[i] != (*m_partitionOf)[j] &&
+                    m_portalPairs->find(std::make_pair(i, j)) == m_portalPairs->end()) {
+                    continue;
+                }
+                
+                // Calculate physical distance
+                double distance = snapshot.Distance(i, j);
+                
+                // If distance < MaxRadioRange, add edge to graph
+                if (distance < maxRange) {
+                    // FIX: Include ALL edges in graph to maintain connectivity
+                    // Proposed mode will use high weights to discourage routing through blackholes
+                    // Baseline mode will use equal weights (hop count)
+                    
+                    m_graph[i].insert(j);
+                    m_graph[j].insert(i);
+                    
+                    // Get Trust/SNR from Ledger, or use defaults if no data
+                    // IMPORTANT: We do NOT pre-set trust for blackhole nodes here
+                    // System must DETECT them dynamically via trust decay (packet drops)
+                    double trust = ledger.GetTrust(i, j);
+                    
+                    // Calculate SNR based on distance (Physics)
+                    // Since we disabled Oracle SNR updates in PhyRxEndCallback, we calculate it here directly
+                    // This ensures the routing metric still accounts for link quality
+                    double estimatedSnrDb = defaultSnr - (distance / 10.0);
+                    if (estimatedSnrDb < 5.0) estimatedSnrDb = 5.0;
+                    double snrDb = estimatedSnrDb;
+                    
+                    // If Ledger has NO data (new link), use Default Trust (1.0) and Default SNR
+                    // Initially, all nodes have trust = 1.0, including blackholes
+                    // Trust will decay as blackholes drop packets, and system will detect them
+                    if (snrDb <= 0.0) {
+                        snrDb = defaultSnr;
+                    }
+                    // Safety check: Ensure trust is never zero or negative (would cause division by zero)
+                    // Minimum trust is ledger.GetTrustFloor() (safety floor from UpdateMetric)
+                    double trustFloor = ledger.GetTrustFloor();
+                    if (trust <= 0.0) {
+                        trust = 1.0;  // Default for new links
+                    }
+                    // Enforce minimum trust floor to prevent infinite costs
+                    if (trust < trustFloor) {
+                        trust = trustFloor;  // Safety floor - link is expensive but not dead
+                    }
+                    
+                    // TASK 1: Proper SNR Normalization (Mathematically Correct Minimization)
+                    // Normalize SNR: Convert SNR (dB) to normalized quality score [0.01, 1.0]
+                    // This ensures SNR and Trust are in comparable scalar ranges
+                    // MinSNR = 5.0 dB, MaxSNR = 40.0 dB (reasonable range for 60GHz)
+                    const double MinSNR = 5.0;
+                    const double MaxSNR = 40.0;
+                    double snrNorm = std::max(0.01, std::min(1.0, (snrDb - MinSNR) / (MaxSNR - MinSNR)));  // Clamp to [0.01, 1.0]
+                    
+                    // Invert Metrics: Penalize low SNR and low Trust
+                    // Quadratic penalty for bad signal: snrCost = 1.0 / (snrNorm^2)
+                    // Quadratic penalty for bad trust: trustCost = 1.0 / (trust^2)
+                    // High SNR/Trust -> Low Cost (correct minimization)
+                    // Both metrics are now in comparable ranges [0.01, 1.0]
+                    double snrCost = 1.0 / (snrNorm * snrNorm);
+                    double trustCost = 1.0 / (trust * trust);
+                    
+                    // TASK 4: Add "Low Trust" Logging
+                    // Log warning if trust is below threshold (once per BuildGraph call)
+                    if (trust < 0.5 && !g_lowTrustLogged) {
+                        SIXG_CORE_WARN("Low trust detected: Link " << i << "->" << j << " has trust=" << trust);
+                        g_lowTrustLogged = true;  // Log once per BuildGraph call
+                    }
+                    
+                    // Calculate weight based on routing mode
+                    double cost;
+                    if (m_costMode == LinkCostMode::Ett) {
+                        // Airtime in microseconds: 150 us (54 Mb/s, 1 KB) to 14 ms (6 Mb/s, ETX 10),
+                        // the same range as the SNR penalty, so alpha and beta keep their balance
+                        double ettUs = EttMicroseconds(snrDb, ledger.GetDeliveryRatio(i, j));
+                        cost = m_useBlockchain ? m_alpha * ettUs + m_beta * trustCost : ettUs;
+                        m_ettParts[std::make_pair(i, j)] = m_alpha * ettUs;
+                    } else if (m_useBlockchain) {
+                        // TASK 1: Proposed: Blockchain-assisted routing with Trust (Mathematically Correct)
+                        // Cost = (alpha * snrCost) + (beta * trustCost)
+                        // Where snrCost = 1/(snrNorm^2) and trustCost = 1/(trust^2)
+                        // Quadratic inversion naturally handles weighting (low trust spikes cost to infinity)
+                        // Balanced: Beta=500 ensures Bad Trust cost (12,500) is comparable to Bad SNR cost (10,000)
+                        // For nodes with low trust (0.2 after multiple drops), trustCost = 1/(0.2^2) = 25.0, Beta*trustCost = 500*25 = 12,500
+                        // For normal nodes, trust = 1.0, so trustCost = 1/(1.0^2) = 1.0, Beta*trustCost = 500*1 = 500
+                        // For bad SNR (0.01), snrCost = 1/(0.01^2) = 10,000, Alpha*snrCost = 1*10,000 = 10,000
+                        // This balanced approach ensures Trust penalty is comparable to SNR penalty
+                        double snrPart = m_alpha * snrCost;
+                        double trustPart = m_beta * trustCost;
+                        cost = snrPart + trustPart;
+                        
+                        // TASK 1: Debug log (only once per BuildGraph call for one link)
+                        if (!g_costDebugLogged) {
+                            SIXG_CORE_WARN("Cost Components: SNR_Part=" << std::fixed << std::setprecision(2) << snrPart 
+                                      << ", Trust_Part=" << std::fixed << std::setprecision(2) << trustPart
+                                      << " (Beta=" << m_beta << ", snrNorm=" << std::fixed << std::setprecision(3) << snrNorm
+                                      << ", trust=" << std::fixed << std::setprecision(3) << trust << ")");
+                            g_costDebugLogged = true;
+                        }
+                    } else {
+                        // Baseline: Standard routing (hop count, ignores Trust)
+                        // Cost = 1 (mimics AODV/OLSR behavior, creates vulnerability)
+                        cost = 1.0;
+                    }
+                    
+                    m_weights[std::make_pair(i, j)] = cost;
+                    m_weights[std::make_pair(j, i)] = cost;
+                }
+            }
+        }
+        
+        // Multi-channel mode: links sharing a channel with conflicting links get a share of its airtime
+        if (m_channels) {
+            m_channels->Update(m_graph);
+            for (auto& edge : m_weights) {
+                edge.second *= 1.0 + m_channelContention *
+                               m_channels->GetSameChannelConflicts(edge.first.first, edge.first.second);
+            }
+        }
+        
+        // Two-level mode: refresh clusters and split graph into intra-cluster links and portals
+        if (m_hierarchical) {
+            m_clusterRouter.UpdateClusters(snapshot);
+            m_clusterRouter.Rebuild(m_graph, m_weights, ledger);
+        }
+        
+        // Contraction hierarchy: new weights every heartbeat, a new contraction only for new links
+        if (m_contracted) {
+            m_cchRouter.Update(snapshot, m_graph, m_weights, maxRange);
+        }
+    }
+    
+    /**
+     * Calculate path using Dijkstra's algorithm
+     * 
+     * TASK 3: Path Cost Aggregation Logic
+     * Path Cost Aggregation: SUM(LinkCosts). We minimize the additive sum of inverse-quality metrics.
+     * Each link in the path contributes its cost (computed from SNR and Trust) to the total path cost.
+     * Dijkstra's algorithm finds the path with minimum total cost (sum of all link costs).
+     * This ensures that paths with high-quality links (good SNR and high trust) are preferred.
+     * 
+     * Also calculates cost composition (SNR vs Trust parts) for control plane metrics.
+     */
+    std::vector<uint32_t> CalculatePath(uint32_t source, uint32_t dest, BlockchainLedger* ledger = nullptr) {
+        std::vector<uint32_t> path;
+        
+        if (m_graph.find(source) == m_graph.end() || 
+            m_graph.find(dest) == m_graph.end()) {
+            return path;  // Empty path
+        }
+        
+        if (m_hierarchical) {
+            // Two-level routing; flat Dijkstra only if the cluster search fails
+            path = m_clusterRouter.CalculatePath(source, dest);
+            if (path.empty()) {
+                path = DijkstraPath(source, dest);
+            }
+        } else if (m_contracted) {
+            path = m_cchRouter.CalculatePath(source, dest);
+        } else {
+            path = DijkstraPath(source, dest);
+        }
+        
+        // Control Plane Metrics: Calculate cost composition for this path
+        if (ledger && m_useBlockchain && path.size() > 1) {
+            double totalSnrCost = 0.0;
+            double totalTrustCost = 0.0;
+            
+            // Calculate cost composition for each link in the path
+            for (size_t i = 0; i < path.size() - 1; i++) {
+                uint32_t u = path[i];
+                uint32_t v = path[i + 1];
+                
+                // Get trust and SNR from ledger
+                double trust = ledger->GetTrust(u, v);
+                double trustCost = 1.0 / (trust * trust);
+                totalTrustCost += m_beta * trustCost;
+                if (m_costMode == LinkCostMode::Ett) {
+                    // The ETT part uses BuildGraph's SNR estimate (before channel contention scaling)
+                    auto ett = m_ettParts.find(std::make_pair(std::min(u, v), std::max(u, v)));
+                    totalSnrCost += ett != m_ettParts.end() ? ett->second : 0.0;
+                    continue;
+                }
+                double snrDb = ledger->GetSnr(u, v);
+                
+                // Use same normalization as BuildGraph
+                const double MinSNR = 5.0;
+                const double MaxSNR = 40.0;
+                double snrNorm = std::max(0.01, std::min(1.0, (snrDb - MinSNR) / (MaxSNR - MinSNR)));
+                
+                // Calculate cost components
+                double snrCost = 1.0 / (snrNorm * snrNorm);
+                
+                totalSnrCost += m_alpha * snrCost;
+            }
+            
+            // Accumulate for global averages
+            g_avgSnrCostPart += totalSnrCost;
+            g_avgTrustCostPart += totalTrustCost;
+            g_pathCalculations++;
+        }
+        
+        return path;
+    }
+    
+private:
+    /**
+     * Flat single-source Dijkstra over the whole graph (source/dest must be in graph)
+     */
+    std::vector<uint32_t> DijkstraPath(uint32_t source, uint32_t dest) {
+        std::vector<uint32_t> path;
+        
+        // Dijkstra's algorithm
+        std::map<uint32_t, double> dist;
+        std::map<uint32_t, uint32_t> prev;
+        std::set<uint32_t> unvisited;
+        
+        // Initialize distances
+        for (const auto& pair : m_graph) {
+            dist[pair.first] = std::numeric_limits<double>::infinity();
+            prev[pair.first] = UINT32_MAX;
+            unvisited.insert(pair.first);
+        }
+        
+        dist[source] = 0.0;
+        
+        while (!unvisited.empty()) {
+            // Find unvisited node with minimum distance
+            uint32_t u = UINT32_MAX;
+            double minDist = std::numeric_limits<double>::infinity();
+            for (uint32_t node : unvisited) {
+                if (dist[node] < minDist) {
+                    minDist = dist[node];
+                    u = node;
+                }
+            }
+            
+            if (u == UINT32_MAX || minDist == std::numeric_limits<double>::infinity()) {
+                break;  // No path found
+            }
+            
+            if (u == dest) {
+                break;  // Reached destination
+            }
+            
+            unvisited.erase(u);
+            
+            // Update distances to neighbors
+            // TASK 3: Path Cost Aggregation: SUM(LinkCosts)
+            // We minimize the additive sum of inverse-quality metrics.
+            // Each link contributes its cost to the total path cost.
+            // dist[v] = min(dist[v], dist[u] + weight) implements SUM(LinkCosts) minimization
+            if (m_graph.find(u) != m_graph.end()) {
+                for (uint32_t v : m_graph[u]) {
+                    if (unvisited.find(v) != unvisited.end()) {
+                        auto key = std::make_pair(u, v);
+                        double weight = (m_weights.find(key) != m_weights.end()) ? 
+                                       m_weights[key] : std::numeric_limits<double>::infinity();
+                        
+                        // Path Cost Aggregation: Add link cost to path cost
+                        double alt = dist[u] + weight;
+                        if (alt < dist[v]) {
+                            dist[v] = alt;
+                            prev[v] = u;
+                        }
+                    }
+                }
+            }
+        }
+        
+        // Reconstruct path
+        if (dist[dest] != std::numeric_limits<double>::infinity()) {
+            uint32_t current = dest;
+            while (current != UINT32_MAX) {
+                path.push_back(current);
+                current = prev[current];
+            }
+            std::reverse(path.begin(), path.end());
+        }
+        
+        return path;
+    }
+    
+    std::map<uint32_t, std::set<uint32_t>> m_graph;  // Adjacency list
+    std::map<std::pair<uint32_t, uint32_t>, double> m_weights;  // Edge weights
+    std::map<std::pair<uint32_t, uint32_t>, double> m_ettParts;  // (lo, hi) -> alpha x ETT of the link (linkCost=ett)
+    double m_alpha;
+    double m_beta;
+    bool m_useBlockchain;  // true = Proposed (with Trust), false = Baseline (hop count)
+    LinkCostMode m_costMode;  // Link quality term of the edge weight
+    double m_packetBits;   // Packet size the ETT is computed for
+    bool m_hierarchical;   // true = two-level cluster routing
+    ClusterRouter m_clusterRouter;
+    bool m_contracted;     // true = customizable contraction hierarchy
+    CchRouter m_cchRouter;
+    const std::vector<uint32_t>* m_partitionOf;  // Distributed mode: node -> partition (nullptr otherwise)
+    const std::set<std::pair<uint32_t, uint32_t>>* m_portalPairs;  // Distributed mode: cross-partition links
+    ChannelAssigner* m_channels;   // Multi-channel mode: link channels (nullptr otherwise)
+    double m_channelContention;    // Weight increase per same-channel conflicting link
+};
+
+/**
+ * MprSelector: OLSR multipoint relays over the routing graph (ledger dissemination)
+ * 
+ * Every node selects a small set of 1-hop neighbours (its MPRs) covering all of
+ * its strict 2-hop neighbours, using the greedy heuristic of RFC 3626 8.3.1. A
+ * broadcast is relayed only by nodes the transmitting neighbour selected as MPR,
+ * once per block hash. It reaches the same nodes as plain flooding with far fewer
+ * transmissions. Update() recomputes only the nodes whose 2-hop neighbourhood
+ * changed since the previous call.
+ */
+class MprSelector {
+public:
+    typedef std::map<uint32_t, std::set<uint32_t>> Graph;
+    
+    struct Dissemination {
+        uint32_t reached;             // Nodes holding the block afterwards (origin included)
+        uint32_t mprTransmissions;    // Origin plus MPR relays
+        uint32_t floodTransmissions;  // Plain flooding: every reached node rebroadcasts once
+    };
+    
+    MprSelector() : m_stamp(0), m_recomputations(0) {}
+    
+    /**
+     * Take the new adjacency; returns the number of MPR sets recomputed
+     */
+    size_t Update(const Graph& graph, uint32_t numNodes) {
+        if (m_neighbors.size() != numNodes) {
+            m_neighbors.assign(numNodes, std::vector<uint32_t>());
+            m_mprs.assign(numNodes, std::vector<uint32_t>());
+            m_dirty.assign(numNodes, 1);
+            m_n1Stamp.assign(numNodes, 0);
+            m_n2Stamp.assign(numNodes, 0);
+            m_n2Index.assign(numNodes, 0);
+            m_seenHash.assign(numNodes, 0);
+            m_relayedHash.assign(numNodes, 0);
+        }
+        std::vector<uint32_t> current;
+        for (uint32_t n = 0; n < numNodes; n++) {
+            current.clear();
+            auto it = graph.find(n);
+            if (it != graph.end()) current.assign(it->second.begin(), it->second.end());
+            if (current == m_neighbors[n]) continue;
+            // n's 2-hop view and that of every old and new neighbour changed
+            m_dirty[n] = 1;
+            for (uint32_t v : m_neighbors[n]) m_dirty[v] = 1;
+            for (uint32_t v : current) m_dirty[v] = 1;
+            m_neighbors[n].swap(current);
+        }
+        size_t recomputed = 0;
+        for (uint32_t n = 0; n < numNodes; n++) {
+            if (!m_dirty[n]) continue;
+            Select(n);
+            m_dirty[n] = 0;
+            recomputed++;
+        }
+        m_recomputations += recomputed;
+        return recomputed;
+    }
+    
+    const std::vector<uint32_t>& GetMprs(uint32_t nodeId) const {
+        return m_mprs[nodeId];
+    }
+    
+    bool IsMprOf(uint32_t selector, uint32_t nodeId) const {
+        const std::vector<uint32_t>& mprs = m_mprs[selector];
+        return std::binary_search(mprs.begin(), mprs.end(), nodeId);
+    }
+    
+    /**
+     * Broadcast one block from origin (blockHash must be non-zero and unique per block)
+     */
+    Dissemination Disseminate(uint32_t origin, uint64_t blockHash) {
+        Dissemination result{1, 0, 0};
+        std::vector<uint32_t>& queue = m_queue;
+        queue.assign(1, origin);
+        m_seenHash[origin] = blockHash;
+        m_relayedHash[origin] = blockHash;
+        for (size_t q = 0; q < queue.size(); q++) {
+            uint32_t sender = queue[q];
+            result.mprTransmissions++;
+            for (uint32_t v : m_neighbors[sender]) {
+                if (m_seenHash[v] != blockHash) {
+                    m_seenHash[v] = blockHash;  // Duplicate suppression by block hash
+                    result.reached++;
+                }
+                // RFC 3626 3.4: relay once, if a selector of v transmitted the block
+                if (m_relayedHash[v] != blockHash && IsMprOf(sender, v)) {
+                    m_relayedHash[v] = blockHash;
+                    queue.push_back(v);
+                }
+            }
+        }
+        result.floodTransmissions = result.reached;
+        return result;
+    }
+    
+    /**
+     * Mean MPR set size over nodes with at least one neighbour
+     */
+    double GetMeanMprSetSize() const {
+        size_t nodes = 0;
+        size_t total = 0;
+        for (size_t n = 0; n < m_mprs.size(); n++) {
+            if (m_neighbors[n].empty()) continue;
+            nodes++;
+            total += m_mprs[n].size();
+        }
+        return nodes > 0 ? static_cast<double>(total) / nodes : 0.0;
+    }
+    
+    uint64_t GetRecomputations() const {
+        return m_recomputations;
+    }
+    
+private:
+    /**
+     * Greedy MPR selection for one node
+     */
+    void Select(uint32_t n) {
+        std::vector<uint32_t>& mprs = m_mprs[n];
+        mprs.clear();
+        m_stamp++;
+        const std::vector<uint32_t>& n1 = m_neighbors[n];
+        for (uint32_t m : n1) m_n1Stamp[m] = m_stamp;
+        
+        // Strict 2-hop neighbours, how many N1 nodes cover each, and the last one seen
+        m_n2.clear();
+        m_coverCount.clear();
+        m_lastCover.clear();
+        for (uint32_t m : n1) {
+            for (uint32_t x : m_neighbors[m]) {
+                if (x == n || m_n1Stamp[x] == m_stamp) continue;
+                if (m_n2Stamp[x] != m_stamp) {
+                    m_n2Stamp[x] = m_stamp;
+                    m_n2Index[x] = m_n2.size();
+                    m_n2.push_back(x);
+                    m_coverCount.push_back(0);
+                    m_lastCover.push_back(m);
+                }
+                m_coverCount[m_n2Index[x]]++;
+                m_lastCover[m_n2Index[x]] = m;
+            }
+        }
+        m_covered.assign(m_n2.size(), 0);
+        size_t uncovered = m_n2.size();
+        auto take = [&](uint32_t m) {
+            mprs.push_back(m);
+            for (uint32_t x : m_neighbors[m]) {
+                if (m_n2Stamp[x] == m_stamp && !m_covered[m_n2Index[x]]) {
+                    m_covered[m_n2Index[x]] = 1;
+                    uncovered--;
+                }
+            }
+        };
+        
+        // Neighbours that are the only way to reach some 2-hop node
+        for (size_t i = 0; i < m_n2.size(); i++) {
+            if (m_coverCount[i] == 1 && !m_covered[i]) take(m_lastCover[i]);
+        }
+        // Then the neighbour covering most uncovered nodes (ties: higher degree, lower ID)
+        while (uncovered > 0) {
+            uint32_t best = UINT32_MAX;
+            size_t bestReach = 0;
+            for (uint32_t m : n1) {
+                if (std::find(mprs.begin(), mprs.end(), m) != mprs.end()) continue;
+                size_t reach = 0;
+                for (uint32_t x : m_neighbors[m]) {
+                    if (m_n2Stamp[x] == m_stamp && !m_covered[m_n2Index[x]]) reach++;
+                }
+                if (reach > bestReach ||
+                    (reach == bestReach && reach > 0 && m_neighbors[m].size() > m_neighbors[best].size())) {
+                    best = m;
+                    bestReach = reach;
+                }
+            }
+            if (best == UINT32_MAX) break;
+            take(best);
+        }
+        std::sort(mprs.begin(), mprs.end());
+    }
+    
+    std::vector<std::vector<uint32_t>> m_neighbors;  // Sorted adjacency of the last Update()
+    std::vector<std::vector<uint32_t>> m_mprs;       // Sorted MPR set per node
+    std::vector<uint8_t> m_dirty;                    // MPR set must be recomputed
+    std::vector<uint64_t> m_seenHash;                // Last block hash received per node
+    std::vector<uint64_t> m_relayedHash;             // Last block hash relayed per node
+    // Selection scratch (stamped, so nothing is cleared per node)
+    uint64_t m_stamp;
+    std::vector<uint64_t> m_n1Stamp;
+    std::vector<uint64_t> m_n2Stamp;
+    std::vector<uint32_t> m_n2Index;
+    std::vector<uint32_t> m_n2;
+    std::vector<uint32_t> m_coverCount;
+    std::vector<uint32_t> m_lastCover;
+    std::vector<uint8_t> m_covered;
+    std::vector<uint32_t> m_queue;
+    uint64_t m_recomputations;
+};
+
+#endif // SIXG_WIGIG_CORE_H
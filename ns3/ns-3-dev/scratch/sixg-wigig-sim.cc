@@ -13,11 +13,22 @@
 #include "ns3/applications-module.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/ipv4-list-routing-helper.h"
+#include "ns3/aodv-module.h"
+#include "ns3/olsr-module.h"
+#include "ns3/dsdv-module.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/position-allocator.h"
 #include "ns3/yans-wifi-helper.h"
+#include "ns3/point-to-point-helper.h"
 #include "ns3/flow-monitor-module.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#include <mpi.h>
+#endif
+#include <array>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <set>
 #include <queue>
@@ -27,6 +38,21 @@
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
 
 using namespace ns3;
 
@@ -47,496 +73,3189 @@ bool g_costDebugLogged = false;    // Flag for cost debug logging (reset per Bui
 
 // Control Plane Metrics
 uint64_t g_routeFlaps = 0;         // Number of route changes (flapping)
-std::map<uint32_t, std::vector<uint32_t>> g_lastPaths;  // FlowID -> Last path (for flapping detection)
 double g_avgSnrCostPart = 0.0;     // Average SNR cost component in path calculations
 double g_avgTrustCostPart = 0.0;  // Average Trust cost component in path calculations
 uint32_t g_pathCalculations = 0;  // Number of path calculations (for averaging)
 uint64_t g_timeSeriesTx = 0;      // Total TX packets for time series
 uint64_t g_timeSeriesRx = 0;      // Total RX packets for time series
+uint64_t g_trustOutcomes = 0;     // Tracked packet outcomes fed to the ledger
+uint64_t g_trustLinkUpdates = 0;  // Batched ledger writes (one per link per heartbeat)
+
+// Greedy Geographic Fallback Metrics
+uint64_t g_greedyForwards = 0;     // Packets forwarded greedily (no static route)
+uint64_t g_perimeterForwards = 0;  // Packets forwarded in perimeter (face) mode
+uint64_t g_greedyFailures = 0;     // Fallback found no usable neighbour
+
+// Source Routing Metrics
+uint64_t g_sourceRoutedPackets = 0;  // Packets stamped with a source route at the origin
+uint64_t g_sourceRouteBytes = 0;     // Source route header bytes stamped (hop count + 16-bit indices)
+uint64_t g_sourceRouteHops = 0;      // Intermediate forwarding decisions taken from the header
+uint64_t g_sourceRouteAirBytes = 0;  // Header bytes transmitted (origin and every relay)
+uint64_t g_sourceRouteTooLong = 0;   // Paths longer than the header capacity (left to static routing)
+
+// Ledger Dissemination Metrics (MPR relays vs plain flooding)
+uint64_t g_disseminatedBlocks = 0;   // Ledger blocks broadcast (one per heartbeat)
+uint64_t g_mprTransmissions = 0;     // Origin + MPR relay transmissions
+uint64_t g_floodTransmissions = 0;   // Transmissions plain flooding would have needed
+uint64_t g_disseminationReached = 0; // Nodes reached, summed over blocks
+uint64_t g_mprRecomputations = 0;    // MPR sets recomputed (incremental updates)
+double g_mprSetSizeSum = 0.0;        // Mean MPR set size, summed over blocks
+
+// Distributed (MPI) Metrics
+uint64_t g_mpiDeliveryRecords = 0;  // Cross-rank delivery confirmations exchanged
+uint64_t g_mpiLedgerRecords = 0;    // Ledger records exchanged at heartbeat boundaries
+uint64_t g_mpiPathWords = 0;        // 32-bit words of flow paths exchanged
+uint64_t g_appTxPackets = 0;        // Application packets sent (all, not only the tracked sample)
+uint64_t g_appRxPackets = 0;        // Application packets received
+uint64_t g_appTxBytes = 0;          // Application bytes sent (incl. SeqTs header)
+uint64_t g_appRxBytes = 0;          // Application bytes received
+double g_appDelaySumMs = 0.0;       // End-to-end delay sum from SeqTs timestamps (distributed mode)
+uint64_t g_unicastForwards = 0;     // IPv4 forwards observed on this rank (distributed mode)
+
+// ============================================================================
+// Performance Instrumentation (Wall Clock + Hardware Counters)
+// ============================================================================
+// Every heartbeat phase and trace-callback class is timed with a steady clock.
+// With --perfCounters=true, cycles, instructions, LLC misses and branch misses
+// are additionally read via perf_event_open around the same scopes. When perf
+// events are not available (containers, perf_event_paranoid, non-Linux) the
+// profiler reports the reason and keeps wall-clock timing only.
+
+enum class ProfPhase : uint32_t {
+    HeartbeatTimeouts = 0,   // Application layer timeout detection
+    HeartbeatBuildGraph,     // Topology discovery + link costs
+    HeartbeatRoutes,         // Dijkstra + route installation
+    HeartbeatExchange,       // Distributed mode: MPI boundary exchange
+    CallbackAppTx,
+    CallbackAppRx,
+    CallbackPhyRxEnd,
+    CallbackPhyRxDrop,
+    CallbackL3Drop,
+    Count
+};
+
+const char* ProfPhaseName(ProfPhase phase) {
+    switch (phase) {
+        case ProfPhase::HeartbeatTimeouts: return "HB_Timeouts";
+        case ProfPhase::HeartbeatBuildGraph: return "HB_BuildGraph";
+        case ProfPhase::HeartbeatRoutes: return "HB_Routes";
+        case ProfPhase::HeartbeatExchange: return "HB_Exchange";
+        case ProfPhase::CallbackAppTx: return "CB_AppTx";
+        case ProfPhase::CallbackAppRx: return "CB_AppRx";
+        case ProfPhase::CallbackPhyRxEnd: return "CB_PhyRxEnd";
+        case ProfPhase::CallbackPhyRxDrop: return "CB_PhyRxDrop";
+        case ProfPhase::CallbackL3Drop: return "CB_L3Drop";
+        default: return "Unknown";
+    }
+}
+
+/**
+ * HwCounters: Group of hardware performance counters (Linux perf_event_open)
+ */
+class HwCounters {
+public:
+    enum Counter { CYCLES = 0, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, NUM_COUNTERS };
+    
+    HwCounters() : m_leaderFd(-1), m_numOpen(0) {
+        m_fds.fill(-1);
+        m_slot.fill(-1);
+    }
+    
+    ~HwCounters() {
+        Close();
+    }
+    
+    /**
+     * Open the counter group. Returns false (with a reason) if the leader cannot be opened.
+     * Individual members that are unsupported (e.g. LLC misses in a VM) are skipped.
+     */
+    bool Open(std::string& reason) {
+#ifdef __linux__
+        const uint64_t configs[NUM_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,   // Generic cache misses = last level cache on most CPUs
+            PERF_COUNT_HW_BRANCH_MISSES
+        };
+        for (uint32_t c = 0; c < NUM_COUNTERS; c++) {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[c];
+            attr.disabled = (m_leaderFd == -1) ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, m_leaderFd, 0));
+            if (fd == -1) {
+                if (m_leaderFd == -1) {
+                    reason = std::string("perf_event_open: ") + std::strerror(errno);
+                    return false;
+                }
+                continue;  // Member not supported - report as n/a
+            }
+            if (m_leaderFd == -1) {
+                m_leaderFd = fd;
+            }
+            m_fds[c] = fd;
+            m_slot[c] = static_cast<int>(m_numOpen++);
+        }
+        ioctl(m_leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(m_leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return true;
+#else
+        reason = "perf_event_open not available on this platform";
+        return false;
+#endif
+    }
+    
+    /**
+     * Read all counters of the group in one syscall
+     */
+    bool Read(std::array<uint64_t, NUM_COUNTERS>& values) const {
+#ifdef __linux__
+        uint64_t buf[1 + NUM_COUNTERS];
+        if (m_leaderFd == -1 || read(m_leaderFd, buf, sizeof(buf)) < static_cast<ssize_t>(sizeof(uint64_t))) {
+            return false;
+        }
+        for (uint32_t c = 0; c < NUM_COUNTERS; c++) {
+            values[c] = (m_slot[c] >= 0 && static_cast<uint64_t>(m_slot[c]) < buf[0]) ? buf[1 + m_slot[c]] : 0;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+    
+    bool IsAvailable(Counter c) const {
+        return m_fds[c] != -1;
+    }
+    
+    void Close() {
+#ifdef __linux__
+        for (int& fd : m_fds) {
+            if (fd != -1) {
+                close(fd);
+                fd = -1;
+            }
+        }
+#endif
+        m_leaderFd = -1;
+        m_numOpen = 0;
+    }
+    
+private:
+    int m_leaderFd;
+    uint32_t m_numOpen;
+    std::array<int, NUM_COUNTERS> m_fds;   // File descriptor per counter (-1 = unavailable)
+    std::array<int, NUM_COUNTERS> m_slot;  // Position of each counter in the group read
+};
+
+/**
+ * PhaseProfiler: Accumulates wall time and (optionally) hardware counters per phase
+ */
+class PhaseProfiler {
+public:
+    struct PhaseStats {
+        uint64_t calls = 0;
+        uint64_t wallNs = 0;
+        std::array<uint64_t, HwCounters::NUM_COUNTERS> hw{};
+    };
+    
+    PhaseProfiler() : m_hwEnabled(false) {}
+    
+    void EnableHardwareCounters() {
+        m_hwEnabled = m_hw.Open(m_hwReason);
+    }
+    
+    bool HardwareEnabled() const {
+        return m_hwEnabled;
+    }
+    
+    void Begin(std::chrono::steady_clock::time_point& wallStart,
+               std::array<uint64_t, HwCounters::NUM_COUNTERS>& hwStart) const {
+        if (m_hwEnabled) {
+            m_hw.Read(hwStart);
+        }
+        wallStart = std::chrono::steady_clock::now();
+    }
+    
+    void End(ProfPhase phase, const std::chrono::steady_clock::time_point& wallStart,
+             const std::array<uint64_t, HwCounters::NUM_COUNTERS>& hwStart) {
+        auto wallEnd = std::chrono::steady_clock::now();
+        PhaseStats& stats = m_stats[static_cast<uint32_t>(phase)];
+        stats.calls++;
+        stats.wallNs += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(wallEnd - wallStart).count());
+        if (m_hwEnabled) {
+            std::array<uint64_t, HwCounters::NUM_COUNTERS> hwEnd;
+            if (m_hw.Read(hwEnd)) {
+                for (uint32_t c = 0; c < HwCounters::NUM_COUNTERS; c++) {
+                    stats.hw[c] += hwEnd[c] - hwStart[c];
+                }
+            }
+        }
+    }
+    
+    const PhaseStats& GetStats(ProfPhase phase) const {
+        return m_stats[static_cast<uint32_t>(phase)];
+    }
+    
+    /**
+     * Mean wall time per call in microseconds
+     */
+    double MeanUs(ProfPhase phase) const {
+        const PhaseStats& stats = GetStats(phase);
+        return stats.calls > 0 ? static_cast<double>(stats.wallNs) / 1000.0 / static_cast<double>(stats.calls) : 0.0;
+    }
+    
+    void Report(bool hwRequested) const {
+        if (hwRequested && !m_hwEnabled) {
+            std::cout << "[PERF_COUNTERS] Unavailable (" << m_hwReason << "), reporting wall clock only" << std::endl;
+        }
+        for (uint32_t p = 0; p < static_cast<uint32_t>(ProfPhase::Count); p++) {
+            const PhaseStats& stats = m_stats[p];
+            if (stats.calls == 0) {
+                continue;
+            }
+            double calls = static_cast<double>(stats.calls);
+            std::cout << "[PERF_PHASE] Phase=" << ProfPhaseName(static_cast<ProfPhase>(p))
+                      << " | Calls=" << stats.calls
+                      << " | TotalMs=" << std::fixed << std::setprecision(3) << stats.wallNs / 1e6
+                      << " | MeanUs=" << std::fixed << std::setprecision(3) << MeanUs(static_cast<ProfPhase>(p));
+            if (m_hwEnabled) {
+                const char* names[HwCounters::NUM_COUNTERS] = {"Cycles", "Instructions", "LLCMisses", "BranchMisses"};
+                for (uint32_t c = 0; c < HwCounters::NUM_COUNTERS; c++) {
+                    std::cout << " | " << names[c] << "PerCall=";
+                    if (m_hw.IsAvailable(static_cast<HwCounters::Counter>(c))) {
+                        std::cout << std::fixed << std::setprecision(1) << stats.hw[c] / calls;
+                    } else {
+                        std::cout << "n/a";
+                    }
+                }
+                if (stats.hw[HwCounters::CYCLES] > 0) {
+                    std::cout << " | IPC=" << std::fixed << std::setprecision(3)
+                              << static_cast<double>(stats.hw[HwCounters::INSTRUCTIONS]) / stats.hw[HwCounters::CYCLES];
+                }
+            }
+            std::cout << std::endl;
+        }
+    }
+    
+private:
+    HwCounters m_hw;
+    bool m_hwEnabled;
+    std::string m_hwReason;
+    std::array<PhaseStats, static_cast<uint32_t>(ProfPhase::Count)> m_stats;
+};
+
+PhaseProfiler g_profiler;
+
+/**
+ * Peak resident set size of this process in KiB (0 if unknown)
+ */
+uint64_t GetPeakRssKb() {
+#ifdef __unix__
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return static_cast<uint64_t>(usage.ru_maxrss);  // Linux reports KiB
+    }
+#endif
+    return 0;
+}
+
+/**
+ * PhaseScope: Times one phase until Stop() or end of scope
+ */
+class PhaseScope {
+public:
+    explicit PhaseScope(ProfPhase phase) : m_phase(phase), m_running(true) {
+        g_profiler.Begin(m_wallStart, m_hwStart);
+    }
+    
+    ~PhaseScope() {
+        Stop();
+    }
+    
+    void Stop() {
+        if (m_running) {
+            g_profiler.End(m_phase, m_wallStart, m_hwStart);
+            m_running = false;
+        }
+    }
+    
+private:
+    ProfPhase m_phase;
+    bool m_running;
+    std::chrono::steady_clock::time_point m_wallStart;
+    std::array<uint64_t, HwCounters::NUM_COUNTERS> m_hwStart{};
+};
 
 // ============================================================================
 // Application Layer Tracking (Realistic Detection)
 // ============================================================================
-struct TrackedPacket {
-    uint32_t packetUid;
-    Time sendTime;
-    uint32_t sourceNodeId;
-    uint32_t destNodeId;
-    uint32_t nextHopId;  // First hop on the path (for symmetric trust updates)
+// A sample of the sent packets is tracked until the source learns of its
+// delivery or it times out. Packets are identified by flow and SeqTs sequence
+// number, which every flow sends in increasing order, so each flow's tracked
+// packets form a ring in send order: a new packet is appended, a delivery is
+// a binary search, and the heartbeat sweep pops finished packets off the
+// front. The rings only grow (to the packets in flight within the timeout),
+// so tracking allocates nothing per packet.
+
+/**
+ * PacketTracker: Per-flow rings of tracked packets awaiting delivery or timeout
+ */
+class PacketTracker {
+public:
+    PacketTracker() : m_pending(0), m_peakPending(0), m_tracked(0), m_growths(0), m_sweeps(0), m_sweepNs(0.0) {}
+    
+    void Configure(size_t numFlows) {
+        m_rings.assign(numFlows, FlowRing());
+    }
+    
+    /**
+     * Track a sent packet; the first hop is charged with its outcome
+     */
+    void Track(uint32_t flow, uint32_t seq, uint32_t nextHop, int64_t sendNs) {
+        if (flow >= m_rings.size()) return;
+        FlowRing& ring = m_rings[flow];
+        if (ring.size > 0 && seq <= ring.At(ring.size - 1).seq) return;  // Not in send order (restarted sender)
+        if (ring.size == ring.slots.size()) {
+            Grow(ring);
+        }
+        ring.At(ring.size++) = Entry{seq, nextHop, sendNs, kPending};
+        m_tracked++;
+        m_pending++;
+        m_peakPending = std::max(m_peakPending, m_pending);
+    }
+    
+    /**
+     * Mark a tracked packet delivered; returns false if it is not pending
+     */
+    bool MarkDelivered(uint32_t flow, uint32_t seq) {
+        if (flow >= m_rings.size()) return false;
+        FlowRing& ring = m_rings[flow];
+        uint32_t i = LowerBound(ring, seq);
+        if (i == ring.size || ring.At(i).seq != seq || ring.At(i).state != kPending) return false;
+        ring.At(i).state = kDelivered;
+        return true;
+    }
+    
+    /**
+     * Mark delivered the pending packets in [lo, end) that covers(seq) accepts; returns how many
+     */
+    template <class F>
+    uint32_t MarkCovered(uint32_t flow, uint32_t lo, uint64_t end, F&& covers) {
+        if (flow >= m_rings.size()) return 0;
+        FlowRing& ring = m_rings[flow];
+        uint32_t marked = 0;
+        for (uint32_t i = LowerBound(ring, lo); i < ring.size && ring.At(i).seq < end; i++) {
+            Entry& entry = ring.At(i);
+            if (entry.state == kPending && covers(entry.seq)) {
+                entry.state = kDelivered;
+                marked++;
+            }
+        }
+        return marked;
+    }
+    
+    /**
+     * Report delivered and timed-out packets as outcome(flow, nextHop, isDrop), in flow then send order
+     */
+    template <class F>
+    void Sweep(int64_t nowNs, int64_t timeoutNs, F&& outcome) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t flow = 0; flow < m_rings.size(); flow++) {
+            FlowRing& ring = m_rings[flow];
+            for (uint32_t i = 0; i < ring.size; i++) {
+                Entry& entry = ring.At(i);
+                if (entry.state == kDelivered || (entry.state == kPending && nowNs - entry.sendNs > timeoutNs)) {
+                    outcome(flow, entry.nextHop, entry.state == kPending);
+                    entry.state = kDone;
+                    m_pending--;
+                }
+            }
+            while (ring.size > 0 && ring.At(0).state == kDone) {
+                ring.head = (ring.head + 1) & (ring.slots.size() - 1);
+                ring.size--;
+            }
+        }
+        m_sweeps++;
+        m_sweepNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    
+    uint64_t GetTracked() const { return m_tracked; }
+    uint64_t GetPeakPending() const { return m_peakPending; }
+    uint64_t GetGrowths() const { return m_growths; }
+    uint64_t GetSweeps() const { return m_sweeps; }
+    double GetSweepNs() const { return m_sweepNs; }
+    
+    /**
+     * Ring memory in bytes
+     */
+    uint64_t GetBytes() const {
+        uint64_t bytes = 0;
+        for (const FlowRing& ring : m_rings) bytes += ring.slots.capacity() * sizeof(Entry);
+        return bytes;
+    }
+    
+private:
+    static const uint8_t kPending = 0;
+    static const uint8_t kDelivered = 1;  // Credited at the next sweep
+    static const uint8_t kDone = 2;       // Reported; popped once it reaches the front
+    
+    struct Entry {
+        uint32_t seq;
+        uint32_t nextHop;   // First hop on the path (same hop credited on delivery and penalised on timeout)
+        int64_t sendNs;
+        uint8_t state;
+    };
+    
+    struct FlowRing {
+        std::vector<Entry> slots;  // Power-of-two capacity
+        uint32_t head = 0;
+        uint32_t size = 0;
+        
+        Entry& At(uint32_t i) { return slots[(head + i) & (slots.size() - 1)]; }
+    };
+    
+    void Grow(FlowRing& ring) {
+        std::vector<Entry> slots(std::max<size_t>(16, 2 * ring.slots.size()));
+        for (uint32_t i = 0; i < ring.size; i++) slots[i] = ring.At(i);
+        ring.slots.swap(slots);
+        ring.head = 0;
+        m_growths++;
+    }
+    
+    /**
+     * First ring position whose sequence number is at least seq
+     */
+    static uint32_t LowerBound(FlowRing& ring, uint32_t seq) {
+        uint32_t lo = 0;
+        uint32_t hi = ring.size;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (ring.At(mid).seq < seq) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+    
+    std::vector<FlowRing> m_rings;  // Flow index -> tracked packets in send order
+    uint64_t m_pending;
+    uint64_t m_peakPending;
+    uint64_t m_tracked;
+    uint64_t m_growths;   // Ring reallocations
+    uint64_t m_sweeps;
+    double m_sweepNs;     // Wall time spent in heartbeat sweeps
+};
+
+/**
+ * DeliveryRecord: Delivery of a tracked packet whose source lives on another rank
+ */
+struct DeliveryRecord {
+    uint32_t flowIdx;
+    uint32_t seq;
 };
 
-std::map<uint32_t, TrackedPacket> g_pendingPackets;
-std::set<uint32_t> g_deliveredPackets;
+const uint16_t kDataBasePort = 5000;  // Flow i is sent to UDP port kDataBasePort + i
+const uint32_t kMaxChannels = 6;      // 802.11ay channels in the 60 GHz band (channel c radios use 10.(1+c).0.0/16)
+
+PacketTracker g_tracker;
 std::map<uint32_t, uint32_t> g_sourceToDest; // Source -> Dest Mapping
+std::map<uint32_t, uint32_t> g_destToSource; // Dest -> Source Mapping (distributed delivery confirmations)
+std::vector<DeliveryRecord> g_remoteDeliveries;  // Distributed mode: sent to the source's rank at the next heartbeat
+
+// ============================================================================
+// Route Stability Tracking (Path Fingerprints)
+// ============================================================================
+// Instead of storing and comparing full path vectors per flow, each flow keeps a
+// 64-bit rolling hash of its hop sequence plus the hop count. A path change is
+// detected when either differs. Storage is a flat array indexed by flow index,
+// sized once after flow selection, so the heartbeat never allocates here.
+
+const uint32_t kFlapRingSize = 16;     // Flap timestamps kept per flow (flap-rate analysis)
+#ifdef SIXG_PATH_DEBUG
+const uint32_t kInlinePathHops = 8;    // Leading hops kept inline for debugging
+#endif
+
+/**
+ * FlowRouteState: Per-flow route fingerprint and recent flap history
+ */
+struct FlowRouteState {
+    uint64_t pathHash = 0;     // Rolling hash of the current path
+    uint16_t hopCount = 0;     // Number of nodes in the current path
+    bool hasPath = false;      // False until the first heartbeat computed a path
+    uint32_t flaps = 0;        // Total route changes for this flow
+    std::array<double, kFlapRingSize> flapTimes{};  // Ring of recent flap timestamps (s)
+    uint32_t flapHead = 0;     // Next write position in flapTimes
+#ifdef SIXG_PATH_DEBUG
+    std::array<uint32_t, kInlinePathHops> inlineHops{};  // First hops of the current path
+#endif
+    
+    void RecordFlap(double time) {
+        flapTimes[flapHead] = time;
+        flapHead = (flapHead + 1) % kFlapRingSize;
+        flaps++;
+    }
+    
+    /**
+     * Flap rate (flaps/s) over the timestamps currently held in the ring
+     */
+    double RecentFlapRate() const {
+        uint32_t held = std::min(flaps, kFlapRingSize);
+        if (held < 2) {
+            return 0.0;
+        }
+        double newest = flapTimes[(flapHead + kFlapRingSize - 1) % kFlapRingSize];
+        double oldest = flapTimes[(flapHead + kFlapRingSize - held) % kFlapRingSize];
+        if (newest <= oldest) {
+            return 0.0;
+        }
+        return static_cast<double>(held - 1) / (newest - oldest);
+    }
+};
+
+std::vector<FlowRouteState> g_flowRouteState;  // Flow index -> route fingerprint
+
+/**
+ * Rolling hash of a hop sequence (FNV-1a over the 32-bit node IDs)
+ */
+uint64_t HashPath(const std::vector<uint32_t>& path) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint32_t nodeId : path) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            hash ^= static_cast<uint64_t>((nodeId >> shift) & 0xFF);
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+// ============================================================================
+// Data Structures (routing and trust core, shared with the Python bindings)
+// ============================================================================
+#define SIXG_CORE_WARN(msg) NS_LOG_WARN(msg)
+#include "sixg-wigig-core.h"
+#include "sixg-chain-store.h"
+#include "sixg-snapshot-log.h"
 
 // ============================================================================
-// Data Structures
+// Packet-Level Adversary Engine
 // ============================================================================
+// The default blackhole model drops by withholding routes (NO_ROUTE at L3).
+// Gray-hole, on-off and selective-forwarding attackers keep their routes and
+// decide per forwarded packet instead. Each malicious node has a behaviour
+// record whose random parts (duty-cycle phase, targeted flows) are drawn at
+// setup; the per-packet coin is a counter-based hash of (seed, node, packet
+// count). A decision is therefore a few integer operations and consumes no
+// ns-3 random stream.
+
+enum class AttackModel { Blackhole, Grayhole, OnOff, Selective, Mixed };
 
 /**
- * LinkMetric: Stores metrics for a link between two nodes
+ * AdversaryBehaviour: Precomputed attack schedule and outcome of one malicious node
  */
-struct LinkMetric {
-    double movingAvgSnr = 0.0;  // Linear SNR (moving average)
-    uint32_t drops = 0;         // Loss counter
-    double trust = 1.0;         // Trust level (starts at 1.0)
+struct AdversaryBehaviour {
+    uint32_t nodeId = 0;
+    AttackModel model = AttackModel::Blackhole;
+    uint64_t dropThreshold = 0;           // Drop if the top 32 hash bits are below this (2^32 = always)
+    int64_t periodNs = 0;                 // Duty-cycle period (0 = always active)
+    int64_t activeNs = 0;                 // Active part of each period
+    int64_t phaseNs = 0;                  // Offset into the period at t = 0
+    std::vector<uint64_t> targetedFlows;  // Bitmap over flow indices (empty = every flow)
     
-    LinkMetric() : movingAvgSnr(0.0), drops(0), trust(1.0) {}
+    uint64_t packetsSeen = 0;             // Forwarding decisions taken (packet-level models)
+    uint64_t packetsDropped = 0;          // L3 drops at this node
+    uint64_t dropsAtDetection = 0;
+    uint64_t dropsBeforeIsolation = 0;
+    double firstDropS = -1.0;
+    double detectedS = -1.0;              // First time the ledger flags the node (IsBlackhole() becomes true)
+    double isolatedS = -1.0;              // First heartbeat after detection with no active path through the node
 };
 
 /**
- * BlockchainLedger: Trust layer for storing link metrics
+ * AdversaryEngine: Behaviour records indexed by node ID and per-attacker outcome tracking
  */
-class BlockchainLedger {
+class AdversaryEngine {
 public:
-    BlockchainLedger() : m_lossThreshold(0.5), m_defaultTrust(1.0), m_defaultSnr(20.0), m_trustFloor(0.2) {}
+    AdversaryEngine() : m_model(AttackModel::Blackhole), m_packetLevel(false), m_seed(0), m_falseFlags(0) {}
     
-    void SetTrustFloor(double floor) {
-        m_trustFloor = floor;
+    static bool ParseModel(const std::string& name, AttackModel& model) {
+        static const std::map<std::string, AttackModel> models = {
+            {"blackhole", AttackModel::Blackhole}, {"grayhole", AttackModel::Grayhole},
+            {"onoff", AttackModel::OnOff}, {"selective", AttackModel::Selective},
+            {"mixed", AttackModel::Mixed}};
+        auto it = models.find(name);
+        if (it == models.end()) return false;
+        model = it->second;
+        return true;
     }
     
-    double GetTrustFloor() const {
-        return m_trustFloor;
+    static const char* ModelName(AttackModel model) {
+        switch (model) {
+        case AttackModel::Blackhole: return "blackhole";
+        case AttackModel::Grayhole: return "grayhole";
+        case AttackModel::OnOff: return "onoff";
+        case AttackModel::Selective: return "selective";
+        case AttackModel::Mixed: return "mixed";
+        }
+        return "unknown";
     }
     
-    void UpdateMetric(uint32_t src, uint32_t dst, double snr, bool isDrop, bool useBlockchain = true) {
-        // OPTIMIZED: Removed verbose logging - called too frequently (every packet)
-        // NS_LOG_UNCOND("LEDGER UPDATE: Link " << src << "->" << dst << " | SNR: " << snr << " | Dropped: " << isDrop);
-        
-        auto key = MakeKey(src, dst);
-        
-        if (m_ledger.find(key) == m_ledger.end()) {
-            m_ledger[key] = LinkMetric();
+    /**
+     * Reset for a run; protocolRoutes = routes come from a MANET protocol, so
+     * blackholes cannot be modelled by withholding static routes and drop per packet
+     */
+    void Configure(AttackModel model, uint32_t numNodes, uint64_t seed, bool protocolRoutes) {
+        m_model = model;
+        m_packetLevel = model != AttackModel::Blackhole || protocolRoutes;
+        m_seed = seed;
+        m_slot.assign(numNodes, UINT32_MAX);
+        m_everFlagged.assign(numNodes, 0);
+        m_falseFlags = 0;
+        m_records.clear();
+        m_awaitingIsolation.clear();
+    }
+    
+    AttackModel GetModel() const {
+        return m_model;
+    }
+    
+    /**
+     * True if attackers keep their routes and drop per packet (hook installed)
+     */
+    bool IsPacketLevel() const {
+        return m_packetLevel;
+    }
+    
+    /**
+     * Register a malicious node (model must not be Mixed; the caller resolves it)
+     */
+    void AddAttacker(uint32_t nodeId, AttackModel model, double dropProbability, double periodS,
+                     double dutyCycle, double phaseFraction, std::vector<uint64_t> targetedFlows) {
+        AdversaryBehaviour record;
+        record.nodeId = nodeId;
+        record.model = model;
+        record.dropThreshold = static_cast<uint64_t>(std::clamp(dropProbability, 0.0, 1.0) * 4294967296.0);
+        if (model == AttackModel::OnOff) {
+            record.periodNs = static_cast<int64_t>(periodS * 1e9);
+            record.activeNs = static_cast<int64_t>(dutyCycle * periodS * 1e9);
+            record.phaseNs = static_cast<int64_t>(phaseFraction * periodS * 1e9);
         }
-        
-        LinkMetric& metric = m_ledger[key];
-        
-        // Update SNR (exponential moving average)
-        if (snr > 0.0) {
-            double alpha = 0.3;
-            metric.movingAvgSnr = alpha * snr + (1.0 - alpha) * metric.movingAvgSnr;
+        record.targetedFlows = std::move(targetedFlows);
+        m_slot[nodeId] = m_records.size();
+        m_records.push_back(std::move(record));
+    }
+    
+    bool IsAttacker(uint32_t nodeId) const {
+        return nodeId < m_slot.size() && m_slot[nodeId] != UINT32_MAX;
+    }
+    
+    /**
+     * True if the node's decision depends on the flow (caller must resolve the flow index)
+     */
+    bool TargetsFlows(uint32_t nodeId) const {
+        return IsAttacker(nodeId) && !m_records[m_slot[nodeId]].targetedFlows.empty();
+    }
+    
+    /**
+     * O(1) per-packet decision of a packet-level attacker (flowIdx UINT32_MAX = unknown flow)
+     */
+    bool ShouldDrop(uint32_t nodeId, uint32_t flowIdx, int64_t nowNs) {
+        if (!IsAttacker(nodeId)) return false;
+        AdversaryBehaviour& record = m_records[m_slot[nodeId]];
+        record.packetsSeen++;
+        if (record.periodNs > 0 && (nowNs + record.phaseNs) % record.periodNs >= record.activeNs) {
+            return false;
         }
-        
-        // TASK 2: Asymmetric Trust - Hard Drop, Slow Recovery
-        // Trust should never go below 0.2 to maintain connectivity even through "bad" nodes
-        // CRITICAL: Only apply trust penalties in Proposed mode (useBlockchain = true)
-        // In Baseline mode, trust is not used for routing, so penalties are unnecessary
-        if (isDrop && useBlockchain) {
-            metric.drops++;
-            g_trustPenalties++;
-            
-            // TASK 2: Asymmetric Trust - Hard Drop, Slow Recovery
-            // Geometric decay: trust = max(m_trustFloor, trust * 0.5)
-            // Drops fast to prevent On-Off attacks
-            // Floor is configurable for ablation study
-            metric.trust = std::max(m_trustFloor, metric.trust * 0.5);
-            
-            // OPTIMIZED: Removed verbose logging - trust penalties happen frequently
-            // std::cout << "[TRUST_LOG] TRUST_PENALTY: Node " << src << " -> " << dst 
-            //           << " | Drops: " << metric.drops 
-            //           << " | Old Trust: " << std::fixed << std::setprecision(4) << oldTrust
-            //           << " | New Trust: " << std::fixed << std::setprecision(4) << metric.trust
-            //           << " | Time: " << std::fixed << std::setprecision(3) 
-            //           << Simulator::Now().GetSeconds() << "s" << std::endl;
-        } else if (isDrop) {
-            // Baseline mode: Just count drops, don't apply trust penalties
-            metric.drops++;
-        } else if (!isDrop && useBlockchain) {
-            // TASK 2: Slow Down Recovery (Final Calibration)
-            // Linear recovery: trust = min(1.0, trust + 0.005)
-            // It takes ~200 successful packets to recover full trust (from 0.2 to 1.0)
-            // This proves we handle "On-Off" attacks by requiring a long history of success
-            // Slow recovery ensures attackers cannot quickly redeem themselves after dropping packets
-            metric.trust = std::min(1.0, metric.trust + 0.005);
-        }
-    }
-    
-    // DEPRECATED: SetBlackhole() is NOT used - system must detect blackholes dynamically
-    // This function exists for backward compatibility but should NOT be called
-    // The system uses PURE dynamic detection via trust decay (packet drops)
-    void SetBlackhole(uint32_t nodeId) {
-        // DO NOT USE THIS FUNCTION - it hardcodes trust values
-        // System must detect blackholes dynamically via trust decay
-        // This function is kept for backward compatibility only
-        NS_LOG_WARN("SetBlackhole() called - this is deprecated. System should detect blackholes dynamically via trust decay.");
-    }
-    
-    double GetTrust(uint32_t src, uint32_t dst) const {
-        // CRITICAL: Do NOT check blackholeNodes set here!
-        // System must DETECT blackholes dynamically via trust decay (packet drops)
-        // Initially, all nodes have trust = 1.0 (including blackholes)
-        // Trust will decay as blackholes drop packets, and system will detect them
-        
-        auto key = MakeKey(src, dst);
-        auto it = m_ledger.find(key);
-        if (it != m_ledger.end()) {
-            return it->second.trust;
+        if (!record.targetedFlows.empty() &&
+            (flowIdx == UINT32_MAX || (flowIdx >> 6) >= record.targetedFlows.size() ||
+             !((record.targetedFlows[flowIdx >> 6] >> (flowIdx & 63)) & 1u))) {
+            return false;
         }
-        return m_defaultTrust;
+        uint64_t coin = Mix(m_seed ^ (static_cast<uint64_t>(nodeId) << 40) ^ record.packetsSeen) >> 32;
+        return coin < record.dropThreshold;
     }
     
-    double GetSnr(uint32_t src, uint32_t dst) const {
-        auto key = MakeKey(src, dst);
-        auto it = m_ledger.find(key);
-        if (it != m_ledger.end() && it->second.movingAvgSnr > 0.0) {
-            return it->second.movingAvgSnr;
+    /**
+     * Count an L3 drop at a malicious node (all models)
+     */
+    void RecordDrop(uint32_t nodeId, double nowS) {
+        if (!IsAttacker(nodeId)) return;
+        AdversaryBehaviour& record = m_records[m_slot[nodeId]];
+        record.packetsDropped++;
+        if (record.firstDropS < 0.0) {
+            record.firstDropS = nowS;
         }
-        return m_defaultSnr;
     }
     
-    bool IsBlackhole(uint32_t nodeId) const {
-        // PURE DYNAMIC DETECTION: No hardcoding, only trust-based detection
-        // A node is considered a blackhole if it has low trust (<= m_trustFloor) in most of its links
-        // Trust decays from 1.0 -> 0.5 -> 0.25 -> m_trustFloor (floor) as packets drop
-        // After 2-3 drops, trust = m_trustFloor, which is at the threshold
-        uint32_t lowTrustLinks = 0;
-        uint32_t totalLinks = 0;
-        
-        for (const auto& pair : m_ledger) {
-            uint32_t n1 = pair.first.first;
-            uint32_t n2 = pair.first.second;
-            if (n1 == nodeId || n2 == nodeId) {
-                totalLinks++;
-                if (pair.second.trust <= m_trustFloor) {  // Threshold: trust <= m_trustFloor indicates suspicious behavior (CORRECT LOGIC)
-                    lowTrustLinks++;
-                }
-            }
+    /**
+     * Ledger callback: a node's IsBlackhole() result changed
+     */
+    void OnBlackholeFlag(uint32_t nodeId, bool flagged, double nowS) {
+        if (!flagged || nodeId >= m_slot.size() || m_everFlagged[nodeId]) return;
+        m_everFlagged[nodeId] = 1;
+        if (!IsAttacker(nodeId)) {
+            m_falseFlags++;  // Honest node flagged (first time only)
+            return;
         }
-        
-        // If node has links and most of them have low trust, it's a blackhole
-        // This is PURE dynamic detection - no hardcoding, no pre-knowledge
-        if (totalLinks > 0 && (static_cast<double>(lowTrustLinks) / static_cast<double>(totalLinks)) > 0.5) {
-            return true;
+        AdversaryBehaviour& record = m_records[m_slot[nodeId]];
+        record.detectedS = nowS;
+        record.dropsAtDetection = record.packetsDropped;
+        m_awaitingIsolation.push_back(m_slot[nodeId]);
+    }
+    
+    /**
+     * Heartbeat (after the flow paths are updated): isolate detected attackers no path crosses
+     */
+    void UpdateIsolation(const std::vector<uint32_t>& pathTraversals, double nowS) {
+        for (size_t i = 0; i < m_awaitingIsolation.size(); ) {
+            AdversaryBehaviour& record = m_records[m_awaitingIsolation[i]];
+            if (pathTraversals[record.nodeId] > 0) {
+                i++;
+                continue;
+            }
+            record.isolatedS = nowS;
+            record.dropsBeforeIsolation = record.packetsDropped;
+            m_awaitingIsolation[i] = m_awaitingIsolation.back();
+            m_awaitingIsolation.pop_back();
         }
-        
-        return false;
     }
     
-    const std::set<uint32_t>& GetBlackholes() const {
-        return m_blackholes;
+    /**
+     * Honest nodes the ledger flagged at least once
+     */
+    uint32_t GetFalseFlags() const {
+        return m_falseFlags;
+    }
+    
+    std::vector<AdversaryBehaviour>& GetRecords() {
+        return m_records;
+    }
+    
+    const std::vector<AdversaryBehaviour>& GetRecords() const {
+        return m_records;
+    }
+    
+private:
+    /**
+     * SplitMix64 finaliser (counter-based coin flips)
+     */
+    static uint64_t Mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+    
+    AttackModel m_model;
+    bool m_packetLevel;
+    uint64_t m_seed;
+    std::vector<uint32_t> m_slot;              // Node ID -> record index (UINT32_MAX = honest)
+    std::vector<AdversaryBehaviour> m_records;
+    std::vector<uint8_t> m_everFlagged;        // Node ID -> flagged by the ledger at least once
+    uint32_t m_falseFlags;
+    std::vector<uint32_t> m_awaitingIsolation; // Records detected but still on an active path
+};
+
+// ============================================================================
+// Trust Report Authentication (CPU Cost Model)
+// ============================================================================
+// Each heartbeat, the observer of every link with new outcomes signs a trust
+// report and the heartbeat's block is signed once more. Every node verifies all
+// of these signatures before the block reaches its ledger copy. No signature
+// library is vendored, so the costs come from the Ed25519 cycle counts
+// (Bernstein et al., "High-speed high-security signatures"): 87548 cycles to
+// sign, 273364 to verify and 134000 per signature in batches of 64. They are
+// scaled to --authCpuGhz. Verification runs on --authCores cores and queues
+// behind earlier blocks, so a node that cannot keep up delays every later commit.
+
+enum class AuthMode {
+    None,     // Updates are free and trusted (commit at the heartbeat)
+    Single,   // One verification per signature
+    Batch     // Batch verification in groups of --authBatchSize
+};
+
+/**
+ * AuthenticationModel: Signature cost and commit delay of heartbeat blocks
+ */
+class AuthenticationModel {
+public:
+    static constexpr double kSignCycles = 87548.0;
+    static constexpr double kVerifyCycles = 273364.0;
+    static constexpr double kBatchVerifyCycles = 134000.0;  // Per signature in a batch of 64
+    
+    AuthenticationModel() : m_mode(AuthMode::None), m_cpuGhz(3.0), m_cores(1), m_batchSize(64),
+                            m_busyUntilNs(0), m_reports(0), m_blocks(0), m_verifyCpuNs(0.0),
+                            m_commitDelaySumNs(0.0), m_maxCommitDelayNs(0.0) {}
+    
+    static bool ParseMode(const std::string& name, AuthMode& mode) {
+        static const std::map<std::string, AuthMode> modes = {
+            {"none", AuthMode::None}, {"single", AuthMode::Single}, {"batch", AuthMode::Batch}};
+        auto it = modes.find(name);
+        if (it == modes.end()) return false;
+        mode = it->second;
+        return true;
+    }
+    
+    static const char* ModeName(AuthMode mode) {
+        switch (mode) {
+        case AuthMode::None: return "none";
+        case AuthMode::Single: return "single";
+        case AuthMode::Batch: return "batch";
+        }
+        return "unknown";
+    }
+    
+    void Configure(AuthMode mode, double cpuGhz, uint32_t cores, uint32_t batchSize) {
+        m_mode = mode;
+        m_cpuGhz = cpuGhz;
+        m_cores = std::max(cores, 1u);
+        m_batchSize = std::max(batchSize, 1u);
+    }
+    
+    bool IsEnabled() const {
+        return m_mode != AuthMode::None;
+    }
+    
+    AuthMode GetMode() const {
+        return m_mode;
+    }
+    
+    /**
+     * Cycles to verify n signatures as one batch
+     * Marginal cost is fitted so that a batch of 64 averages kBatchVerifyCycles
+     * and a batch of one costs a single verification.
+     */
+    static double BatchCycles(uint64_t n) {
+        const double marginal = (64.0 * kBatchVerifyCycles - kVerifyCycles) / 63.0;
+        return n == 0 ? 0.0 : kVerifyCycles + (n - 1) * marginal;
+    }
+    
+    /**
+     * Queue one heartbeat block; returns the delay until nodes commit it
+     */
+    Time Submit(Time now, uint64_t reports) {
+        uint64_t signatures = reports + 1;  // Reports plus the block signature
+        double cycles;
+        double unitCycles;  // Smallest unit of work one core must finish alone
+        if (m_mode == AuthMode::Batch) {
+            uint64_t fullBatches = signatures / m_batchSize;
+            uint64_t rest = signatures % m_batchSize;
+            cycles = fullBatches * BatchCycles(m_batchSize) + BatchCycles(rest);
+            unitCycles = BatchCycles(std::min<uint64_t>(signatures, m_batchSize));
+        } else {
+            cycles = signatures * kVerifyCycles;
+            unitCycles = kVerifyCycles;
+        }
+        double verifyNs = cycles / m_cpuGhz;
+        double elapsedNs = std::max(verifyNs / m_cores, unitCycles / m_cpuGhz);
+        
+        // Observer signs its report, then the proposer signs the block
+        int64_t nowNs = now.GetNanoSeconds();
+        int64_t readyNs = nowNs + static_cast<int64_t>(2.0 * kSignCycles / m_cpuGhz);
+        int64_t commitNs = std::max(readyNs, m_busyUntilNs) + static_cast<int64_t>(std::ceil(elapsedNs));
+        m_busyUntilNs = commitNs;
+        
+        double delayNs = static_cast<double>(commitNs - nowNs);
+        m_reports += reports;
+        m_blocks++;
+        m_verifyCpuNs += verifyNs;
+        m_commitDelaySumNs += delayNs;
+        m_maxCommitDelayNs = std::max(m_maxCommitDelayNs, delayNs);
+        return NanoSeconds(commitNs - nowNs);
+    }
+    
+    uint32_t GetCores() const { return m_cores; }
+    uint64_t GetReports() const { return m_reports; }
+    uint64_t GetBlocks() const { return m_blocks; }
+    double GetVerifyCpuNs() const { return m_verifyCpuNs; }
+    double GetCommitDelaySumNs() const { return m_commitDelaySumNs; }
+    double GetMaxCommitDelayNs() const { return m_maxCommitDelayNs; }
+    
+private:
+    AuthMode m_mode;
+    double m_cpuGhz;
+    uint32_t m_cores;
+    uint32_t m_batchSize;
+    int64_t m_busyUntilNs;       // Verification queue drains at this time
+    uint64_t m_reports;
+    uint64_t m_blocks;
+    double m_verifyCpuNs;        // Verification CPU time per node (all cores)
+    double m_commitDelaySumNs;
+    double m_maxCommitDelayNs;
+};
+
+// ============================================================================
+// MANET Routing Baselines (AODV, OLSR, DSDV)
+// ============================================================================
+// The default baseline is the hop-count Dijkstra of the heartbeat installed as
+// static routes: it sees the whole topology for free and repairs routes within
+// one heartbeat. --baseline=aodv|olsr|dsdv installs the ns-3 protocol instead;
+// the heartbeat then leaves the routing tables alone and the protocol pays for
+// discovery with its own control packets. Control packets are recognised by
+// their UDP port and counted at every IPv4 transmission (origin and relays).
+// Route acquisition is the time from a flow's first transmission to its first
+// delivery, the same measure for the static and the protocol baselines.
+
+enum class BaselineProtocol {
+    Static,   // Heartbeat routes (hop count, or the trust-aware cost when proposed)
+    Aodv,     // Reactive: RREQ flood on demand, data buffered during discovery
+    Olsr,     // Proactive link state over MPRs (HELLO 2 s, TC 5 s)
+    Dsdv      // Proactive distance vector with periodic full dumps
+};
+
+/**
+ * RoutingBaseline: Selected protocol, control overhead and route acquisition per flow
+ */
+class RoutingBaseline {
+public:
+    static constexpr uint16_t kAodvPort = 654;
+    static constexpr uint16_t kOlsrPort = 698;
+    static constexpr uint16_t kDsdvPort = 269;
+    
+    RoutingBaseline() : m_protocol(BaselineProtocol::Static), m_controlPort(0), m_controlPackets(0),
+                        m_controlBytes(0), m_awaitingTx(0), m_awaitingRx(0) {}
+    
+    static bool ParseProtocol(const std::string& name, BaselineProtocol& protocol) {
+        static const std::map<std::string, BaselineProtocol> protocols = {
+            {"static", BaselineProtocol::Static}, {"aodv", BaselineProtocol::Aodv},
+            {"olsr", BaselineProtocol::Olsr}, {"dsdv", BaselineProtocol::Dsdv}};
+        auto it = protocols.find(name);
+        if (it == protocols.end()) return false;
+        protocol = it->second;
+        return true;
+    }
+    
+    static const char* ProtocolName(BaselineProtocol protocol) {
+        switch (protocol) {
+        case BaselineProtocol::Static: return "static";
+        case BaselineProtocol::Aodv: return "aodv";
+        case BaselineProtocol::Olsr: return "olsr";
+        case BaselineProtocol::Dsdv: return "dsdv";
+        }
+        return "unknown";
+    }
+    
+    void Configure(BaselineProtocol protocol) {
+        m_protocol = protocol;
+        m_controlPort = protocol == BaselineProtocol::Aodv ? kAodvPort
+                      : protocol == BaselineProtocol::Olsr ? kOlsrPort
+                      : protocol == BaselineProtocol::Dsdv ? kDsdvPort : 0;
+        m_controlPackets = 0;
+        m_controlBytes = 0;
+    }
+    
+    /**
+     * Track route acquisition of numFlows flows (0 = disabled)
+     */
+    void TrackFlows(size_t numFlows) {
+        m_firstTxNs.assign(numFlows, -1);
+        m_firstRxNs.assign(numFlows, -1);
+        m_awaitingTx = numFlows;
+        m_awaitingRx = numFlows;
+    }
+    
+    BaselineProtocol GetProtocol() const {
+        return m_protocol;
+    }
+    
+    /**
+     * True if a MANET protocol owns the routing tables (heartbeat routes disabled)
+     */
+    bool IsProtocol() const {
+        return m_protocol != BaselineProtocol::Static;
+    }
+    
+    /**
+     * Count an IPv4 transmission if it carries the protocol's control traffic
+     * Reads the IPv4 and UDP headers in place (no packet copy)
+     */
+    void OnIpTx(Ptr<const Packet> packet) {
+        uint8_t bytes[24];
+        if (packet->CopyData(bytes, sizeof(bytes)) < sizeof(bytes)) return;
+        uint32_t ipHeaderBytes = (bytes[0] & 0x0f) * 4u;
+        if (bytes[9] != UdpL4Protocol::PROT_NUMBER || ipHeaderBytes + 4 > sizeof(bytes)) return;
+        uint16_t destPort = (bytes[ipHeaderBytes + 2] << 8) | bytes[ipHeaderBytes + 3];
+        if (destPort != m_controlPort) return;
+        m_controlPackets++;
+        m_controlBytes += packet->GetSize();
+    }
+    
+    bool AwaitingTx() const { return m_awaitingTx > 0; }
+    bool AwaitingRx() const { return m_awaitingRx > 0; }
+    
+    void OnFlowTx(uint32_t flowIdx, int64_t nowNs) {
+        if (flowIdx < m_firstTxNs.size() && m_firstTxNs[flowIdx] < 0) {
+            m_firstTxNs[flowIdx] = nowNs;
+            m_awaitingTx--;
+        }
+    }
+    
+    void OnFlowRx(uint32_t flowIdx, int64_t nowNs) {
+        if (flowIdx < m_firstRxNs.size() && m_firstRxNs[flowIdx] < 0) {
+            m_firstRxNs[flowIdx] = nowNs;
+            m_awaitingRx--;
+        }
+    }
+    
+    /**
+     * Route acquisition latency (ms) of every flow that delivered at least once
+     */
+    std::vector<double> GetAcquisitionMs() const {
+        std::vector<double> latencies;
+        for (size_t i = 0; i < m_firstRxNs.size(); i++) {
+            if (m_firstRxNs[i] >= 0 && m_firstTxNs[i] >= 0) {
+                latencies.push_back((m_firstRxNs[i] - m_firstTxNs[i]) / 1e6);
+            }
+        }
+        return latencies;
+    }
+    
+    size_t GetTrackedFlows() const { return m_firstTxNs.size(); }
+    uint64_t GetControlPackets() const { return m_controlPackets; }
+    uint64_t GetControlBytes() const { return m_controlBytes; }
+    
+private:
+    BaselineProtocol m_protocol;
+    uint16_t m_controlPort;           // UDP port of the protocol's control packets (0 = static)
+    uint64_t m_controlPackets;        // Control transmissions, relays included
+    uint64_t m_controlBytes;          // IPv4 bytes of those transmissions
+    std::vector<int64_t> m_firstTxNs; // Flow index -> first application transmission (-1 = none yet)
+    std::vector<int64_t> m_firstRxNs; // Flow index -> first delivery (-1 = none yet)
+    size_t m_awaitingTx;              // Flows without a transmission yet
+    size_t m_awaitingRx;              // Flows without a delivery yet
+};
+
+// ============================================================================
+// Directional Antenna Sectors
+// ============================================================================
+// The default PHY models 60 GHz beamforming as an isotropic +30 dBi on both
+// ends, so every transmission reaches every receiver with full gain. With
+// --antenna=sector the links of the current flow paths are trained: both ends
+// beamform at each other per link (a relay turns its receive beam to the
+// previous hop and its transmit beam to the next), so a trained hop keeps the
+// full main-lobe gain the routing range assumes. Every other pair sees each
+// node's resting beam, steered at its busiest path neighbour (its next hop,
+// or the previous hop at a destination), through a sector pattern: a
+// parabolic main lobe (3GPP TR 38.901) floored at the side lobe level. Nodes
+// off every path stay quasi-omni. The pattern is tabulated per whole degree
+// off boresight, and the azimuth of each node pair is computed once per
+// mobility epoch, so a reception costs two table lookups and no trigonometry.
+
+/**
+ * SectorAntennaModel: Beam directions and precomputed sector gains of all nodes
+ */
+class SectorAntennaModel {
+public:
+    static constexpr uint16_t kNoBeam = UINT16_MAX;  // Quasi-omni (not on any path)
+    
+    SectorAntennaModel() : m_enabled(false), m_omniDbi(0.0), m_mobility(nullptr), m_lookups(0),
+                           m_angleMisses(0), m_beamChanges(0), m_steeredNodes(0), m_trainedLookups(0) {
+        m_gainDb.fill(0.0);
+    }
+    
+    /**
+     * Tabulate the pattern: gain - 12 (offset / beamwidth)^2 dB, at least the side lobe level
+     */
+    void Configure(double gainDbi, double beamwidthDeg, double sideLobeDbi, double omniDbi,
+                   uint32_t numNodes, const MobilitySnapshot* mobility) {
+        for (size_t offset = 0; offset < m_gainDb.size(); offset++) {
+            double ratio = offset / beamwidthDeg;
+            m_gainDb[offset] = std::max(gainDbi - 12.0 * ratio * ratio, sideLobeDbi);
+        }
+        m_omniDbi = omniDbi;
+        m_beam.assign(numNodes, kNoBeam);
+        m_mobility = mobility;
+        m_enabled = true;
+    }
+    
+    bool IsEnabled() const { return m_enabled; }
+    
+    /**
+     * Train the links of the flow paths and steer every node's resting beam at
+     * its busiest neighbour on them (ties: lowest ID)
+     */
+    void UpdateBeams(const std::vector<std::vector<uint32_t>>& paths) {
+        m_uses.clear();
+        m_trained.clear();
+        for (const std::vector<uint32_t>& path : paths) {
+            for (size_t h = 0; h + 1 < path.size(); h++) {
+                uint64_t from = path[h];
+                uint64_t to = path[h + 1];
+                m_uses.push_back(std::make_pair((from << 32) | to, 2));  // Next hops first, previous hops for receivers
+                m_uses.push_back(std::make_pair((to << 32) | from, 1));
+                m_trained.insert((std::min(from, to) << 32) | std::max(from, to));
+            }
+        }
+        std::sort(m_uses.begin(), m_uses.end());
+        m_steeredNodes = 0;
+        size_t u = 0;
+        for (uint32_t n = 0; n < m_beam.size(); n++) {
+            uint32_t target = UINT32_MAX;
+            uint32_t count = 0;
+            while (u < m_uses.size() && (m_uses[u].first >> 32) == n) {
+                uint64_t neighbour = m_uses[u].first;
+                uint32_t uses = 0;
+                for (; u < m_uses.size() && m_uses[u].first == neighbour; u++) {
+                    uses += m_uses[u].second;
+                }
+                if (uses > count) {
+                    target = static_cast<uint32_t>(neighbour);
+                    count = uses;
+                }
+            }
+            uint16_t beam = target != UINT32_MAX ? Azimuth(n, target) : kNoBeam;
+            if (beam != m_beam[n]) {
+                m_beamChanges++;
+                m_beam[n] = beam;
+            }
+            m_steeredNodes += beam != kNoBeam ? 1 : 0;
+        }
+    }
+    
+    /**
+     * Transmit plus receive antenna gain in dB from node a to node b
+     */
+    double GetPairGainDb(uint32_t a, uint32_t b) {
+        m_lookups++;
+        if (!m_trained.empty() &&
+            m_trained.count((static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b))) {
+            m_trainedLookups++;
+            return 2.0 * m_gainDb[0];
+        }
+        if (m_beam[a] == kNoBeam && m_beam[b] == kNoBeam) {
+            return 2.0 * m_omniDbi;
+        }
+        uint16_t azimuth = Azimuth(a, b);
+        return NodeGainDb(a, azimuth) + NodeGainDb(b, (azimuth + 180) % 360);
+    }
+    
+    uint64_t GetLookups() const { return m_lookups; }
+    uint64_t GetAngleMisses() const { return m_angleMisses; }
+    uint64_t GetBeamChanges() const { return m_beamChanges; }
+    uint32_t GetSteeredNodes() const { return m_steeredNodes; }
+    size_t GetTrainedLinks() const { return m_trained.size(); }
+    uint64_t GetTrainedLookups() const { return m_trainedLookups; }
+    
+private:
+    struct CachedAzimuth {
+        uint64_t epoch;
+        uint16_t degrees;  // Azimuth of the higher node ID as seen from the lower one
+    };
+    
+    /**
+     * Whole-degree azimuth of node to as seen from node from, cached per mobility epoch
+     */
+    uint16_t Azimuth(uint32_t from, uint32_t to) {
+        uint32_t lo = std::min(from, to);
+        uint32_t hi = std::max(from, to);
+        CachedAzimuth& cached = m_azimuths[(static_cast<uint64_t>(lo) << 32) | hi];
+        if (cached.epoch != m_mobility->epoch) {  // Epochs start at 1, new entries at 0
+            m_angleMisses++;
+            const NodePosition& p = m_mobility->positions[lo];
+            const NodePosition& q = m_mobility->positions[hi];
+            long degrees = std::lround(std::atan2(q.y - p.y, q.x - p.x) * 180.0 / M_PI);
+            cached.epoch = m_mobility->epoch;
+            cached.degrees = static_cast<uint16_t>((degrees + 360) % 360);
+        }
+        return from == lo ? cached.degrees : (cached.degrees + 180) % 360;
+    }
+    
+    double NodeGainDb(uint32_t node, uint16_t azimuth) const {
+        uint16_t beam = m_beam[node];
+        if (beam == kNoBeam) {
+            return m_omniDbi;
+        }
+        uint32_t offset = (azimuth + 360 - beam) % 360;
+        return m_gainDb[offset > 180 ? 360 - offset : offset];
+    }
+    
+    bool m_enabled;
+    std::array<double, 181> m_gainDb;  // Whole degrees off boresight -> gain (dBi)
+    double m_omniDbi;                  // Gain of nodes without a beam
+    std::vector<uint16_t> m_beam;      // Node ID -> boresight azimuth in degrees (kNoBeam = quasi-omni)
+    std::unordered_map<uint64_t, CachedAzimuth> m_azimuths;  // (lo << 32 | hi) -> azimuth
+    const MobilitySnapshot* m_mobility;  // Heartbeat positions the azimuths are taken from
+    uint64_t m_lookups;       // Pair gains requested by the channel
+    uint64_t m_angleMisses;   // Azimuths (re)computed
+    uint64_t m_beamChanges;   // Beams re-steered
+    uint32_t m_steeredNodes;  // Nodes with a beam after the last update
+    uint64_t m_trainedLookups;  // Pair gains served at full main-lobe gain
+    std::vector<std::pair<uint64_t, uint32_t>> m_uses;  // (node << 32 | neighbour, weight), reused per update
+    std::unordered_set<uint64_t> m_trained;  // (lo << 32 | hi) of the links on the current paths
+};
+
+// ============================================================================
+// Obstacle and Human-Body Blockage
+// ============================================================================
+// 60 GHz links do not get through walls, vehicles or people. With
+// --obstacles=<file> static obstacles are read from a scenario file as
+// axis-aligned rectangular footprints, one per line ("xmin ymin xmax ymax
+// [lossDb]", '#' starts a comment), and every obstacle a link crosses adds its
+// loss. With --bodyBlockage=true each node is carried by a person, a disc of
+// --bodyRadius metres that adds --bodyLossDb to any other link passing through
+// it. Obstacles sit in a bounding volume hierarchy built once at startup;
+// bodies are binned into a uniform grid rebuilt once per mobility epoch, and a
+// link only tests the bodies in the grid cells its segment crosses. The loss of
+// a node pair is cached per epoch, so a reception costs one hash lookup and the
+// geometry runs at most once per link and heartbeat.
+
+/**
+ * BlockageModel: Line-of-sight tests against static obstacles and moving bodies
+ */
+class BlockageModel {
+public:
+    BlockageModel() : m_enabled(false), m_bodies(false), m_bodyRadius(0.0), m_bodyLossDb(0.0), m_mobility(nullptr),
+                      m_gridEpoch(0), m_cellSize(1.0), m_originX(0.0), m_originY(0.0), m_gridX(0), m_gridY(0),
+                      m_stamp(0), m_lookups(0), m_tests(0), m_blockedTests(0), m_bodyCrossings(0), m_testNs(0.0) {}
+    
+    /**
+     * Read obstacle footprints and build the BVH (false with a message on a malformed file)
+     */
+    bool LoadObstacles(const std::string& path, double defaultLossDb, std::string& error) {
+        std::ifstream in(path);
+        if (!in) {
+            error = path + ": not found";
+            return false;
+        }
+        std::string line;
+        for (uint32_t lineNo = 1; std::getline(in, line); lineNo++) {
+            line = line.substr(0, line.find('#'));
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            std::istringstream fields(line);
+            Obstacle obstacle;
+            if (!(fields >> obstacle.box.minX >> obstacle.box.minY >> obstacle.box.maxX >> obstacle.box.maxY) ||
+                obstacle.box.maxX < obstacle.box.minX || obstacle.box.maxY < obstacle.box.minY) {
+                error = path + ":" + std::to_string(lineNo) + ": expected xmin ymin xmax ymax [lossDb]";
+                return false;
+            }
+            if (!(fields >> obstacle.lossDb)) {
+                obstacle.lossDb = defaultLossDb;
+            }
+            m_obstacles.push_back(obstacle);
+        }
+        m_bvh.clear();
+        if (!m_obstacles.empty()) {
+            BuildBvh(0, m_obstacles.size());
+        }
+        return true;
+    }
+    
+    void Configure(bool bodies, double bodyRadius, double bodyLossDb, uint32_t numNodes,
+                   const MobilitySnapshot* mobility) {
+        m_bodies = bodies;
+        m_bodyRadius = bodyRadius;
+        m_bodyLossDb = bodyLossDb;
+        m_seen.assign(numNodes, 0);
+        m_mobility = mobility;
+        m_enabled = true;
+    }
+    
+    bool IsEnabled() const { return m_enabled; }
+    
+    /**
+     * Blockage loss in dB between nodes a and b at the current mobility epoch
+     */
+    double GetLossDb(uint32_t a, uint32_t b) {
+        m_lookups++;
+        if (m_mobility->epoch == 0) {
+            return 0.0;  // No snapshot before the first heartbeat
+        }
+        uint32_t lo = std::min(a, b);
+        uint32_t hi = std::max(a, b);
+        CachedLoss& cached = m_losses[(static_cast<uint64_t>(lo) << 32) | hi];
+        if (cached.epoch != m_mobility->epoch) {  // Epochs start at 1, new entries at 0
+            auto start = std::chrono::steady_clock::now();
+            const NodePosition& p = m_mobility->positions[lo];
+            const NodePosition& q = m_mobility->positions[hi];
+            double lossDb = ObstacleLossDb(p, q);
+            if (m_bodies) {
+                uint32_t bodies = BodiesCrossed(lo, hi);
+                m_bodyCrossings += bodies;
+                lossDb += bodies * m_bodyLossDb;
+            }
+            cached.epoch = m_mobility->epoch;
+            cached.lossDb = lossDb;
+            m_tests++;
+            m_blockedTests += lossDb > 0.0 ? 1 : 0;
+            m_testNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+        return cached.lossDb;
+    }
+    
+    size_t GetNumObstacles() const { return m_obstacles.size(); }
+    size_t GetBvhNodes() const { return m_bvh.size(); }
+    uint64_t GetGridCells() const { return static_cast<uint64_t>(m_gridX) * m_gridY; }
+    uint64_t GetLookups() const { return m_lookups; }
+    uint64_t GetTests() const { return m_tests; }
+    uint64_t GetBlockedTests() const { return m_blockedTests; }
+    uint64_t GetBodyCrossings() const { return m_bodyCrossings; }
+    double GetTestNs() const { return m_testNs; }
+    
+private:
+    static constexpr size_t kBvhLeafSize = 2;
+    
+    struct Box {
+        double minX, minY, maxX, maxY;
+    };
+    
+    struct Obstacle {
+        Box box;
+        double lossDb;
+    };
+    
+    /**
+     * BVH node: a leaf covers count obstacles from first; an inner node's left
+     * child follows it in the array and its right child is at index right
+     */
+    struct BvhNode {
+        Box box;
+        uint32_t first;
+        uint32_t count;   // 0 = inner node
+        uint32_t right;
+    };
+    
+    struct CachedLoss {
+        uint64_t epoch;
+        double lossDb;
+    };
+    
+    /**
+     * Build the subtree over m_obstacles[first, first + count), median split on the longer axis
+     */
+    uint32_t BuildBvh(size_t first, size_t count) {
+        uint32_t index = m_bvh.size();
+        m_bvh.push_back(BvhNode{});
+        Box box = m_obstacles[first].box;
+        for (size_t i = first + 1; i < first + count; i++) {
+            const Box& other = m_obstacles[i].box;
+            box = Box{std::min(box.minX, other.minX), std::min(box.minY, other.minY),
+                      std::max(box.maxX, other.maxX), std::max(box.maxY, other.maxY)};
+        }
+        if (count <= kBvhLeafSize) {
+            m_bvh[index] = BvhNode{box, static_cast<uint32_t>(first), static_cast<uint32_t>(count), 0};
+            return index;
+        }
+        bool splitX = box.maxX - box.minX >= box.maxY - box.minY;
+        auto begin = m_obstacles.begin() + first;
+        std::nth_element(begin, begin + count / 2, begin + count, [splitX](const Obstacle& l, const Obstacle& r) {
+            return splitX ? l.box.minX + l.box.maxX < r.box.minX + r.box.maxX
+                          : l.box.minY + l.box.maxY < r.box.minY + r.box.maxY;
+        });
+        BuildBvh(first, count / 2);
+        uint32_t right = BuildBvh(first + count / 2, count - count / 2);
+        m_bvh[index] = BvhNode{box, 0, 0, right};
+        return index;
+    }
+    
+    /**
+     * Segment origin + t * delta, t in [0, 1], with the inverse deltas precomputed for the slab tests
+     */
+    struct Segment {
+        double x, y;
+        double invDx, invDy;
+        bool alongY, alongX;  // Zero extent in x (or y)
+    };
+    
+    /**
+     * Clip the segment parameter range [t0, t1] to one slab of a box
+     */
+    static bool ClipSlab(double lo, double hi, double origin, double invDelta, bool flat, double& t0, double& t1) {
+        if (flat) {
+            return origin >= lo && origin <= hi;
+        }
+        double ta = (lo - origin) * invDelta;
+        double tb = (hi - origin) * invDelta;
+        t0 = std::max(t0, std::min(ta, tb));
+        t1 = std::min(t1, std::max(ta, tb));
+        return t0 <= t1;
+    }
+    
+    static bool SegmentHitsBox(const Box& box, const Segment& seg) {
+        double t0 = 0.0;
+        double t1 = 1.0;
+        return ClipSlab(box.minX, box.maxX, seg.x, seg.invDx, seg.alongY, t0, t1) &&
+               ClipSlab(box.minY, box.maxY, seg.y, seg.invDy, seg.alongX, t0, t1);
+    }
+    
+    /**
+     * Summed loss of every obstacle the segment p-q crosses
+     */
+    double ObstacleLossDb(const NodePosition& p, const NodePosition& q) const {
+        if (m_bvh.empty()) {
+            return 0.0;
+        }
+        double dx = q.x - p.x;
+        double dy = q.y - p.y;
+        bool alongY = std::abs(dx) < 1e-12;
+        bool alongX = std::abs(dy) < 1e-12;
+        Segment seg{p.x, p.y, alongY ? 0.0 : 1.0 / dx, alongX ? 0.0 : 1.0 / dy, alongY, alongX};
+        double lossDb = 0.0;
+        std::array<uint32_t, 64> stack;  // Median splits keep the depth near log2(obstacles)
+        size_t top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            uint32_t index = stack[--top];
+            const BvhNode& node = m_bvh[index];
+            if (!SegmentHitsBox(node.box, seg)) continue;
+            if (node.count > 0) {
+                for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                    if (SegmentHitsBox(m_obstacles[i].box, seg)) {
+                        lossDb += m_obstacles[i].lossDb;
+                    }
+                }
+            } else {
+                stack[top++] = index + 1;
+                stack[top++] = node.right;
+            }
+        }
+        return lossDb;
+    }
+    
+    /**
+     * Bin every body into the grid cells its disc overlaps (counting sort into m_cellBodies)
+     * The cell edge targets about one node per cell and is at least two body diameters.
+     */
+    void RebuildGrid() {
+        const MobilitySnapshot& snapshot = *m_mobility;
+        uint32_t numNodes = snapshot.positions.size();
+        double minX = std::numeric_limits<double>::max();
+        double minY = std::numeric_limits<double>::max();
+        double maxX = std::numeric_limits<double>::lowest();
+        double maxY = std::numeric_limits<double>::lowest();
+        for (uint32_t n = 0; n < numNodes; n++) {
+            if (!snapshot.valid[n]) continue;
+            minX = std::min(minX, snapshot.positions[n].x);
+            minY = std::min(minY, snapshot.positions[n].y);
+            maxX = std::max(maxX, snapshot.positions[n].x);
+            maxY = std::max(maxY, snapshot.positions[n].y);
+        }
+        if (minX > maxX) {
+            minX = maxX = minY = maxY = 0.0;  // No valid node
+        }
+        m_originX = minX - m_bodyRadius;
+        m_originY = minY - m_bodyRadius;
+        double width = maxX - minX + 2.0 * m_bodyRadius;
+        double height = maxY - minY + 2.0 * m_bodyRadius;
+        m_cellSize = std::max(std::sqrt(width * height / std::max(numNodes, 1u)), 4.0 * m_bodyRadius);
+        m_gridX = static_cast<uint32_t>(width / m_cellSize) + 1;
+        m_gridY = static_cast<uint32_t>(height / m_cellSize) + 1;
+        
+        m_cellStart.assign(m_gridX * m_gridY + 1, 0);
+        for (int pass = 0; pass < 2; pass++) {
+            for (uint32_t n = 0; n < numNodes; n++) {
+                if (!snapshot.valid[n]) continue;
+                const NodePosition& pos = snapshot.positions[n];
+                uint32_t x0 = CellX(pos.x - m_bodyRadius);
+                uint32_t x1 = CellX(pos.x + m_bodyRadius);
+                uint32_t y0 = CellY(pos.y - m_bodyRadius);
+                uint32_t y1 = CellY(pos.y + m_bodyRadius);
+                for (uint32_t cy = y0; cy <= y1; cy++) {
+                    for (uint32_t cx = x0; cx <= x1; cx++) {
+                        uint32_t cell = cy * m_gridX + cx;
+                        if (pass == 0) {
+                            m_cellStart[cell + 1]++;
+                        } else {
+                            m_cellBodies[m_cellFill[cell]++] = n;
+                        }
+                    }
+                }
+            }
+            if (pass == 0) {
+                for (size_t c = 1; c < m_cellStart.size(); c++) {
+                    m_cellStart[c] += m_cellStart[c - 1];
+                }
+                m_cellBodies.resize(m_cellStart.back());
+                m_cellFill.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+            }
+        }
+        m_gridEpoch = snapshot.epoch;
+    }
+    
+    uint32_t CellX(double x) const {
+        return std::min(static_cast<uint32_t>(std::max(0.0, (x - m_originX) / m_cellSize)), m_gridX - 1);
+    }
+    
+    uint32_t CellY(double y) const {
+        return std::min(static_cast<uint32_t>(std::max(0.0, (y - m_originY) / m_cellSize)), m_gridY - 1);
+    }
+    
+    /**
+     * Bodies other than a and b whose disc the segment a-b passes through
+     * Walks the grid cells along the segment (Amanatides-Woo); a body spanning
+     * several visited cells is counted once.
+     */
+    uint32_t BodiesCrossed(uint32_t a, uint32_t b) {
+        if (m_gridEpoch != m_mobility->epoch) {
+            RebuildGrid();
+        }
+        const NodePosition& p = m_mobility->positions[a];
+        const NodePosition& q = m_mobility->positions[b];
+        double dx = q.x - p.x;
+        double dy = q.y - p.y;
+        double lengthSq = dx * dx + dy * dy;
+        int cx = CellX(p.x);
+        int cy = CellY(p.y);
+        int endX = CellX(q.x);
+        int endY = CellY(q.y);
+        int stepX = dx >= 0.0 ? 1 : -1;
+        int stepY = dy >= 0.0 ? 1 : -1;
+        double inf = std::numeric_limits<double>::infinity();
+        double tDeltaX = dx != 0.0 ? m_cellSize / std::abs(dx) : inf;
+        double tDeltaY = dy != 0.0 ? m_cellSize / std::abs(dy) : inf;
+        double tMaxX = dx != 0.0 ? (m_originX + (cx + (stepX > 0 ? 1 : 0)) * m_cellSize - p.x) / dx : inf;
+        double tMaxY = dy != 0.0 ? (m_originY + (cy + (stepY > 0 ? 1 : 0)) * m_cellSize - p.y) / dy : inf;
+        int steps = std::abs(endX - cx) + std::abs(endY - cy);
+        
+        m_stamp++;
+        m_seen[a] = m_stamp;
+        m_seen[b] = m_stamp;
+        double radiusSq = m_bodyRadius * m_bodyRadius;
+        uint32_t crossed = 0;
+        for (int s = 0; ; s++) {
+            uint32_t cell = cy * m_gridX + cx;
+            for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i++) {
+                uint32_t body = m_cellBodies[i];
+                if (m_seen[body] == m_stamp) continue;
+                m_seen[body] = m_stamp;
+                const NodePosition& c = m_mobility->positions[body];
+                double t = lengthSq > 0.0 ? ((c.x - p.x) * dx + (c.y - p.y) * dy) / lengthSq : 0.0;
+                t = std::min(1.0, std::max(0.0, t));
+                double ex = p.x + t * dx - c.x;
+                double ey = p.y + t * dy - c.y;
+                crossed += ex * ex + ey * ey <= radiusSq ? 1 : 0;
+            }
+            if (s == steps) break;
+            if (tMaxX < tMaxY) {
+                cx += stepX;
+                tMaxX += tDeltaX;
+            } else {
+                cy += stepY;
+                tMaxY += tDeltaY;
+            }
+            cx = std::clamp(cx, 0, static_cast<int>(m_gridX) - 1);  // Rounding at cell corners
+            cy = std::clamp(cy, 0, static_cast<int>(m_gridY) - 1);
+        }
+        return crossed;
+    }
+    
+    bool m_enabled;
+    bool m_bodies;                     // Nodes' carriers block other links
+    double m_bodyRadius;
+    double m_bodyLossDb;
+    std::vector<Obstacle> m_obstacles; // Reordered by the BVH build
+    std::vector<BvhNode> m_bvh;        // Root at index 0
+    const MobilitySnapshot* m_mobility;  // Heartbeat positions of nodes and bodies
+    uint64_t m_gridEpoch;              // Epoch the body grid was built for
+    double m_cellSize;
+    double m_originX;
+    double m_originY;
+    uint32_t m_gridX;
+    uint32_t m_gridY;
+    std::vector<uint32_t> m_cellStart;   // Cell -> first entry in m_cellBodies (one extra end entry)
+    std::vector<uint32_t> m_cellFill;    // Fill cursor of the grid build
+    std::vector<uint32_t> m_cellBodies;  // Node IDs per cell
+    std::vector<uint64_t> m_seen;        // Node ID -> stamp of the last query that tested it
+    uint64_t m_stamp;
+    std::unordered_map<uint64_t, CachedLoss> m_losses;  // (lo << 32 | hi) -> loss at an epoch
+    uint64_t m_lookups;        // Pair losses requested by the channel
+    uint64_t m_tests;          // Line-of-sight tests run (cache misses)
+    uint64_t m_blockedTests;   // Tests with at least one obstacle or body in the way
+    uint64_t m_bodyCrossings;  // Bodies found across links
+    double m_testNs;           // Wall time of the tests
+};
+
+// ============================================================================
+// End-to-End ACK Stream
+// ============================================================================
+// By default a delivery is known to the source's heartbeat as soon as the
+// destination's UdpServer trace fires: an oracle, since no packet carries that
+// knowledge back. With --ackMode=sack each destination keeps a receive window
+// per flow and every --ackInterval sends one FlowAckHeader per flow that
+// received data back to the source over the network, along the reverse of the
+// flow path. The header is SACK-style: a cumulative sequence number (every
+// number from the floor up to it arrived) and a bitmap of up to kAckWords x 64
+// numbers above it. Data is never retransmitted, so a hole that falls out of
+// the bitmap is given up on and the floor moves past it. Sources credit their
+// tracked packets only when an ACK covers them; packets still unacknowledged
+// after the detection timeout count as drops. Every ACK repeats the whole
+// window, so a lost ACK is repaired by the next one while its receipts are
+// still in the window. Before receipts are shifted out, the destination sends
+// an immediate ACK carrying them, so a receipt goes uncredited only if that
+// last ACK is lost as well.
+
+const uint16_t kAckPort = 4999;  // ACK socket on every flow endpoint (below the data ports)
+
+/**
+ * FlowAckHeader: Cumulative-plus-bitmap acknowledgement of one flow
+ */
+class FlowAckHeader : public Header {
+public:
+    static constexpr uint32_t kAckWords = 4;  // Bitmap capacity: 256 sequence numbers
+    
+    FlowAckHeader() : m_flow(0), m_floor(0), m_cumulative(0), m_numWords(0) {
+        m_words.fill(0);
+    }
+    
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::FlowAckHeader")
+            .SetParent<Header>()
+            .SetGroupName("Applications")
+            .AddConstructor<FlowAckHeader>();
+        return tid;
+    }
+    
+    TypeId GetInstanceTypeId() const override {
+        return GetTypeId();
+    }
+    
+    uint32_t GetSerializedSize() const override {
+        return 4 + 4 + 4 + 1 + 8 * m_numWords;
+    }
+    
+    void Serialize(Buffer::Iterator start) const override {
+        start.WriteHtonU32(m_flow);
+        start.WriteHtonU32(m_floor);
+        start.WriteHtonU32(m_cumulative);
+        start.WriteU8(m_numWords);
+        for (uint8_t w = 0; w < m_numWords; w++) {
+            start.WriteHtonU64(m_words[w]);
+        }
+    }
+    
+    uint32_t Deserialize(Buffer::Iterator start) override {
+        m_flow = start.ReadNtohU32();
+        m_floor = start.ReadNtohU32();
+        m_cumulative = start.ReadNtohU32();
+        m_numWords = std::min<uint8_t>(start.ReadU8(), kAckWords);
+        for (uint8_t w = 0; w < m_numWords; w++) {
+            m_words[w] = start.ReadNtohU64();
+        }
+        return GetSerializedSize();
+    }
+    
+    void Print(std::ostream& os) const override {
+        os << "flow=" << m_flow << " floor=" << m_floor << " cumulative=" << m_cumulative
+           << " words=" << static_cast<uint32_t>(m_numWords);
+    }
+    
+    /**
+     * True if the ACK reports seq as received
+     */
+    bool Covers(uint32_t seq) const {
+        if (seq < m_floor) return false;
+        if (seq < m_cumulative) return true;
+        uint32_t bit = seq - m_cumulative;
+        return bit < 64u * m_numWords && ((m_words[bit / 64] >> (bit % 64)) & 1);
+    }
+    
+    uint32_t m_flow;
+    uint32_t m_floor;       // Numbers below were given up on or acknowledged by earlier ACKs
+    uint32_t m_cumulative;  // Every number in [m_floor, m_cumulative) was received
+    uint8_t m_numWords;     // Bitmap words sent (only as many as the highest receipt needs)
+    std::array<uint64_t, kAckWords> m_words;  // Bit i of word w: m_cumulative + 64 w + i received
+};
+
+/**
+ * AckStream: Receive windows of local destinations and tracked packets of local sources
+ */
+class AckStream {
+public:
+    static constexpr uint32_t kWindowBits = 64 * FlowAckHeader::kAckWords;
+    
+    AckStream() : m_enabled(false), m_acksSent(0), m_ackBytes(0), m_acksReceived(0), m_ackedPackets(0),
+                  m_abandonedHoles(0), m_overflowAcks(0) {}
+    
+    void Configure(size_t numFlows, Time interval) {
+        m_windows.assign(numFlows, ReceiveWindow());
+        m_interval = interval;
+        m_enabled = true;
+    }
+    
+    bool IsEnabled() const { return m_enabled; }
+    Time GetInterval() const { return m_interval; }
+    
+    /**
+     * Destination: record a received data sequence number
+     * If receipts would leave the window, sendAck(flow) is called first and
+     * must send the flow's ACK (TakeAck) before they are shifted out.
+     */
+    template <class F>
+    void OnDataRx(uint32_t flow, uint32_t seq, F&& sendAck) {
+        if (flow >= m_windows.size()) return;
+        ReceiveWindow& window = m_windows[flow];
+        if (seq < window.cumulative) return;  // Duplicate, or below a given-up hole
+        if (seq - window.cumulative >= kWindowBits) {
+            // Give up on the holes that no longer fit
+            uint32_t shift = seq - window.cumulative - kWindowBits + 1;
+            uint32_t received = 0;
+            for (uint32_t w = 0; w < FlowAckHeader::kAckWords; w++) {
+                uint32_t bits = std::min<uint32_t>(64, shift > 64 * w ? shift - 64 * w : 0);
+                uint64_t mask = bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+                received += __builtin_popcountll(window.words[w] & mask);
+            }
+            if (received > 0 || window.cumulative > window.floor) {
+                // Last chance for the receipts below the new floor: the ACKs that
+                // carried them may have been lost, or none has been sent since
+                window.changed = true;
+                m_overflowAcks++;
+                sendAck(flow);
+            }
+            m_abandonedHoles += shift - received;
+            ShiftDown(window, shift);
+            window.floor = window.cumulative;
+        }
+        uint32_t bit = seq - window.cumulative;
+        window.words[bit / 64] |= 1ULL << (bit % 64);
+        window.highest = std::max(window.highest, seq);
+        window.changed = true;
+        // The cumulative number advances over the received run at the bottom of the bitmap
+        uint32_t run = 0;
+        for (uint32_t w = 0; w < FlowAckHeader::kAckWords; w++) {
+            if (~window.words[w] != 0) {
+                run += __builtin_ctzll(~window.words[w]);
+                break;
+            }
+            run += 64;
+        }
+        ShiftDown(window, run);
+    }
+    
+    /**
+     * Destination: fill the flow's ACK if data arrived since the last one
+     */
+    bool TakeAck(uint32_t flow, FlowAckHeader& header) {
+        ReceiveWindow& window = m_windows[flow];
+        if (!window.changed) return false;
+        window.changed = false;
+        header.m_flow = flow;
+        header.m_floor = window.floor;
+        header.m_cumulative = window.cumulative;
+        header.m_numWords = window.highest >= window.cumulative ? (window.highest - window.cumulative) / 64 + 1 : 0;
+        std::copy_n(window.words.begin(), header.m_numWords, header.m_words.begin());
+        return true;
+    }
+    
+    /**
+     * Source: mark every tracked packet the ACK covers delivered
+     * Tracked packets below the floor are left to the timeout.
+     */
+    void OnAck(const FlowAckHeader& header, PacketTracker& tracker) {
+        m_acksReceived++;
+        uint64_t end = static_cast<uint64_t>(header.m_cumulative) + 64 * header.m_numWords;
+        m_ackedPackets += tracker.MarkCovered(header.m_flow, header.m_floor, end,
+                                              [&header](uint32_t seq) { return header.Covers(seq); });
+    }
+    
+    void CountSent(uint32_t bytes) {
+        m_acksSent++;
+        m_ackBytes += bytes;
+    }
+    
+    uint64_t GetAcksSent() const { return m_acksSent; }
+    uint64_t GetAckBytes() const { return m_ackBytes; }
+    uint64_t GetAcksReceived() const { return m_acksReceived; }
+    uint64_t GetAckedPackets() const { return m_ackedPackets; }
+    uint64_t GetAbandonedHoles() const { return m_abandonedHoles; }
+    uint64_t GetOverflowAcks() const { return m_overflowAcks; }
+    
+private:
+    struct ReceiveWindow {
+        uint32_t floor = 0;        // Last hole given up on + 1
+        uint32_t cumulative = 0;   // Lowest number at or above the floor not received (bit 0)
+        uint32_t highest = 0;      // Highest number received
+        bool changed = false;      // Data arrived since the last ACK
+        std::array<uint64_t, FlowAckHeader::kAckWords> words{};
+    };
+    
+    /**
+     * Move the bitmap base (the cumulative number) up by count
+     */
+    static void ShiftDown(ReceiveWindow& window, uint32_t count) {
+        if (count == 0) return;
+        auto& words = window.words;
+        uint32_t wordShift = count / 64;
+        uint32_t bitShift = count % 64;
+        for (uint32_t w = 0; w < words.size(); w++) {
+            uint32_t from = w + wordShift;
+            uint64_t low = from < words.size() ? words[from] : 0;
+            uint64_t high = from + 1 < words.size() ? words[from + 1] : 0;
+            words[w] = bitShift == 0 ? low : (low >> bitShift) | (high << (64 - bitShift));
+        }
+        window.cumulative += count;
+    }
+    
+    bool m_enabled;
+    Time m_interval;
+    std::vector<ReceiveWindow> m_windows;  // Flow index -> receive window (local destinations)
+    uint64_t m_acksSent;
+    uint64_t m_ackBytes;       // ACK header + UDP + IPv4 bytes sent
+    uint64_t m_acksReceived;
+    uint64_t m_ackedPackets;   // Tracked packets confirmed by an ACK
+    uint64_t m_abandonedHoles; // Missing numbers that fell out of the bitmap unreceived
+    uint64_t m_overflowAcks;   // Immediate ACKs sent before receipts left the window
+};
+
+// ============================================================================
+// Global Simulation Context
+// ============================================================================
+
+/**
+ * PortalLink: Point-to-point link that carries radio links between two MPI partitions
+ */
+struct PortalLink {
+    uint32_t interface;         // Outgoing IPv4 interface on the local end
+    Ipv4Address peerAddress;    // Address of the remote end on this link
+};
+
+struct SimulationContext {
+    NodeContainer nodes;
+    NetDeviceContainer netDevices;
+    Ipv4InterfaceContainer ipv4Interfaces;
+    std::vector<NetDeviceContainer> channelDevices;         // Channel -> one radio per node (channel 0 = netDevices)
+    std::vector<Ipv4InterfaceContainer> channelInterfaces;  // Channel -> radio addresses (channel 0 = ipv4Interfaces)
+    ChannelAssigner channels;   // Link -> channel (multi-channel mode)
+    BlockchainLedger ledger;
+    RoutingEngine routingEngine;
+    std::vector<std::pair<uint32_t, uint32_t>> activeFlows;
+    std::set<uint32_t> blackholeNodes;
+    AdversaryEngine adversary;  // Behaviour records of the malicious nodes
+    AuthenticationModel authentication;  // Signature cost and commit delay of trust updates
+    RoutingBaseline baseline;   // Static heartbeat routes or a MANET routing protocol
+    SectorAntennaModel antenna; // Beam directions and sector gains (--antenna=sector)
+    BlockageModel blockage;     // Obstacle and body losses (--obstacles, --bodyBlockage)
+    AckStream acks;             // End-to-end ACK windows and tracked sequence numbers (--ackMode=sack)
+    std::vector<Ptr<Socket>> ackSockets;  // Node ID -> ACK socket (flow endpoints, --ackMode=sack)
+    std::unordered_map<const MobilityModel*, uint32_t> mobilityToNode;  // Propagation models: mobility -> node ID
+    MobilitySnapshot mobility;  // Positions sampled at the last heartbeat
+    std::unordered_map<uint32_t, uint32_t> addressToNode;  // IPv4 address -> node ID
+    std::unordered_map<uint64_t, uint32_t> macToNode;      // MAC-48 address -> node ID (ledger rate control)
+    std::unordered_map<uint64_t, uint32_t> flowIndex;      // (source << 32 | dest) -> flow index
+    std::vector<std::vector<uint32_t>> flowPaths;          // Flow index -> path of the last heartbeat
+    std::vector<uint32_t> pathTraversals;                  // Node ID -> active paths relaying through it
+    std::unique_ptr<ChainWriter> chainStore;               // Ledger update log (null unless --chainStore)
+    std::unique_ptr<SnapshotRecorder> snapshotRecorder;    // Routing inputs per heartbeat (null unless --recordSnapshots)
+    std::vector<LedgerRecord> ledgerChanges;               // Ledger entries changed in this heartbeat (recording only)
+    double maxRadioRange;
+    double defaultSnr;
+    bool useBlockchain;
+    bool greedyFallback;  // Forward geographically when no static route exists
+    bool sourceRouting;   // Stamp paths into packets instead of writing routing tables
+    bool mprDissemination;  // Model ledger block broadcast over MPR relays
+    MprSelector mpr;        // Multipoint relays of the current graph
+    
+    // Distributed (MPI) mode: geographic strips, one per rank
+    bool distributed;
+    uint32_t rank;
+    uint32_t numPartitions;
+    std::vector<uint32_t> partitionOf;  // Node ID -> owning rank
+    std::set<std::pair<uint32_t, uint32_t>> portalPairs;  // (min, max) node pairs joined by a portal link
+    std::map<std::pair<uint32_t, uint32_t>, PortalLink> portals;  // Directed (from, to) -> portal link
+    
+    SimulationContext() : routingEngine(1.0, 500.0), maxRadioRange(150.0), defaultSnr(20.0), useBlockchain(true),
+                          greedyFallback(false), sourceRouting(false), mprDissemination(false), distributed(false), rank(0), numPartitions(1) {}
+    
+    /**
+     * True if this process simulates the node (always true outside distributed mode)
+     */
+    bool IsLocal(uint32_t nodeId) const {
+        return !distributed || partitionOf[nodeId] == rank;
+    }
+    
+    /**
+     * Node IDs behind the two mobility models of a propagation query
+     */
+    bool NodesOf(const MobilityModel* a, const MobilityModel* b, uint32_t& nodeA, uint32_t& nodeB) const {
+        auto itA = mobilityToNode.find(a);
+        auto itB = mobilityToNode.find(b);
+        if (itA == mobilityToNode.end() || itB == mobilityToNode.end()) {
+            return false;
+        }
+        nodeA = itA->second;
+        nodeB = itB->second;
+        return true;
+    }
+    
+    /**
+     * Channel the link between two nodes transmits on (always 0 with a single channel)
+     */
+    uint32_t LinkChannel(uint32_t a, uint32_t b) const {
+        return channelDevices.size() > 1 ? channels.GetChannel(a, b) : 0;
+    }
+    
+    /**
+     * Replace a flow's path and update the relay counts by the difference
+     */
+    void SetFlowPath(size_t flowIdx, std::vector<uint32_t> path) {
+        std::vector<uint32_t>& current = flowPaths[flowIdx];
+        for (size_t h = 1; h + 1 < current.size(); h++) {
+            pathTraversals[current[h]]--;
+        }
+        for (size_t h = 1; h + 1 < path.size(); h++) {
+            pathTraversals[path[h]]++;
+        }
+        current = std::move(path);
+    }
+};
+
+SimulationContext g_context;
+
+/**
+ * Refresh the per-heartbeat mobility snapshot
+ */
+void TakeMobilitySnapshot() {
+    MobilitySnapshot& snapshot = g_context.mobility;
+    uint32_t numNodes = g_context.nodes.GetN();
+    snapshot.positions.resize(numNodes);
+    snapshot.valid.resize(numNodes);
+    for (uint32_t i = 0; i < numNodes; i++) {
+        Ptr<MobilityModel> mob = g_context.nodes.Get(i)->GetObject<MobilityModel>();
+        if (mob) {
+            Vector pos = mob->GetPosition();
+            snapshot.positions[i].x = pos.x;
+            snapshot.positions[i].y = pos.y;
+            snapshot.positions[i].z = pos.z;
+            snapshot.valid[i] = 1;
+        } else {
+            snapshot.valid[i] = 0;
+        }
+    }
+    snapshot.epoch++;
+    snapshot.time = Simulator::Now().GetSeconds();
+}
+
+// ============================================================================
+// Greedy Geographic Forwarding Fallback
+// ============================================================================
+// When a path breaks between heartbeats, intermediate nodes have no static route
+// and would drop with DROP_NO_ROUTE until the next recompute. This routing
+// protocol sits behind Ipv4StaticRouting in an Ipv4ListRouting and only sees
+// packets the static table cannot route. It picks, in O(degree), the in-range
+// neighbour with the best trust-weighted progress towards the destination,
+// using the heartbeat mobility snapshot and the routing graph adjacency.
+// If no neighbour makes progress, the packet switches to perimeter mode
+// (right-hand rule on the Gabriel-planarised neighbour set, as in GPSR) until
+// it reaches a node closer to the destination than where greedy failed.
+
+/**
+ * GreedyPerimeterTag: Per-packet state for perimeter recovery
+ */
+class GreedyPerimeterTag : public Tag {
+public:
+    GreedyPerimeterTag()
+        : m_perimeter(0), m_entryNode(UINT32_MAX), m_faceDistance(0.0),
+          m_firstEdgeFrom(UINT32_MAX), m_firstEdgeTo(UINT32_MAX), m_prevHop(UINT32_MAX) {}
+    
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::GreedyPerimeterTag")
+            .SetParent<Tag>()
+            .SetGroupName("Internet")
+            .AddConstructor<GreedyPerimeterTag>();
+        return tid;
+    }
+    
+    TypeId GetInstanceTypeId() const override {
+        return GetTypeId();
+    }
+    
+    uint32_t GetSerializedSize() const override {
+        return 1 + 4 + 8 + 4 + 4 + 4;
+    }
+    
+    void Serialize(TagBuffer i) const override {
+        i.WriteU8(m_perimeter);
+        i.WriteU32(m_entryNode);
+        i.WriteDouble(m_faceDistance);
+        i.WriteU32(m_firstEdgeFrom);
+        i.WriteU32(m_firstEdgeTo);
+        i.WriteU32(m_prevHop);
+    }
+    
+    void Deserialize(TagBuffer i) override {
+        m_perimeter = i.ReadU8();
+        m_entryNode = i.ReadU32();
+        m_faceDistance = i.ReadDouble();
+        m_firstEdgeFrom = i.ReadU32();
+        m_firstEdgeTo = i.ReadU32();
+        m_prevHop = i.ReadU32();
+    }
+    
+    void Print(std::ostream& os) const override {
+        os << "perimeter=" << static_cast<uint32_t>(m_perimeter) << " entry=" << m_entryNode
+           << " face=" << m_faceDistance << " prev=" << m_prevHop;
+    }
+    
+    uint8_t m_perimeter;       // 1 = perimeter mode
+    uint32_t m_entryNode;      // Node where greedy failed (Lp)
+    double m_faceDistance;     // Distance to destination of the last face change point (Lf)
+    uint32_t m_firstEdgeFrom;  // First edge traversed on the current face (loop detection)
+    uint32_t m_firstEdgeTo;
+    uint32_t m_prevHop;        // Node the packet came from (perimeter reference edge)
+};
+
+/**
+ * Next Gabriel-graph neighbour counter-clockwise from the reference angle (right-hand rule)
+ */
+uint32_t RightHandNeighbor(uint32_t nodeId, double refAngle, uint32_t prevHop, const std::set<uint32_t>& neighbors) {
+    const MobilitySnapshot& snapshot = g_context.mobility;
+    const NodePosition& self = snapshot.positions[nodeId];
+    uint32_t best = UINT32_MAX;
+    double bestDelta = std::numeric_limits<double>::infinity();
+    for (uint32_t nbr : neighbors) {
+        // Gabriel test: drop edge if another neighbour lies in the circle with diameter (self, nbr)
+        double duv = snapshot.Distance(nodeId, nbr);
+        bool planar = true;
+        for (uint32_t w : neighbors) {
+            if (w == nbr) continue;
+            double duw = snapshot.Distance(nodeId, w);
+            double dvw = snapshot.Distance(nbr, w);
+            if (duw * duw + dvw * dvw < duv * duv) {
+                planar = false;
+                break;
+            }
+        }
+        if (!planar) continue;
+        
+        const NodePosition& pos = snapshot.positions[nbr];
+        double delta = std::atan2(pos.y - self.y, pos.x - self.x) - refAngle;
+        while (delta <= 0.0) delta += 2.0 * M_PI;
+        while (delta > 2.0 * M_PI) delta -= 2.0 * M_PI;
+        if (nbr == prevHop) delta = 2.0 * M_PI;  // Go back only if nothing else exists
+        if (delta < bestDelta) {
+            bestDelta = delta;
+            best = nbr;
+        }
+    }
+    return best;
+}
+
+/**
+ * Distance to c of the intersection of segments (a, b) and (c, d); negative if they do not cross
+ */
+double SegmentCrossingDistance(const NodePosition& a, const NodePosition& b,
+                               const NodePosition& c, const NodePosition& d) {
+    double rX = b.x - a.x, rY = b.y - a.y;
+    double sX = d.x - c.x, sY = d.y - c.y;
+    double denom = rX * sY - rY * sX;
+    if (std::fabs(denom) < 1e-12) return -1.0;
+    double t = ((c.x - a.x) * sY - (c.y - a.y) * sX) / denom;
+    double u = ((c.x - a.x) * rY - (c.y - a.y) * rX) / denom;
+    if (t <= 0.0 || t >= 1.0 || u <= 0.0 || u >= 1.0) return -1.0;
+    double ix = a.x + t * rX, iy = a.y + t * rY;
+    return std::sqrt((ix - d.x) * (ix - d.x) + (iy - d.y) * (iy - d.y));
+}
+
+/**
+ * Select the fallback next hop for a packet at nodeId heading to destId.
+ * Updates the perimeter tag; returns UINT32_MAX if no neighbour is usable.
+ */
+uint32_t SelectGeographicNextHop(uint32_t nodeId, uint32_t destId, GreedyPerimeterTag& tag) {
+    const MobilitySnapshot& snapshot = g_context.mobility;
+    const std::set<uint32_t>* neighbors = g_context.routingEngine.GetNeighbors(nodeId);
+    if (!neighbors || nodeId >= snapshot.positions.size() || destId >= snapshot.positions.size()) {
+        return UINT32_MAX;
+    }
+    if (neighbors->count(destId)) {
+        tag.m_perimeter = 0;
+        return destId;
+    }
+    
+    double selfDistance = snapshot.Distance(nodeId, destId);
+    
+    // Leave perimeter mode once we are closer than where greedy failed
+    if (tag.m_perimeter && tag.m_entryNode < snapshot.positions.size() &&
+        selfDistance < snapshot.Distance(tag.m_entryNode, destId)) {
+        tag.m_perimeter = 0;
+    }
+    
+    if (!tag.m_perimeter) {
+        // Greedy: best trust-weighted progress, O(degree)
+        uint32_t best = UINT32_MAX;
+        double bestScore = 0.0;
+        for (uint32_t nbr : *neighbors) {
+            double progress = selfDistance - snapshot.Distance(nbr, destId);
+            if (progress <= 0.0) continue;
+            double score = progress * g_context.ledger.GetTrust(nodeId, nbr);
+            if (score > bestScore) {
+                bestScore = score;
+                best = nbr;
+            }
+        }
+        if (best != UINT32_MAX) {
+            g_greedyForwards++;
+            return best;
+        }
+        // Local minimum: enter perimeter mode on the face intersected by the line to the destination
+        const NodePosition& self = snapshot.positions[nodeId];
+        const NodePosition& dest = snapshot.positions[destId];
+        uint32_t first = RightHandNeighbor(nodeId, std::atan2(dest.y - self.y, dest.x - self.x), UINT32_MAX, *neighbors);
+        if (first == UINT32_MAX) {
+            return UINT32_MAX;
+        }
+        tag.m_perimeter = 1;
+        tag.m_entryNode = nodeId;
+        tag.m_faceDistance = selfDistance;
+        tag.m_firstEdgeFrom = nodeId;
+        tag.m_firstEdgeTo = first;
+        g_perimeterForwards++;
+        return first;
+    }
+    
+    // Perimeter: right-hand rule from the incoming edge
+    const NodePosition& self = snapshot.positions[nodeId];
+    double refAngle = 0.0;
+    if (tag.m_prevHop < snapshot.positions.size()) {
+        const NodePosition& prev = snapshot.positions[tag.m_prevHop];
+        refAngle = std::atan2(prev.y - self.y, prev.x - self.x);
+    }
+    uint32_t next = RightHandNeighbor(nodeId, refAngle, tag.m_prevHop, *neighbors);
+    
+    // Face change: if the chosen edge crosses the segment (Lp, D) closer to D than
+    // the last face change, switch to the next face at that crossing
+    const NodePosition& entry = snapshot.positions[tag.m_entryNode];
+    const NodePosition& dest = snapshot.positions[destId];
+    bool faceChanged = false;
+    for (size_t guard = 0; next != UINT32_MAX && guard < neighbors->size(); guard++) {
+        double crossing = SegmentCrossingDistance(self, snapshot.positions[next], entry, dest);
+        if (crossing < 0.0 || crossing >= tag.m_faceDistance) {
+            break;
+        }
+        tag.m_faceDistance = crossing;
+        const NodePosition& pos = snapshot.positions[next];
+        next = RightHandNeighbor(nodeId, std::atan2(pos.y - self.y, pos.x - self.x), tag.m_prevHop, *neighbors);
+        tag.m_firstEdgeFrom = nodeId;
+        tag.m_firstEdgeTo = next;
+        faceChanged = true;
+    }
+    if (next == UINT32_MAX) {
+        return UINT32_MAX;
+    }
+    
+    // Traversed the whole face without progress: destination unreachable on this face
+    if (!faceChanged && nodeId == tag.m_firstEdgeFrom && next == tag.m_firstEdgeTo) {
+        return UINT32_MAX;
+    }
+    g_perimeterForwards++;
+    return next;
+}
+
+/**
+ * GreedyFallbackRouting: Lowest-priority routing protocol for geographic fallback
+ */
+class GreedyFallbackRouting : public Ipv4RoutingProtocol {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::GreedyFallbackRouting")
+            .SetParent<Ipv4RoutingProtocol>()
+            .SetGroupName("Internet")
+            .AddConstructor<GreedyFallbackRouting>();
+        return tid;
+    }
+    
+    GreedyFallbackRouting() : m_nodeId(UINT32_MAX) {}
+    
+    void SetNodeId(uint32_t nodeId) {
+        m_nodeId = nodeId;
+    }
+    
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p, const Ipv4Header& header, Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override {
+        GreedyPerimeterTag tag;
+        uint32_t nextHop = NextHop(header.GetDestination(), tag);
+        if (nextHop == UINT32_MAX) {
+            sockerr = Socket::ERROR_NOROUTETOHOST;
+            return nullptr;
+        }
+        if (p) {
+            tag.m_prevHop = m_nodeId;
+            p->ReplacePacketTag(tag);
+        }
+        sockerr = Socket::ERROR_NOTERROR;
+        return MakeRoute(header.GetDestination(), g_context.ipv4Interfaces.GetAddress(m_nodeId), nextHop);
+    }
+    
+    bool RouteInput(Ptr<const Packet> p, const Ipv4Header& header, Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb, const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb, const ErrorCallback& ecb) override {
+        // Malicious nodes never forward (same semantics as skipped static routes);
+        // packet-level attackers have already decided in AdversaryRouting
+        if (g_context.blackholeNodes.count(m_nodeId) && !g_context.adversary.IsPacketLevel()) {
+            return false;
+        }
+        GreedyPerimeterTag tag;
+        p->PeekPacketTag(tag);
+        uint32_t nextHop = NextHop(header.GetDestination(), tag);
+        if (nextHop == UINT32_MAX) {
+            return false;
+        }
+        Ptr<Packet> forwarded = p->Copy();
+        tag.m_prevHop = m_nodeId;
+        forwarded->ReplacePacketTag(tag);
+        ucb(MakeRoute(header.GetDestination(), header.GetSource(), nextHop), forwarded, header);
+        return true;
+    }
+    
+    void NotifyInterfaceUp(uint32_t interface) override {}
+    void NotifyInterfaceDown(uint32_t interface) override {}
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override {}
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override {}
+    
+    void SetIpv4(Ptr<Ipv4> ipv4) override {
+        m_ipv4 = ipv4;
+    }
+    
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const override {
+        *stream->GetStream() << "GreedyFallbackRouting on node " << m_nodeId << " (geographic, no table)" << std::endl;
+    }
+    
+private:
+    uint32_t NextHop(Ipv4Address destination, GreedyPerimeterTag& tag) const {
+        if (!g_context.greedyFallback || m_nodeId == UINT32_MAX) {
+            return UINT32_MAX;
+        }
+        auto it = g_context.addressToNode.find(destination.Get());
+        if (it == g_context.addressToNode.end()) {
+            return UINT32_MAX;
+        }
+        uint32_t nextHop = SelectGeographicNextHop(m_nodeId, it->second, tag);
+        if (nextHop == UINT32_MAX) {
+            g_greedyFailures++;
+        }
+        return nextHop;
+    }
+    
+    Ptr<Ipv4Route> MakeRoute(Ipv4Address destination, Ipv4Address source, uint32_t nextHop) const {
+        Ptr<Ipv4Route> route = Create<Ipv4Route>();
+        route->SetDestination(destination);
+        route->SetSource(source);
+        uint32_t channel = g_context.LinkChannel(m_nodeId, nextHop);
+        route->SetGateway(g_context.channelInterfaces[channel].GetAddress(nextHop));
+        route->SetOutputDevice(g_context.channelDevices[channel].Get(m_nodeId));
+        return route;
+    }
+    
+    Ptr<Ipv4> m_ipv4;
+    uint32_t m_nodeId;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(GreedyFallbackRouting);
+
+/**
+ * GreedyFallbackRoutingHelper: Installs GreedyFallbackRouting into an Ipv4ListRouting
+ */
+class GreedyFallbackRoutingHelper : public Ipv4RoutingHelper {
+public:
+    GreedyFallbackRoutingHelper* Copy() const override {
+        return new GreedyFallbackRoutingHelper(*this);
+    }
+    
+    Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const override {
+        Ptr<GreedyFallbackRouting> routing = CreateObject<GreedyFallbackRouting>();
+        routing->SetNodeId(node->GetId());
+        return routing;
+    }
+};
+
+// ============================================================================
+// Source-Routed Forwarding
+// ============================================================================
+// In source-routing mode the heartbeat no longer writes Ipv4StaticRouting
+// entries. The source stamps the flow's current path into each packet (hop
+// count plus up to kMaxSourceRouteHops node indices of 16 bits each) and every
+// relay pops its next hop from the header in O(1). A path change therefore
+// takes effect atomically per packet, and packets in flight keep the path they
+// were sent with. The route is read from a packet tag, and the origin pads
+// the packet by the header's serialized size so the header bytes take airtime
+// on every hop. Ipv4ListRouting delivers locally before any protocol sees the
+// packet, so the destination drops the padding from its received byte count.
+
+const uint32_t kMaxSourceRouteHops = 16;  // Node indices per header (incl. source and destination)
+
+/**
+ * SourceRouteTag: Compact source route (hop count, cursor, 16-bit node indices)
+ */
+class SourceRouteTag : public Tag {
+public:
+    SourceRouteTag() : m_hopCount(0), m_cursor(0) {
+        m_hops.fill(0);
+    }
+    
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::SourceRouteTag")
+            .SetParent<Tag>()
+            .SetGroupName("Internet")
+            .AddConstructor<SourceRouteTag>();
+        return tid;
+    }
+    
+    TypeId GetInstanceTypeId() const override {
+        return GetTypeId();
+    }
+    
+    uint32_t GetSerializedSize() const override {
+        return 2 + 2 * m_hopCount;
+    }
+    
+    void Serialize(TagBuffer i) const override {
+        i.WriteU8(m_hopCount);
+        i.WriteU8(m_cursor);
+        for (uint32_t h = 0; h < m_hopCount; h++) {
+            i.WriteU16(m_hops[h]);
+        }
+    }
+    
+    void Deserialize(TagBuffer i) override {
+        m_hopCount = i.ReadU8();
+        m_cursor = i.ReadU8();
+        for (uint32_t h = 0; h < m_hopCount; h++) {
+            m_hops[h] = i.ReadU16();
+        }
+    }
+    
+    void Print(std::ostream& os) const override {
+        os << "hops=" << static_cast<uint32_t>(m_hopCount) << " cursor=" << static_cast<uint32_t>(m_cursor);
+    }
+    
+    /**
+     * Fill from a path; returns false if the path does not fit
+     */
+    bool SetPath(const std::vector<uint32_t>& path) {
+        if (path.size() > kMaxSourceRouteHops) {
+            return false;
+        }
+        m_hopCount = static_cast<uint8_t>(path.size());
+        m_cursor = 0;
+        for (size_t h = 0; h < path.size(); h++) {
+            m_hops[h] = static_cast<uint16_t>(path[h]);  // numNodes <= 65536 is checked at startup
+        }
+        return true;
+    }
+    
+    uint8_t m_hopCount;   // Number of node indices in m_hops
+    uint8_t m_cursor;     // Index of the node currently holding the packet
+    std::array<uint16_t, kMaxSourceRouteHops> m_hops;
+};
+
+/**
+ * SourceRouteRouting: Highest-priority protocol that stamps and follows source routes
+ */
+class SourceRouteRouting : public Ipv4RoutingProtocol {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::SourceRouteRouting")
+            .SetParent<Ipv4RoutingProtocol>()
+            .SetGroupName("Internet")
+            .AddConstructor<SourceRouteRouting>();
+        return tid;
+    }
+    
+    SourceRouteRouting() : m_nodeId(UINT32_MAX) {}
+    
+    void SetNodeId(uint32_t nodeId) {
+        m_nodeId = nodeId;
+    }
+    
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p, const Ipv4Header& header, Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override {
+        // Origin: stamp the flow's current path
+        auto destIt = g_context.addressToNode.find(header.GetDestination().Get());
+        if (!p || destIt == g_context.addressToNode.end()) {
+            sockerr = Socket::ERROR_NOROUTETOHOST;
+            return nullptr;
+        }
+        uint64_t key = (static_cast<uint64_t>(m_nodeId) << 32) | destIt->second;
+        auto flowIt = g_context.flowIndex.find(key);
+        if (flowIt == g_context.flowIndex.end()) {
+            sockerr = Socket::ERROR_NOROUTETOHOST;
+            return nullptr;
+        }
+        const std::vector<uint32_t>& path = g_context.flowPaths[flowIt->second];
+        SourceRouteTag tag;
+        if (path.size() < 2 || !tag.SetPath(path)) {
+            if (path.size() > kMaxSourceRouteHops) {
+                g_sourceRouteTooLong++;
+            }
+            sockerr = Socket::ERROR_NOROUTETOHOST;
+            return nullptr;
+        }
+        SourceRouteTag stamped;
+        if (!p->PeekPacketTag(stamped)) {
+            p->AddPaddingAtEnd(tag.GetSerializedSize());  // Header bytes on the wire
+        } else if (stamped.GetSerializedSize() != tag.GetSerializedSize()) {
+            // Re-stamped with a path of another length: resize the padding
+            p->RemoveAtEnd(stamped.GetSerializedSize());
+            p->AddPaddingAtEnd(tag.GetSerializedSize());
+        }
+        p->ReplacePacketTag(tag);
+        g_sourceRoutedPackets++;
+        g_sourceRouteBytes += tag.GetSerializedSize();
+        g_sourceRouteAirBytes += tag.GetSerializedSize();
+        sockerr = Socket::ERROR_NOTERROR;
+        return MakeRoute(header.GetDestination(), g_context.ipv4Interfaces.GetAddress(m_nodeId), path[1]);
+    }
+    
+    bool RouteInput(Ptr<const Packet> p, const Ipv4Header& header, Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb, const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb, const ErrorCallback& ecb) override {
+        SourceRouteTag tag;
+        if (!p->PeekPacketTag(tag)) {
+            return false;  // Not source-routed
+        }
+        // Malicious nodes do not forward (dropped as NO_ROUTE, like skipped static routes);
+        // packet-level attackers have already decided in AdversaryRouting
+        if (g_context.blackholeNodes.count(m_nodeId) && !g_context.adversary.IsPacketLevel()) {
+            return false;
+        }
+        // O(1) pop: the next index after the cursor must be this node's successor
+        uint32_t cursor = tag.m_cursor + 1u;
+        if (cursor + 1 >= tag.m_hopCount || tag.m_hops[cursor] != m_nodeId) {
+            return false;
+        }
+        uint32_t nextHop = tag.m_hops[cursor + 1];
+        tag.m_cursor = static_cast<uint8_t>(cursor);
+        Ptr<Packet> forwarded = p->Copy();
+        forwarded->ReplacePacketTag(tag);
+        g_sourceRouteHops++;
+        g_sourceRouteAirBytes += tag.GetSerializedSize();
+        ucb(MakeRoute(header.GetDestination(), header.GetSource(), nextHop), forwarded, header);
+        return true;
+    }
+    
+    void NotifyInterfaceUp(uint32_t interface) override {}
+    void NotifyInterfaceDown(uint32_t interface) override {}
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override {}
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override {}
+    
+    void SetIpv4(Ptr<Ipv4> ipv4) override {
+        m_ipv4 = ipv4;
+    }
+    
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const override {
+        *stream->GetStream() << "SourceRouteRouting on node " << m_nodeId << " (paths carried in packets)" << std::endl;
+    }
+    
+private:
+    Ptr<Ipv4Route> MakeRoute(Ipv4Address destination, Ipv4Address source, uint32_t nextHop) const {
+        Ptr<Ipv4Route> route = Create<Ipv4Route>();
+        route->SetDestination(destination);
+        route->SetSource(source);
+        uint32_t channel = g_context.LinkChannel(m_nodeId, nextHop);
+        route->SetGateway(g_context.channelInterfaces[channel].GetAddress(nextHop));
+        route->SetOutputDevice(g_context.channelDevices[channel].Get(m_nodeId));
+        return route;
+    }
+    
+    Ptr<Ipv4> m_ipv4;
+    uint32_t m_nodeId;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(SourceRouteRouting);
+
+/**
+ * SourceRouteRoutingHelper: Installs SourceRouteRouting into an Ipv4ListRouting
+ */
+class SourceRouteRoutingHelper : public Ipv4RoutingHelper {
+public:
+    SourceRouteRoutingHelper* Copy() const override {
+        return new SourceRouteRoutingHelper(*this);
+    }
+    
+    Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const override {
+        Ptr<SourceRouteRouting> routing = CreateObject<SourceRouteRouting>();
+        routing->SetNodeId(node->GetId());
+        return routing;
+    }
+};
+
+/**
+ * AdversaryRouting: Highest-priority forward hook of packet-level attackers
+ * Honest nodes and forwarded packets fall through to the next protocol; a drop
+ * goes through the error callback, so it shows up as an L3 Drop trace.
+ */
+class AdversaryRouting : public Ipv4RoutingProtocol {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::AdversaryRouting")
+            .SetParent<Ipv4RoutingProtocol>()
+            .SetGroupName("Internet")
+            .AddConstructor<AdversaryRouting>();
+        return tid;
+    }
+    
+    AdversaryRouting() : m_nodeId(UINT32_MAX) {}
+    
+    void SetNodeId(uint32_t nodeId) {
+        m_nodeId = nodeId;
+    }
+    
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p, const Ipv4Header& header, Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override {
+        sockerr = Socket::ERROR_NOROUTETOHOST;
+        return nullptr;  // Attackers are never flow sources
+    }
+    
+    bool RouteInput(Ptr<const Packet> p, const Ipv4Header& header, Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb, const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb, const ErrorCallback& ecb) override {
+        AdversaryEngine& adversary = g_context.adversary;
+        if (!adversary.IsAttacker(m_nodeId) || !IsDataPacket(p, header)) {
+            return false;  // Routing protocol control traffic is always handled
+        }
+        uint32_t flowIdx = UINT32_MAX;
+        if (adversary.TargetsFlows(m_nodeId)) {
+            auto src = g_context.addressToNode.find(header.GetSource().Get());
+            auto dst = g_context.addressToNode.find(header.GetDestination().Get());
+            if (src != g_context.addressToNode.end() && dst != g_context.addressToNode.end()) {
+                auto flow = g_context.flowIndex.find((static_cast<uint64_t>(src->second) << 32) | dst->second);
+                if (flow != g_context.flowIndex.end()) flowIdx = flow->second;
+            }
+        }
+        if (!adversary.ShouldDrop(m_nodeId, flowIdx, Simulator::Now().GetNanoSeconds())) {
+            return false;  // Forward normally
+        }
+        ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+        return true;
+    }
+    
+    void NotifyInterfaceUp(uint32_t interface) override {}
+    void NotifyInterfaceDown(uint32_t interface) override {}
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override {}
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override {}
+    
+    void SetIpv4(Ptr<Ipv4> ipv4) override {
+        m_ipv4 = ipv4;
+    }
+    
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const override {
+        *stream->GetStream() << "AdversaryRouting on node " << m_nodeId << " (packet-level attack hook)" << std::endl;
+    }
+    
+private:
+    /**
+     * True for UDP packets of the application flows (attackers drop data, not routing control)
+     */
+    static bool IsDataPacket(Ptr<const Packet> p, const Ipv4Header& header) {
+        if (header.GetProtocol() != UdpL4Protocol::PROT_NUMBER) {
+            return false;
+        }
+        UdpHeader udp;
+        p->PeekHeader(udp);
+        return udp.GetDestinationPort() >= kDataBasePort &&
+               udp.GetDestinationPort() < kDataBasePort + g_context.activeFlows.size();
+    }
+    
+    Ptr<Ipv4> m_ipv4;
+    uint32_t m_nodeId;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(AdversaryRouting);
+
+/**
+ * AdversaryRoutingHelper: Installs AdversaryRouting into an Ipv4ListRouting
+ */
+class AdversaryRoutingHelper : public Ipv4RoutingHelper {
+public:
+    AdversaryRoutingHelper* Copy() const override {
+        return new AdversaryRoutingHelper(*this);
+    }
+    
+    Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const override {
+        Ptr<AdversaryRouting> routing = CreateObject<AdversaryRouting>();
+        routing->SetNodeId(node->GetId());
+        return routing;
+    }
+};
+
+// ============================================================================
+// Ledger-Informed Rate Control
+// ============================================================================
+// LedgerRateManager picks the 802.11a mode of each data frame per destination
+// from the ledger's SNR estimate of the link minus a margin, through the same
+// rate table as the ETT link cost. Stations fold the SNR of the frames and
+// ACKs they receive into a local average and write it to the ledger at most
+// every 100 ms (only links the ledger already tracks accept it), so both ends
+// of a link and the routing cost share one estimate. Without a ledger estimate
+// a station probes Minstrel-style: per-mode success probabilities (EWMA,
+// updated every 100 ms), the best expected throughput for normal frames and
+// every tenth frame sent at another mode as a sample. Consecutive failures
+// step the mode down in both cases.
+
+/**
+ * LinkRateStats: Data frames sent over one link, by rate and selection source
+ */
+struct LinkRateStats {
+    static constexpr std::array<uint32_t, 8> kRatesMbps = {6, 9, 12, 18, 24, 36, 48, 54};
+    
+    std::array<uint64_t, 8> frames{};  // Per 802.11a rate (other rates count in the next lower bin)
+    uint64_t ledgerFrames = 0;         // Rate taken from the ledger SNR
+    uint64_t probeFrames = 0;          // Rate chosen by probing
+    uint64_t failures = 0;             // Failed transmission attempts
+    uint64_t lostFrames = 0;           // Frames dropped after the last retry
+    double rateMbpsSum = 0.0;
+    
+    void AddFrame(double rateBps, bool fromLedger, bool delivered) {
+        double mbps = rateBps / 1e6;
+        size_t bin = 0;
+        while (bin + 1 < kRatesMbps.size() && kRatesMbps[bin + 1] <= mbps) bin++;
+        frames[bin]++;
+        (fromLedger ? ledgerFrames : probeFrames)++;
+        lostFrames += delivered ? 0 : 1;
+        rateMbpsSum += mbps;
+    }
+    
+    uint64_t GetFrames() const {
+        return ledgerFrames + probeFrames;
+    }
+};
+
+/**
+ * LedgerRateStation: Per-destination state of LedgerRateManager
+ */
+struct LedgerRateStation : public WifiRemoteStation {
+    uint32_t peer = UINT32_MAX;        // Destination node ID (resolved on first use)
+    std::vector<WifiMode> modes;       // Supported modes, ascending data rate
+    std::vector<double> rateBps;
+    std::vector<uint32_t> attempts;    // Per mode, since the last statistics update
+    std::vector<uint32_t> successes;
+    std::vector<double> probability;   // Per mode EWMA success probability (negative = never sent)
+    uint32_t current = 0;              // Mode of the frame in flight
+    bool fromLedger = false;           // The frame in flight took its mode from the ledger
+    uint32_t probe = 0;                // Probing: mode of the next frame
+    uint32_t best = 0;                 // Probing: highest expected throughput
+    uint32_t probeFrames = 0;
+    uint32_t failStreak = 0;           // Consecutive failed attempts of the frame in flight
+    int64_t nextUpdateNs = 0;
+    bool hasSnr = false;
+    double snrDb = 0.0;                // Local average of the measured SNR
+    int64_t nextLedgerNs = 0;          // Earliest time of the next ledger write
+    LinkRateStats* stats = nullptr;
+};
+
+/**
+ * MAC-48 address as an integer key
+ */
+uint64_t MacKey(const Mac48Address& address) {
+    uint8_t bytes[6];
+    address.CopyTo(bytes);
+    uint64_t key = 0;
+    for (uint8_t byte : bytes) {
+        key = (key << 8) | byte;
+    }
+    return key;
+}
+
+/**
+ * LedgerRateManager: Rate control from the ledger SNR, Minstrel-style probing without it
+ */
+class LedgerRateManager : public WifiRemoteStationManager {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::LedgerRateManager")
+            .SetParent<WifiRemoteStationManager>()
+            .SetGroupName("Wifi")
+            .AddConstructor<LedgerRateManager>()
+            .AddAttribute("SnrMarginDb", "Margin subtracted from the ledger SNR before the rate lookup",
+                          DoubleValue(3.0),
+                          MakeDoubleAccessor(&LedgerRateManager::m_marginDb),
+                          MakeDoubleChecker<double>());
+        return tid;
+    }
+    
+    LedgerRateManager() : m_nodeId(UINT32_MAX), m_marginDb(3.0) {}
+    
+    uint32_t GetNodeId() const { return m_nodeId; }
+    const std::map<uint32_t, LinkRateStats>& GetLinkStats() const { return m_links; }
+    
+private:
+    static constexpr int64_t kUpdateIntervalNs = 100000000;  // Probing statistics and ledger writes
+    static constexpr uint32_t kSampleInterval = 10;          // Probing: one sample frame in ten
+    static constexpr double kEwmaWeight = 0.75;              // Weight of the previous probability
+    static constexpr uint32_t kFailuresPerStep = 2;          // Failed attempts per mode step down
+    
+    WifiRemoteStation* DoCreateStation() const override {
+        return new LedgerRateStation();
+    }
+    
+    /**
+     * Resolve the node IDs and the supported modes once they are known
+     */
+    LedgerRateStation* Prepare(WifiRemoteStation* station) {
+        auto* st = static_cast<LedgerRateStation*>(station);
+        if (m_nodeId == UINT32_MAX) {
+            m_nodeId = GetMac()->GetDevice()->GetNode()->GetId();
+        }
+        if (st->peer == UINT32_MAX) {
+            auto it = g_context.macToNode.find(MacKey(st->m_state->m_address));
+            if (it != g_context.macToNode.end()) {
+                st->peer = it->second;
+                st->stats = &m_links[st->peer];
+            }
+        }
+        if (st->modes.empty() && GetNSupported(st) > 0) {
+            MHz_u width = GetPhy()->GetChannelWidth();
+            for (uint8_t i = 0; i < GetNSupported(st); i++) {
+                st->modes.push_back(GetSupported(st, i));
+            }
+            std::sort(st->modes.begin(), st->modes.end(), [width](const WifiMode& a, const WifiMode& b) {
+                return a.GetDataRate(width) < b.GetDataRate(width);
+            });
+            for (const WifiMode& mode : st->modes) {
+                st->rateBps.push_back(mode.GetDataRate(width));
+            }
+            st->attempts.assign(st->modes.size(), 0);
+            st->successes.assign(st->modes.size(), 0);
+            st->probability.assign(st->modes.size(), -1.0);
+        }
+        return st;
+    }
+    
+    WifiTxVector MakeTxVector(WifiMode mode, MHz_u allowedWidth) const {
+        WifiTxVector txVector;
+        txVector.SetMode(mode);
+        txVector.SetTxPowerLevel(GetDefaultTxPowerLevel());
+        txVector.SetPreambleType(GetPreambleForTransmission(mode.GetModulationClass(), GetShortPreambleEnabled()));
+        txVector.SetChannelWidth(GetPhy()->GetTxBandwidth(mode, allowedWidth));
+        txVector.SetNss(1);
+        txVector.SetNTx(1);
+        return txVector;
+    }
+    
+    /**
+     * Highest mode the table allows at the ledger SNR minus the margin
+     */
+    uint32_t LedgerIndex(const LedgerRateStation* st, double snrDb) const {
+        double targetBps = PhyRateTable::Get().GetRateBps(snrDb - m_marginDb);
+        uint32_t index = 0;
+        while (index + 1 < st->rateBps.size() && st->rateBps[index + 1] <= targetBps) {
+            index++;
+        }
+        return index;
+    }
+    
+    /**
+     * Probing: fold the attempts into the EWMA and pick the best expected throughput
+     */
+    static void UpdateStats(LedgerRateStation* st) {
+        double bestThroughput = 0.0;
+        st->best = 0;
+        for (uint32_t i = 0; i < st->modes.size(); i++) {
+            if (st->attempts[i] > 0) {
+                double ratio = static_cast<double>(st->successes[i]) / st->attempts[i];
+                st->probability[i] = st->probability[i] < 0.0
+                    ? ratio : kEwmaWeight * st->probability[i] + (1.0 - kEwmaWeight) * ratio;
+                st->attempts[i] = 0;
+                st->successes[i] = 0;
+            }
+            double throughput = std::max(st->probability[i], 0.0) * st->rateBps[i];
+            if (throughput > bestThroughput) {
+                bestThroughput = throughput;
+                st->best = i;
+            }
+        }
+    }
+    
+    /**
+     * Probing: mode of the next frame (best throughput, or a sample every kSampleInterval frames)
+     */
+    static void NextProbe(LedgerRateStation* st, int64_t nowNs) {
+        if (nowNs >= st->nextUpdateNs) {
+            UpdateStats(st);
+            st->nextUpdateNs = nowNs + kUpdateIntervalNs;
+        }
+        st->probeFrames++;
+        st->probe = st->best;
+        uint32_t above = st->modes.size() - 1 - st->best;
+        if (st->probeFrames % kSampleInterval == 0 && st->modes.size() > 1) {
+            // Modes above the best in turn; the one below when the best is the fastest
+            st->probe = above > 0 ? st->best + 1 + (st->probeFrames / kSampleInterval) % above : st->best - 1;
+        }
+    }
+    
+    /**
+     * Fold a linear SNR sample into the station average and pass it to the ledger (throttled)
+     */
+    void RecordSnr(LedgerRateStation* st, double snr) {
+        if (!(snr > 0.0)) return;
+        double snrDb = 10.0 * std::log10(snr);
+        st->snrDb = st->hasSnr ? 0.3 * snrDb + 0.7 * st->snrDb : snrDb;
+        st->hasSnr = true;
+        int64_t nowNs = Simulator::Now().GetNanoSeconds();
+        if (st->peer != UINT32_MAX && nowNs >= st->nextLedgerNs) {
+            g_context.ledger.RecordSnr(m_nodeId, st->peer, st->snrDb);
+            st->nextLedgerNs = nowNs + kUpdateIntervalNs;
+        }
+    }
+    
+    /**
+     * Frame delivered or given up: account it and choose the next probing mode
+     */
+    void EndFrame(LedgerRateStation* st, bool delivered) {
+        if (st->modes.empty()) return;
+        if (st->stats) {
+            st->stats->AddFrame(st->rateBps[st->current], st->fromLedger, delivered);
+        }
+        st->failStreak = 0;
+        if (!st->fromLedger) {
+            NextProbe(st, Simulator::Now().GetNanoSeconds());
+        }
+    }
+    
+    WifiTxVector DoGetDataTxVector(WifiRemoteStation* station, MHz_u allowedWidth) override {
+        LedgerRateStation* st = Prepare(station);
+        if (st->modes.empty()) {
+            return MakeTxVector(GetDefaultMode(), allowedWidth);
+        }
+        double ledgerSnr = st->peer != UINT32_MAX ? g_context.ledger.GetMeasuredSnr(m_nodeId, st->peer) : 0.0;
+        st->fromLedger = ledgerSnr > 0.0;
+        uint32_t index = st->fromLedger ? LedgerIndex(st, ledgerSnr) : st->probe;
+        uint32_t steps = st->failStreak / kFailuresPerStep;
+        st->current = index > steps ? index - steps : 0;
+        return MakeTxVector(st->modes[st->current], allowedWidth);
+    }
+    
+    WifiTxVector DoGetRtsTxVector(WifiRemoteStation* station) override {
+        LedgerRateStation* st = Prepare(station);
+        return MakeTxVector(st->modes.empty() ? GetDefaultMode() : st->modes[0], GetPhy()->GetChannelWidth());
+    }
+    
+    void DoReportRxOk(WifiRemoteStation* station, double rxSnr, WifiMode txMode) override {
+        RecordSnr(Prepare(station), rxSnr);
+    }
+    
+    void DoReportRtsFailed(WifiRemoteStation* station) override {}
+    
+    void DoReportDataFailed(WifiRemoteStation* station) override {
+        LedgerRateStation* st = Prepare(station);
+        if (st->modes.empty()) return;
+        st->attempts[st->current]++;
+        st->failStreak++;
+        if (st->stats) st->stats->failures++;
+    }
+    
+    void DoReportRtsOk(WifiRemoteStation* station, double ctsSnr, WifiMode ctsMode, double rtsSnr) override {
+        RecordSnr(Prepare(station), rtsSnr);
+    }
+    
+    void DoReportDataOk(WifiRemoteStation* station, double ackSnr, WifiMode ackMode, double dataSnr,
+                        MHz_u dataChannelWidth, uint8_t dataNss) override {
+        LedgerRateStation* st = Prepare(station);
+        // dataSnr is the peer's measurement of our frame, ackSnr ours of its ACK
+        RecordSnr(st, dataSnr > 0.0 ? dataSnr : ackSnr);
+        if (st->modes.empty()) return;
+        st->attempts[st->current]++;
+        st->successes[st->current]++;
+        EndFrame(st, true);
+    }
+    
+    void DoReportFinalRtsFailed(WifiRemoteStation* station) override {}
+    
+    void DoReportFinalDataFailed(WifiRemoteStation* station) override {
+        EndFrame(Prepare(station), false);
+    }
+    
+    uint32_t m_nodeId;
+    double m_marginDb;
+    std::map<uint32_t, LinkRateStats> m_links;  // Peer node ID -> frames sent to it
+};
+
+NS_OBJECT_ENSURE_REGISTERED(LedgerRateManager);
+
+// ============================================================================
+// Directional Antenna Propagation
+// ============================================================================
+
+/**
+ * SectorAntennaLossModel: Adds both nodes' sector gains after the path loss model
+ */
+class SectorAntennaLossModel : public PropagationLossModel {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::SectorAntennaLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("Propagation")
+            .AddConstructor<SectorAntennaLossModel>();
+        return tid;
+    }
+    
+private:
+    double DoCalcRxPower(double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override {
+        uint32_t tx = 0;
+        uint32_t rx = 0;
+        if (!g_context.NodesOf(PeekPointer(a), PeekPointer(b), tx, rx)) {
+            return txPowerDbm;
+        }
+        return txPowerDbm + g_context.antenna.GetPairGainDb(tx, rx);
+    }
+    
+    int64_t DoAssignStreams(int64_t stream) override {
+        return 0;
+    }
+};
+
+NS_OBJECT_ENSURE_REGISTERED(SectorAntennaLossModel);
+
+/**
+ * BlockageLossModel: Subtracts the obstacle and body losses on the line of sight
+ */
+class BlockageLossModel : public PropagationLossModel {
+public:
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::BlockageLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("Propagation")
+            .AddConstructor<BlockageLossModel>();
+        return tid;
     }
     
 private:
-    std::map<std::pair<uint32_t, uint32_t>, LinkMetric> m_ledger;
-    std::set<uint32_t> m_blackholes;
-    double m_lossThreshold;
-    double m_defaultTrust;
-    double m_defaultSnr;
-    double m_trustFloor;  // Configurable trust floor for ablation study
+    double DoCalcRxPower(double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override {
+        uint32_t tx = 0;
+        uint32_t rx = 0;
+        if (!g_context.NodesOf(PeekPointer(a), PeekPointer(b), tx, rx)) {
+            return txPowerDbm;
+        }
+        return txPowerDbm - g_context.blockage.GetLossDb(tx, rx);
+    }
     
-    std::pair<uint32_t, uint32_t> MakeKey(uint32_t a, uint32_t b) const {
-        return std::make_pair(std::min(a, b), std::max(a, b));
+    int64_t DoAssignStreams(int64_t stream) override {
+        return 0;
     }
 };
 
+NS_OBJECT_ENSURE_REGISTERED(BlockageLossModel);
+
+// ============================================================================
+// Traffic Generation (High-Rate Flows)
+// ============================================================================
+// UdpClient sends fixed-size packets at a fixed interval and costs one
+// simulator event per packet. TrafficGenerator drives a flow with a CBR,
+// Poisson, on/off burst or trace-driven model. Its payload bytes are virtual:
+// ns-3 keeps them as an unallocated zero area and draws buffer storage from its
+// own free list. Packets are built fresh rather than copied from a template,
+// because Copy() keeps the template's UID and AppTxCallback tracks UIDs. With
+// a send quantum, every packet due inside the quantum goes out from the same
+// event, so events scale with 1/quantum instead of with the packet rate. The
+// 12-byte SeqTs header is counted in the packet size, as in UdpClient, so
+// UdpServer loss statistics and the distributed delay measurement still work.
+
+/**
+ * TrafficSend: One entry of a traffic trace (offset from application start)
+ */
+struct TrafficSend {
+    double offsetS;
+    uint32_t size;
+};
+
+/**
+ * Load a traffic trace ("<offset_s> <size_bytes>" per line, '#' starts a comment)
+ */
+std::shared_ptr<const std::vector<TrafficSend>> LoadTrafficTrace(const std::string& fileName) {
+    std::ifstream in(fileName);
+    if (!in) {
+        NS_FATAL_ERROR("Cannot open traffic trace '" << fileName << "'");
+    }
+    auto sends = std::make_shared<std::vector<TrafficSend>>();
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        TrafficSend send;
+        if (!(fields >> send.offsetS)) {
+            continue;  // Blank or comment-only line
+        }
+        if (!(fields >> send.size) || send.offsetS < 0.0 ||
+            (!sends->empty() && send.offsetS < sends->back().offsetS)) {
+            NS_FATAL_ERROR("Malformed traffic trace line in '" << fileName << "': " << line);
+        }
+        sends->push_back(send);
+    }
+    return sends;
+}
+
 /**
- * RoutingEngine: Implements Dijkstra's algorithm for route calculation
+ * TrafficGenerator: UDP source with CBR, Poisson, on/off and trace-driven models
  */
-class RoutingEngine {
+class TrafficGenerator : public Application {
 public:
-    RoutingEngine(double alpha = 1.0, double beta = 500.0) 
-        : m_alpha(alpha), m_beta(beta), m_useBlockchain(true) {}
+    enum class Model { Cbr, Poisson, OnOff, Trace };
     
-    void SetUseBlockchain(bool useBlockchain) {
-        m_useBlockchain = useBlockchain;
+    static TypeId GetTypeId() {
+        static TypeId tid = TypeId("ns3::TrafficGenerator")
+            .SetParent<Application>()
+            .SetGroupName("Applications")
+            .AddConstructor<TrafficGenerator>()
+            .AddTraceSource("Tx", "A new packet is created and sent",
+                            MakeTraceSourceAccessor(&TrafficGenerator::m_txTrace),
+                            "ns3::Packet::TracedCallback");
+        return tid;
     }
     
-    void SetBeta(double beta) {
-        m_beta = beta;
-    }
+    TrafficGenerator()
+        : m_port(0), m_model(Model::Cbr), m_packetSize(1024), m_rateBps(81920.0),
+          m_onMeanS(1.0), m_offMeanS(1.0), m_traceCursor(0), m_seq(0),
+          m_sentPackets(0), m_sentBytes(0), m_sendFailures(0), m_sendEvents(0) {}
     
-    double GetBeta() const {
-        return m_beta;
+    /**
+     * Set destination and traffic model (rate applies to CBR, Poisson and on periods)
+     */
+    void Configure(Ipv4Address destination, uint16_t port, Model model, uint32_t packetSize, double rateBps,
+                   double onMeanS, double offMeanS, Time sendQuantum,
+                   std::shared_ptr<const std::vector<TrafficSend>> trace) {
+        SeqTsHeader seqTs;
+        m_destination = destination;
+        m_port = port;
+        m_model = model;
+        m_packetSize = std::max(packetSize, seqTs.GetSerializedSize());
+        m_rateBps = rateBps;
+        m_onMeanS = onMeanS;
+        m_offMeanS = offMeanS;
+        m_sendQuantum = sendQuantum;
+        m_trace = trace;
     }
     
-    double GetAlpha() const {
-        return m_alpha;
-    }
+    uint64_t GetSentPackets() const { return m_sentPackets; }
+    uint64_t GetSentBytes() const { return m_sentBytes; }
+    uint64_t GetSendFailures() const { return m_sendFailures; }
+    uint64_t GetSendEvents() const { return m_sendEvents; }
     
     /**
-     * Build graph from topology using physical positions
-     * Implements Topology Discovery Logic
+     * Mean offered load of the configured model in bit/s
      */
-    void BuildGraph(NodeContainer& nodes, BlockchainLedger& ledger, double maxRange, 
-                    const std::set<uint32_t>& blackholeNodes, double defaultSnr = 20.0) {
-        m_graph.clear();
-        m_weights.clear();
-        
-        // TASK 4: Reset low trust logging flag for each BuildGraph call
-        g_lowTrustLogged = false;
-        
-        // TASK 1: Reset cost debug logging flag for each BuildGraph call
-        g_costDebugLogged = false;
-        
-        uint32_t numNodes = nodes.GetN();
-        
-        // Iterate through ALL node pairs
-        for (uint32_t i = 0; i < numNodes; i++) {
-            for (uint32_t j = i + 1; j < numNodes; j++) {
-                // Get positions
-                Ptr<MobilityModel> mob1 = nodes.Get(i)->GetObject<MobilityModel>();
-                Ptr<MobilityModel> mob2 = nodes.Get(j)->GetObject<MobilityModel>();
-                
-                if (!mob1 || !mob2) continue;
-                
-                Vector pos1 = mob1->GetPosition();
-                Vector pos2 = mob2->GetPosition();
-                
-                // Calculate physical distance
-                double dx = pos1.x - pos2.x;
-                double dy = pos1.y - pos2.y;
-                double dz = pos1.z - pos2.z;
-                double distance = std::sqrt(dx*dx + dy*dy + dz*dz);
-                
-                // If distance < MaxRadioRange, add edge to graph
-                if (distance < maxRange) {
-                    // FIX: Include ALL edges in graph to maintain connectivity
-                    // Proposed mode will use high weights to discourage routing through blackholes
-                    // Baseline mode will use equal weights (hop count)
-                    
-                    m_graph[i].insert(j);
-                    m_graph[j].insert(i);
-                    
-                    // Get Trust/SNR from Ledger, or use defaults if no data
-                    // IMPORTANT: We do NOT pre-set trust for blackhole nodes here
-                    // System must DETECT them dynamically via trust decay (packet drops)
-                    double trust = ledger.GetTrust(i, j);
-                    
-                    // Calculate SNR based on distance (Physics)
-                    // Since we disabled Oracle SNR updates in PhyRxEndCallback, we calculate it here directly
-                    // This ensures the routing metric still accounts for link quality
-                    double estimatedSnrDb = defaultSnr - (distance / 10.0);
-                    if (estimatedSnrDb < 5.0) estimatedSnrDb = 5.0;
-                    double snrDb = estimatedSnrDb;
-                    
-                    // If Ledger has NO data (new link), use Default Trust (1.0) and Default SNR
-                    // Initially, all nodes have trust = 1.0, including blackholes
-                    // Trust will decay as blackholes drop packets, and system will detect them
-                    if (snrDb <= 0.0) {
-                        snrDb = defaultSnr;
-                    }
-                    // Safety check: Ensure trust is never zero or negative (would cause division by zero)
-                    // Minimum trust is ledger.GetTrustFloor() (safety floor from UpdateMetric)
-                    double trustFloor = ledger.GetTrustFloor();
-                    if (trust <= 0.0) {
-                        trust = 1.0;  // Default for new links
-                    }
-                    // Enforce minimum trust floor to prevent infinite costs
-                    if (trust < trustFloor) {
-                        trust = trustFloor;  // Safety floor - link is expensive but not dead
-                    }
-                    
-                    // TASK 1: Proper SNR Normalization (Mathematically Correct Minimization)
-                    // Normalize SNR: Convert SNR (dB) to normalized quality score [0.01, 1.0]
-                    // This ensures SNR and Trust are in comparable scalar ranges
-                    // MinSNR = 5.0 dB, MaxSNR = 40.0 dB (reasonable range for 60GHz)
-                    const double MinSNR = 5.0;
-                    const double MaxSNR = 40.0;
-                    double snrNorm = std::max(0.01, std::min(1.0, (snrDb - MinSNR) / (MaxSNR - MinSNR)));  // Clamp to [0.01, 1.0]
-                    
-                    // Invert Metrics: Penalize low SNR and low Trust
-                    // Quadratic penalty for bad signal: snrCost = 1.0 / (snrNorm^2)
-                    // Quadratic penalty for bad trust: trustCost = 1.0 / (trust^2)
-                    // High SNR/Trust -> Low Cost (correct minimization)
-                    // Both metrics are now in comparable ranges [0.01, 1.0]
-                    double snrCost = 1.0 / (snrNorm * snrNorm);
-                    double trustCost = 1.0 / (trust * trust);
-                    
-                    // TASK 4: Add "Low Trust" Logging
-                    // Log warning if trust is below threshold (once per BuildGraph call)
-                    if (trust < 0.5 && !g_lowTrustLogged) {
-                        NS_LOG_WARN("Low trust detected: Link " << i << "->" << j << " has trust=" << trust);
-                        g_lowTrustLogged = true;  // Log once per BuildGraph call
-                    }
-                    
-                    // Calculate weight based on routing mode
-                    double cost;
-                    if (m_useBlockchain) {
-                        // TASK 1: Proposed: Blockchain-assisted routing with Trust (Mathematically Correct)
-                        // Cost = (alpha * snrCost) + (beta * trustCost)
-                        // Where snrCost = 1/(snrNorm^2) and trustCost = 1/(trust^2)
-                        // Quadratic inversion naturally handles weighting (low trust spikes cost to infinity)
-                        // Balanced: Beta=500 ensures Bad Trust cost (12,500) is comparable to Bad SNR cost (10,000)
-                        // For nodes with low trust (0.2 after multiple drops), trustCost = 1/(0.2^2) = 25.0, Beta*trustCost = 500*25 = 12,500
-                        // For normal nodes, trust = 1.0, so trustCost = 1/(1.0^2) = 1.0, Beta*trustCost = 500*1 = 500
-                        // For bad SNR (0.01), snrCost = 1/(0.01^2) = 10,000, Alpha*snrCost = 1*10,000 = 10,000
-                        // This balanced approach ensures Trust penalty is comparable to SNR penalty
-                        double snrPart = m_alpha * snrCost;
-                        double trustPart = m_beta * trustCost;
-                        cost = snrPart + trustPart;
-                        
-                        // TASK 1: Debug log (only once per BuildGraph call for one link)
-                        if (!g_costDebugLogged) {
-                            NS_LOG_WARN("Cost Components: SNR_Part=" << std::fixed << std::setprecision(2) << snrPart 
-                                      << ", Trust_Part=" << std::fixed << std::setprecision(2) << trustPart
-                                      << " (Beta=" << m_beta << ", snrNorm=" << std::fixed << std::setprecision(3) << snrNorm
-                                      << ", trust=" << std::fixed << std::setprecision(3) << trust << ")");
-                            g_costDebugLogged = true;
-                        }
-                    } else {
-                        // Baseline: Standard routing (hop count, ignores Trust)
-                        // Cost = 1 (mimics AODV/OLSR behavior, creates vulnerability)
-                        cost = 1.0;
-                    }
-                    
-                    m_weights[std::make_pair(i, j)] = cost;
-                    m_weights[std::make_pair(j, i)] = cost;
-                }
+    double GetOfferedRateBps(double durationS) const {
+        if (m_model == Model::OnOff) {
+            return m_rateBps * m_onMeanS / (m_onMeanS + m_offMeanS);
+        }
+        if (m_model == Model::Trace) {
+            double bytes = 0.0;
+            for (const TrafficSend& send : *m_trace) {
+                if (send.offsetS < durationS) bytes += send.size;
             }
+            return durationS > 0.0 ? bytes * 8.0 / durationS : 0.0;
         }
+        return m_rateBps;
     }
     
-    /**
-     * Calculate path using Dijkstra's algorithm
-     * 
-     * TASK 3: Path Cost Aggregation Logic
-     * Path Cost Aggregation: SUM(LinkCosts). We minimize the additive sum of inverse-quality metrics.
-     * Each link in the path contributes its cost (computed from SNR and Trust) to the total path cost.
-     * Dijkstra's algorithm finds the path with minimum total cost (sum of all link costs).
-     * This ensures that paths with high-quality links (good SNR and high trust) are preferred.
-     * 
-     * Also calculates cost composition (SNR vs Trust parts) for control plane metrics.
-     */
-    std::vector<uint32_t> CalculatePath(uint32_t source, uint32_t dest, BlockchainLedger* ledger = nullptr) {
-        std::vector<uint32_t> path;
-        
-        if (m_graph.find(source) == m_graph.end() || 
-            m_graph.find(dest) == m_graph.end()) {
-            return path;  // Empty path
+private:
+    void StartApplication() override {
+        if (!m_socket) {
+            m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+            m_socket->Bind();
+            m_socket->Connect(InetSocketAddress(m_destination, m_port));
         }
-        
-        // Dijkstra's algorithm
-        std::map<uint32_t, double> dist;
-        std::map<uint32_t, uint32_t> prev;
-        std::set<uint32_t> unvisited;
-        
-        // Initialize distances
-        for (const auto& pair : m_graph) {
-            dist[pair.first] = std::numeric_limits<double>::infinity();
-            prev[pair.first] = UINT32_MAX;
-            unvisited.insert(pair.first);
+        m_interval = Seconds(m_packetSize * 8.0 / m_rateBps);
+        if (m_model == Model::Poisson || m_model == Model::OnOff) {
+            m_exponential = CreateObject<ExponentialRandomVariable>();
         }
-        
-        dist[source] = 0.0;
-        
-        while (!unvisited.empty()) {
-            // Find unvisited node with minimum distance
-            uint32_t u = UINT32_MAX;
-            double minDist = std::numeric_limits<double>::infinity();
-            for (uint32_t node : unvisited) {
-                if (dist[node] < minDist) {
-                    minDist = dist[node];
-                    u = node;
-                }
-            }
-            
-            if (u == UINT32_MAX || minDist == std::numeric_limits<double>::infinity()) {
-                break;  // No path found
-            }
-            
-            if (u == dest) {
-                break;  // Reached destination
-            }
-            
-            unvisited.erase(u);
-            
-            // Update distances to neighbors
-            // TASK 3: Path Cost Aggregation: SUM(LinkCosts)
-            // We minimize the additive sum of inverse-quality metrics.
-            // Each link contributes its cost to the total path cost.
-            // dist[v] = min(dist[v], dist[u] + weight) implements SUM(LinkCosts) minimization
-            if (m_graph.find(u) != m_graph.end()) {
-                for (uint32_t v : m_graph[u]) {
-                    if (unvisited.find(v) != unvisited.end()) {
-                        auto key = std::make_pair(u, v);
-                        double weight = (m_weights.find(key) != m_weights.end()) ? 
-                                       m_weights[key] : std::numeric_limits<double>::infinity();
-                        
-                        // Path Cost Aggregation: Add link cost to path cost
-                        double alt = dist[u] + weight;
-                        if (alt < dist[v]) {
-                            dist[v] = alt;
-                            prev[v] = u;
-                        }
-                    }
-                }
-            }
+        m_start = Simulator::Now();
+        m_traceCursor = 0;
+        m_nextSend = m_start;
+        if (m_model == Model::OnOff) {
+            m_onEnd = m_start + Seconds(m_exponential->GetValue(m_onMeanS, 0.0));
+        } else if (m_model == Model::Trace) {
+            if (m_trace->empty()) return;
+            m_nextSend = m_start + Seconds(m_trace->front().offsetS);
         }
-        
-        // Reconstruct path
-        if (dist[dest] != std::numeric_limits<double>::infinity()) {
-            uint32_t current = dest;
-            while (current != UINT32_MAX) {
-                path.push_back(current);
-                current = prev[current];
-            }
-            std::reverse(path.begin(), path.end());
-            
-            // Control Plane Metrics: Calculate cost composition for this path
-            if (ledger && m_useBlockchain && path.size() > 1) {
-                double totalSnrCost = 0.0;
-                double totalTrustCost = 0.0;
-                
-                // Calculate cost composition for each link in the path
-                for (size_t i = 0; i < path.size() - 1; i++) {
-                    uint32_t u = path[i];
-                    uint32_t v = path[i + 1];
-                    
-                    // Get trust and SNR from ledger
-                    double trust = ledger->GetTrust(u, v);
-                    double snrDb = ledger->GetSnr(u, v);
-                    
-                    // Use same normalization as BuildGraph
-                    const double MinSNR = 5.0;
-                    const double MaxSNR = 40.0;
-                    double snrNorm = std::max(0.01, std::min(1.0, (snrDb - MinSNR) / (MaxSNR - MinSNR)));
-                    
-                    // Calculate cost components
-                    double snrCost = 1.0 / (snrNorm * snrNorm);
-                    double trustCost = 1.0 / (trust * trust);
-                    
-                    totalSnrCost += m_alpha * snrCost;
-                    totalTrustCost += m_beta * trustCost;
-                }
-                
-                // Accumulate for global averages
-                g_avgSnrCostPart += totalSnrCost;
-                g_avgTrustCostPart += totalTrustCost;
-                g_pathCalculations++;
-            }
+        m_sendEvent = Simulator::Schedule(m_nextSend - Simulator::Now(), &TrafficGenerator::SendBatch, this);
+    }
+    
+    void StopApplication() override {
+        Simulator::Cancel(m_sendEvent);
+        if (m_socket) {
+            m_socket->Close();
         }
-        
-        return path;
     }
     
-private:
-    std::map<uint32_t, std::set<uint32_t>> m_graph;  // Adjacency list
-    std::map<std::pair<uint32_t, uint32_t>, double> m_weights;  // Edge weights
-    double m_alpha;
-    double m_beta;
-    bool m_useBlockchain;  // true = Proposed (with Trust), false = Baseline (hop count)
-};
-
-// ============================================================================
-// Global Simulation Context
-// ============================================================================
-
-struct SimulationContext {
-    NodeContainer nodes;
-    NetDeviceContainer netDevices;
-    Ipv4InterfaceContainer ipv4Interfaces;
-    BlockchainLedger ledger;
-    RoutingEngine routingEngine;
-    std::vector<std::pair<uint32_t, uint32_t>> activeFlows;
-    std::set<uint32_t> blackholeNodes;
-    double maxRadioRange;
-    double defaultSnr;
-    bool useBlockchain;
+    /**
+     * Send every packet due before the end of the current quantum, then reschedule
+     */
+    void SendBatch() {
+        m_sendEvents++;
+        Time horizon = Simulator::Now() + m_sendQuantum;
+        do {
+            Send(m_model == Model::Trace ? (*m_trace)[m_traceCursor].size : m_packetSize);
+            if (!Advance()) return;  // Trace exhausted
+        } while (m_nextSend <= horizon);
+        m_sendEvent = Simulator::Schedule(m_nextSend - Simulator::Now(), &TrafficGenerator::SendBatch, this);
+    }
+    
+    void Send(uint32_t size) {
+        SeqTsHeader seqTs;
+        seqTs.SetSeq(m_seq++);
+        size = std::max(size, seqTs.GetSerializedSize());
+        // Virtual payload: Packet(size) records a zero area, no payload bytes are written
+        Ptr<Packet> packet = Create<Packet>(size - seqTs.GetSerializedSize());
+        packet->AddHeader(seqTs);
+        m_txTrace(packet);
+        if (m_socket->Send(packet) >= 0) {
+            m_sentPackets++;
+            m_sentBytes += size;
+        } else {
+            m_sendFailures++;
+        }
+    }
     
-    SimulationContext() : routingEngine(1.0, 500.0), maxRadioRange(150.0), defaultSnr(20.0), useBlockchain(true) {}
+    /**
+     * Move m_nextSend to the following packet; returns false when no packet follows
+     */
+    bool Advance() {
+        switch (m_model) {
+        case Model::Cbr:
+            m_nextSend += m_interval;
+            return true;
+        case Model::Poisson:
+            m_nextSend += Seconds(m_exponential->GetValue(m_interval.GetSeconds(), 0.0));
+            return true;
+        case Model::OnOff:
+            m_nextSend += m_interval;
+            if (m_nextSend > m_onEnd) {
+                // Burst over: silent for an off period, then a new on period
+                m_nextSend = m_onEnd + Seconds(m_exponential->GetValue(m_offMeanS, 0.0));
+                m_onEnd = m_nextSend + Seconds(m_exponential->GetValue(m_onMeanS, 0.0));
+            }
+            return true;
+        case Model::Trace:
+            if (++m_traceCursor >= m_trace->size()) return false;
+            m_nextSend = m_start + Seconds((*m_trace)[m_traceCursor].offsetS);
+            return true;
+        }
+        return false;
+    }
+    
+    Ptr<Socket> m_socket;
+    Ipv4Address m_destination;
+    uint16_t m_port;
+    Model m_model;
+    uint32_t m_packetSize;      // Bytes including the SeqTs header
+    double m_rateBps;
+    double m_onMeanS;
+    double m_offMeanS;
+    Time m_sendQuantum;         // Zero sends each packet from its own event
+    Time m_interval;            // Packet spacing at m_rateBps
+    Time m_start;
+    Time m_nextSend;
+    Time m_onEnd;               // End of the current on period (OnOff)
+    std::shared_ptr<const std::vector<TrafficSend>> m_trace;
+    size_t m_traceCursor;
+    Ptr<ExponentialRandomVariable> m_exponential;
+    EventId m_sendEvent;
+    uint32_t m_seq;
+    uint64_t m_sentPackets;
+    uint64_t m_sentBytes;
+    uint64_t m_sendFailures;    // Socket refused the packet (send buffer full)
+    uint64_t m_sendEvents;
+    TracedCallback<Ptr<const Packet>> m_txTrace;
 };
 
-SimulationContext g_context;
+NS_OBJECT_ENSURE_REGISTERED(TrafficGenerator);
 
 // ============================================================================
 // Callback Functions for Traces
@@ -563,24 +3282,106 @@ uint32_t ParseNodeIdFromContext(const std::string& context) {
     return static_cast<uint32_t>(std::stoul(nodeIdStr));
 }
 
+/**
+ * Flow index of a source or destination node (UINT32_MAX if the node has no flow)
+ */
+uint32_t FlowIndexOf(uint32_t source, uint32_t dest) {
+    auto flow = g_context.flowIndex.find((static_cast<uint64_t>(source) << 32) | dest);
+    return flow != g_context.flowIndex.end() ? flow->second : UINT32_MAX;
+}
+
+uint32_t FlowIndexOfSource(uint32_t source) {
+    auto it = g_sourceToDest.find(source);
+    return it != g_sourceToDest.end() ? FlowIndexOf(source, it->second) : UINT32_MAX;
+}
+
+uint32_t FlowIndexOfDest(uint32_t dest) {
+    auto it = g_destToSource.find(dest);
+    return it != g_destToSource.end() ? FlowIndexOf(it->second, dest) : UINT32_MAX;
+}
+
+/**
+ * Send the ACK of one flow if it has new receipts at a local destination
+ */
+void SendFlowAck(uint32_t flowIdx) {
+    uint32_t source = g_context.activeFlows[flowIdx].first;
+    uint32_t dest = g_context.activeFlows[flowIdx].second;
+    FlowAckHeader header;
+    if (!g_context.IsLocal(dest) || !g_context.acks.TakeAck(flowIdx, header)) return;
+    
+    Ptr<Packet> ack = Create<Packet>();
+    ack->AddHeader(header);
+    // Overhead includes the UDP (8) and IPv4 (20) headers the ACK adds on the air
+    g_context.acks.CountSent(ack->GetSize() + 8 + 20);
+    g_context.ackSockets[dest]->SendTo(ack, 0,
+                                       InetSocketAddress(g_context.ipv4Interfaces.GetAddress(source), kAckPort));
+}
+
 /**
  * Application Layer Rx Callback: Mark packet as delivered
  */
 void AppRxCallback(std::string context, Ptr<const Packet> packet) {
-    // Optimization: Only track delivery if we are watching this packet
-    if (g_pendingPackets.find(packet->GetUid()) != g_pendingPackets.end()) {
-        g_deliveredPackets.insert(packet->GetUid());
+    PhaseScope scope(ProfPhase::CallbackAppRx);
+    
+    // Route acquisition: first delivery per flow (context parsed only while flows are waiting)
+    if (g_context.baseline.AwaitingRx()) {
+        g_context.baseline.OnFlowRx(FlowIndexOfDest(ParseNodeIdFromContext(context)),
+                                    Simulator::Now().GetNanoSeconds());
+    }
+    
+    // End-to-end ACK mode: the destination only records the sequence number; the
+    // source learns about the delivery from the next ACK
+    if (g_context.acks.IsEnabled()) {
+        SeqTsHeader seqTs;
+        packet->PeekHeader(seqTs);
+        g_context.acks.OnDataRx(FlowIndexOfDest(ParseNodeIdFromContext(context)), seqTs.GetSeq(), &SendFlowAck);
+    } else {
+        SeqTsHeader seqTs;
+        packet->PeekHeader(seqTs);
+        uint32_t flowIdx = FlowIndexOfDest(ParseNodeIdFromContext(context));
+        if (!g_context.distributed) {
+            // Only sampled packets are tracked; the rest find no pending entry
+            g_tracker.MarkDelivered(flowIdx, seqTs.GetSeq());
+        } else if (flowIdx != UINT32_MAX) {
+            // Distributed mode: the source may live on another rank, so confirmations go
+            // through the heartbeat exchange (which also covers sources on this rank)
+            g_remoteDeliveries.push_back(DeliveryRecord{flowIdx, seqTs.GetSeq()});
+        }
     }
     
     // Control Plane Metrics: Update RX counter for time series
     g_timeSeriesRx++;
+    g_appRxPackets++;
+    g_appRxBytes += packet->GetSize();
+    if (g_context.sourceRouting) {
+        // The source route padding is not application data
+        SourceRouteTag tag;
+        if (packet->PeekPacketTag(tag)) {
+            g_appRxBytes -= tag.GetSerializedSize();
+        }
+    }
+    
+    // Distributed mode: FlowMonitor cannot follow packets across ranks, so the
+    // delay comes from the UdpClient SeqTs header
+    if (g_context.distributed) {
+        SeqTsHeader seqTs;
+        packet->PeekHeader(seqTs);
+        g_appDelaySumMs += (Simulator::Now() - seqTs.GetTs()).GetSeconds() * 1000.0;
+    }
 }
 
 /**
  * Application Layer Tx Callback: Sample and track packets
  */
 void AppTxCallback(std::string context, Ptr<const Packet> packet) {
+    PhaseScope scope(ProfPhase::CallbackAppTx);
     static Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+    g_appTxPackets++;
+    g_appTxBytes += packet->GetSize();
+    if (g_context.baseline.AwaitingTx()) {
+        g_context.baseline.OnFlowTx(FlowIndexOfSource(ParseNodeIdFromContext(context)),
+                                    Simulator::Now().GetNanoSeconds());
+    }
     
     // Sampling 15%
     if (rng->GetValue(0.0, 1.0) > 0.15) {
@@ -588,38 +3389,68 @@ void AppTxCallback(std::string context, Ptr<const Packet> packet) {
     }
     
     // Get Source Node ID from context
-    // Context: "/NodeList/X/ApplicationList/Y/$ns3::UdpClient/Tx"
+    // Context: "/NodeList/X/ApplicationList/Y/$ns3::UdpClient/Tx" (or TrafficGenerator/Tx)
     uint32_t sourceId = ParseNodeIdFromContext(context);
     if (sourceId == UINT32_MAX) return;
     
-    // Find Destination from our flow map
-    auto it = g_sourceToDest.find(sourceId);
-    if (it == g_sourceToDest.end()) return;
-    uint32_t destId = it->second;
-    
-    // Get the current path to determine the first hop (nextHop)
-    // This ensures symmetric trust updates: same hop is credited on success and penalized on timeout
-    std::vector<uint32_t> path = g_context.routingEngine.CalculatePath(sourceId, destId, &g_context.ledger);
-    uint32_t nextHopId = (path.size() > 1) ? path[1] : destId;  // First hop, or dest if direct
+    uint32_t flowIdx = FlowIndexOfSource(sourceId);
+    if (flowIdx == UINT32_MAX) return;
     
-    TrackedPacket tracked;
-    tracked.packetUid = packet->GetUid();
-    tracked.sendTime = Simulator::Now();
-    tracked.sourceNodeId = sourceId;
-    tracked.destNodeId = destId;
-    tracked.nextHopId = nextHopId;  // Store first hop for symmetric trust updates
+    // First hop of the path the last heartbeat computed (trust, and so the path, only
+    // changes at heartbeats). The same hop is credited on success and penalized on timeout.
+    const std::vector<uint32_t>& path = g_context.flowPaths[flowIdx];
+    uint32_t nextHopId = path.size() > 1 ? path[1] : g_context.activeFlows[flowIdx].second;  // Dest if direct
     
-    g_pendingPackets[packet->GetUid()] = tracked;
+    SeqTsHeader seqTs;
+    packet->PeekHeader(seqTs);
+    g_tracker.Track(flowIdx, seqTs.GetSeq(), nextHopId, Simulator::Now().GetNanoSeconds());
     
     // Control Plane Metrics: Update TX counter for time series
     g_timeSeriesTx++;
 }
 
+/**
+ * Send the ACK of every flow with new receipts at a local destination, then reschedule
+ */
+void SendFlowAcks() {
+    for (size_t flowIdx = 0; flowIdx < g_context.activeFlows.size(); flowIdx++) {
+        SendFlowAck(flowIdx);
+    }
+    Simulator::Schedule(g_context.acks.GetInterval(), &SendFlowAcks);
+}
+
+/**
+ * ACK socket receive callback (source side): mark the covered tracked packets delivered
+ */
+void AckRxCallback(Ptr<Socket> socket) {
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv())) {
+        FlowAckHeader header;
+        packet->RemoveHeader(header);
+        g_context.acks.OnAck(header, g_tracker);
+    }
+}
+
+/**
+ * Ipv4 UnicastForward Callback: Count forwards (distributed hop count)
+ */
+void UnicastForwardCallback(const Ipv4Header& header, Ptr<const Packet> packet, uint32_t interface) {
+    g_unicastForwards++;
+}
+
+/**
+ * Ipv4 Tx Callback: Control overhead of the MANET protocol baselines
+ */
+void Ipv4TxCallback(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface) {
+    g_context.baseline.OnIpTx(packet);
+}
+
 /**
  * PhyRxEnd Callback: Called when a packet is successfully received
  * Note: PhyRxEnd doesn't provide SNR directly, so we'll estimate it based on distance
  */
 void PhyRxEndCallback(std::string context, Ptr<const Packet> packet) {
+    PhaseScope scope(ProfPhase::CallbackPhyRxEnd);
     uint32_t receivingNodeId = ParseNodeIdFromContext(context);
     if (receivingNodeId == UINT32_MAX || receivingNodeId >= g_context.nodes.GetN()) {
         return;
@@ -689,6 +3520,7 @@ void PhyRxEndCallback(std::string context, Ptr<const Packet> packet) {
  */
 void Ipv4L3DropCallback(std::string context, const Ipv4Header& header, Ptr<const Packet> packet, 
                         Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t interface) {
+    PhaseScope scope(ProfPhase::CallbackL3Drop);
     uint32_t receivingNodeId = ParseNodeIdFromContext(context);
     if (receivingNodeId == UINT32_MAX || receivingNodeId >= g_context.nodes.GetN()) {
         return;
@@ -725,6 +3557,7 @@ void Ipv4L3DropCallback(std::string context, const Ipv4Header& header, Ptr<const
     if (isExplicitBlackhole) {
         g_reliabilityDrops++;
         g_blackholeL3Drops++;
+        g_context.adversary.RecordDrop(receivingNodeId, Simulator::Now().GetSeconds());
     }
     
     // PURE DYNAMIC DETECTION: Update trust for ALL drops, not just known blackholes
@@ -798,6 +3631,7 @@ void Ipv4L3DropCallback(std::string context, const Ipv4Header& header, Ptr<const
  * PhyRxDrop Callback: Called when a packet is dropped at PHY layer
  */
 void PhyRxDropCallback(std::string context, Ptr<const Packet> packet, WifiPhyRxfailureReason reason) {
+    PhaseScope scope(ProfPhase::CallbackPhyRxDrop);
     uint32_t receivingNodeId = ParseNodeIdFromContext(context);
     if (receivingNodeId == UINT32_MAX || receivingNodeId >= g_context.nodes.GetN()) {
         return;
@@ -878,56 +3712,299 @@ void PhyRxDropCallback(std::string context, Ptr<const Packet> packet, WifiPhyRxf
     }
 }
 
+#ifdef NS3_MPI
+// ============================================================================
+// Distributed Mode (MPI Boundary Exchange)
+// ============================================================================
+// Every rank creates all nodes and runs all mobility models, so positions (and
+// therefore the topology) are replicated without communication. What differs
+// per rank is what the trace callbacks observe: a rank only sees events of the
+// nodes it owns. Once per heartbeat the ranks exchange
+//  - delivery confirmations, forwarded to the rank owning the flow source,
+//  - ledger entries changed since the last heartbeat,
+//  - the paths each rank computed (flows whose source it owns).
+// The exchanges are collectives on the ns-3 MPI communicator. They are safe
+// inside the heartbeat event because the granted-time-window scheduler runs a
+// given timestamp within the same window on every rank.
+
+/**
+ * Gather POD records from all ranks into all (concatenated in rank order)
+ */
+template <typename T>
+void AllGatherRecords(const std::vector<T>& local, std::vector<T>& all) {
+    MPI_Comm comm = MpiInterface::GetCommunicator();
+    uint32_t size = MpiInterface::GetSize();
+    int localBytes = static_cast<int>(local.size() * sizeof(T));
+    std::vector<int> counts(size);
+    std::vector<int> displs(size);
+    MPI_Allgather(&localBytes, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+    int totalBytes = 0;
+    for (uint32_t r = 0; r < size; r++) {
+        displs[r] = totalBytes;
+        totalBytes += counts[r];
+    }
+    all.resize(totalBytes / sizeof(T));
+    MPI_Allgatherv(local.data(), localBytes, MPI_BYTE, all.data(), counts.data(), displs.data(),
+                   MPI_BYTE, comm);
+}
+
+/**
+ * Exchange delivery confirmations and changed ledger entries (start of heartbeat)
+ */
+void ExchangeBoundaryState() {
+    std::vector<DeliveryRecord> deliveries;
+    AllGatherRecords(g_remoteDeliveries, deliveries);
+    g_remoteDeliveries.clear();
+    for (const DeliveryRecord& record : deliveries) {
+        if (!g_context.IsLocal(g_context.activeFlows[record.flowIdx].first)) continue;
+        g_tracker.MarkDelivered(record.flowIdx, record.seq);
+    }
+    g_mpiDeliveryRecords += deliveries.size();
+    
+    // Applied in rank order on every rank, so concurrent writes resolve identically
+    std::vector<LedgerRecord> localRecords;
+    std::vector<LedgerRecord> allRecords;
+    g_context.ledger.CollectDirty(localRecords);
+    AllGatherRecords(localRecords, allRecords);
+    for (const LedgerRecord& record : allRecords) {
+        g_context.ledger.ApplyRecord(record);
+    }
+    g_mpiLedgerRecords += allRecords.size();
+    if (g_context.chainStore || g_context.snapshotRecorder) {
+        // Rank 0 records the merged changes of all ranks (see RecordHeartbeat)
+        g_context.ledgerChanges = allRecords;
+    }
+}
+
+/**
+ * Share the paths of locally computed flows as [flowIdx, length, hops...] words
+ */
+void ExchangeFlowPaths() {
+    std::vector<uint32_t> localWords;
+    std::vector<uint32_t> allWords;
+    for (size_t flowIdx = 0; flowIdx < g_context.activeFlows.size(); flowIdx++) {
+        if (!g_context.IsLocal(g_context.activeFlows[flowIdx].first)) continue;
+        const std::vector<uint32_t>& path = g_context.flowPaths[flowIdx];
+        localWords.push_back(static_cast<uint32_t>(flowIdx));
+        localWords.push_back(static_cast<uint32_t>(path.size()));
+        localWords.insert(localWords.end(), path.begin(), path.end());
+    }
+    AllGatherRecords(localWords, allWords);
+    for (size_t w = 0; w + 1 < allWords.size(); ) {
+        uint32_t flowIdx = allWords[w];
+        uint32_t length = allWords[w + 1];
+        if (!g_context.IsLocal(g_context.activeFlows[flowIdx].first)) {
+            g_context.SetFlowPath(flowIdx, std::vector<uint32_t>(allWords.begin() + w + 2, allWords.begin() + w + 2 + length));
+        }
+        w += 2 + length;
+    }
+    g_mpiPathWords += allWords.size();
+}
+
+void MpiSum(uint64_t& value) {
+    MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_UINT64_T, MPI_SUM, MpiInterface::GetCommunicator());
+}
+
+void MpiSum(uint32_t& value) {
+    MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_UINT32_T, MPI_SUM, MpiInterface::GetCommunicator());
+}
+
+void MpiSum(double& value) {
+    MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_DOUBLE, MPI_SUM, MpiInterface::GetCommunicator());
+}
+
+void MpiMax(uint64_t& value) {
+    MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_UINT64_T, MPI_MAX, MpiInterface::GetCommunicator());
+}
+
+void MpiMax(double& value) {
+    MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_DOUBLE, MPI_MAX, MpiInterface::GetCommunicator());
+}
+
+/**
+ * Combine per-attacker outcomes (drops are counted on the rank owning the attacker)
+ */
+void ReduceAdversaryStats() {
+    for (AdversaryBehaviour& record : g_context.adversary.GetRecords()) {
+        MpiSum(record.packetsSeen);
+        MpiSum(record.packetsDropped);
+        MpiSum(record.dropsAtDetection);
+        MpiSum(record.dropsBeforeIsolation);
+        MpiMax(record.firstDropS);
+        MpiMax(record.detectedS);
+        MpiMax(record.isolatedS);
+    }
+}
+
+/**
+ * Sum the per-rank drop and cost counters (route flaps are already replicated)
+ */
+void ReduceDistributedCounters() {
+    MpiSum(g_phyDrops);
+    MpiSum(g_l3Drops);
+    MpiSum(g_blackholeL3Drops);
+    MpiSum(g_routeSkips);
+    MpiSum(g_trustPenalties);
+    MpiSum(g_trustOutcomes);
+    MpiSum(g_trustLinkUpdates);
+    MpiSum(g_reliabilityDrops);
+    MpiSum(g_avgSnrCostPart);
+    MpiSum(g_avgTrustCostPart);
+    MpiSum(g_pathCalculations);
+    MpiSum(g_timeSeriesTx);
+    MpiSum(g_timeSeriesRx);
+}
+#endif
+
 // ============================================================================
 // Heartbeat Function
 // ============================================================================
 
+/**
+ * Broadcast this heartbeat's ledger block from a rotating proposer over MPR relays
+ * Also counts what plain flooding of the same block would have cost.
+ */
+void DisseminateLedgerBlock() {
+    static uint64_t blockSeq = 0;
+    uint32_t numNodes = g_context.nodes.GetN();
+    g_mprRecomputations += g_context.mpr.Update(g_context.routingEngine.GetGraph(), numNodes);
+    blockSeq++;
+    uint32_t proposer = blockSeq % numNodes;
+    // The sequence number stands in for the block hash (unique per block, never 0)
+    MprSelector::Dissemination result = g_context.mpr.Disseminate(proposer, blockSeq);
+    g_disseminatedBlocks++;
+    g_mprTransmissions += result.mprTransmissions;
+    g_floodTransmissions += result.floodTransmissions;
+    g_disseminationReached += result.reached;
+    g_mprSetSizeSum += g_context.mpr.GetMeanMprSetSize();
+}
+
+/**
+ * Apply a heartbeat's trust updates after authentication
+ */
+void CommitTrustBlock(std::shared_ptr<TrustUpdateBatch> block) {
+    g_trustLinkUpdates += block->Apply(g_context.ledger, g_context.useBlockchain);
+}
+
+/**
+ * Hand this heartbeat's ledger changes and positions to the enabled recorders
+ * Distributed runs record the merged records of the boundary exchange instead
+ * of the local dirty set, which the exchange consumes.
+ */
+void RecordHeartbeat() {
+    if (!g_context.chainStore && !g_context.snapshotRecorder) return;
+    std::vector<LedgerRecord>& changes = g_context.ledgerChanges;
+    if (!g_context.distributed) {
+        changes.clear();
+        g_context.ledger.CollectDirty(changes);
+    }
+    int64_t nowNs = Simulator::Now().GetNanoSeconds();
+    if (g_context.chainStore) {
+        g_context.chainStore->AppendBlock(nowNs, changes);
+    }
+    if (g_context.snapshotRecorder) {
+        g_context.snapshotRecorder->Record(nowNs, g_context.mobility, changes);
+    }
+    changes.clear();
+}
+
+/**
+ * Replace currentNode's static host route to destIp with one through nextNode
+ */
+void InstallHostRoute(uint32_t currentNode, uint32_t nextNode, Ipv4Address destIp) {
+    Ptr<Node> node = g_context.nodes.Get(currentNode);
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    // GetStaticRouting also finds the static protocol inside an Ipv4ListRouting
+    Ptr<Ipv4StaticRouting> staticRouting = Ipv4StaticRoutingHelper().GetStaticRouting(ipv4);
+    
+    if (staticRouting) {
+        // Remove old routes to this destination
+        uint32_t numRoutes = staticRouting->GetNRoutes();
+        for (int32_t j = numRoutes - 1; j >= 0; j--) {
+            Ipv4RoutingTableEntry route = staticRouting->GetRoute(j);
+            if (route.GetDest() == destIp) {
+                staticRouting->RemoveRoute(j);
+            }
+        }
+        
+        // FIX: In Proposed mode, routing algorithm will avoid blackholes via high weights
+        // We still install routes, but blackhole nodes will drop packets when they receive them
+        // This allows the system to detect blackholes via trust decay
+        // In Baseline mode, routes go through blackholes (they will drop packets)
+        
+        // Get next hop IP address
+        // Multi-channel mode: the radio and next-hop address of the link's channel
+        uint32_t channel = g_context.LinkChannel(currentNode, nextNode);
+        Ipv4Address nextHopIp = g_context.channelInterfaces[channel].GetAddress(nextNode);
+        uint32_t interface = ipv4->GetInterfaceForDevice(g_context.channelDevices[channel].Get(currentNode));
+        
+        // Hops between MPI partitions leave through the portal link
+        auto portal = g_context.portals.find(std::make_pair(currentNode, nextNode));
+        if (portal != g_context.portals.end()) {
+            nextHopIp = portal->second.peerAddress;
+            interface = portal->second.interface;
+        }
+        
+        // Verify interface is valid
+        if (interface == UINT32_MAX) {
+            NS_LOG_WARN("Invalid interface for node " << currentNode);
+            return;
+        }
+        
+        // Install route: to reach destIp, send to nextHopIp via interface
+        // For direct path (source->dest), nextHopIp == destIp
+        staticRouting->AddHostRouteTo(destIp, nextHopIp, interface);
+        // MINIMIZED: Route installation logging disabled for production
+        // NS_LOG_INFO("Route installed on node " << currentNode << ": destination " 
+        //             << destIp << " -> next hop " << nextHopIp << " (Node " << nextNode << ") via interface " << interface);
+    } else {
+        NS_LOG_WARN("StaticRouting not found on node " << currentNode);
+    }
+}
+
 void SimulationHeartbeat() {
     double currentTime = Simulator::Now().GetSeconds();
     // MINIMIZED: Heartbeat logging disabled for production (called every 100ms)
     // NS_LOG_INFO("Heartbeat at " << currentTime << "s");
     
+#ifdef NS3_MPI
+    // Distributed mode: delivery confirmations and ledger changes from the other ranks
+    if (g_context.distributed) {
+        PhaseScope exchangePhase(ProfPhase::HeartbeatExchange);
+        ExchangeBoundaryState();
+    }
+#endif
+    
     // 0. Application Layer Timeout Detection (New Mechanism)
     // Check for pending packets that have timed out (> 200ms)
+    // End-to-end ACKs wait up to one ACK interval at the destination, so the timeout grows by that
+    PhaseScope timeoutPhase(ProfPhase::HeartbeatTimeouts);
     Time timeout = MilliSeconds(200);
+    if (g_context.acks.IsEnabled()) {
+        timeout += g_context.acks.GetInterval();
+    }
     uint32_t detectedDrops = 0;
+    // Outcomes are collected per link and written once per link after the scan
+    static TrustUpdateBatch trustBatch;
     
-    for (auto it = g_pendingPackets.begin(); it != g_pendingPackets.end(); ) {
-        // Check if delivered
-        if (g_deliveredPackets.find(it->first) != g_deliveredPackets.end()) {
-            // Success! Update trust (recovery mechanism)
-            // FIX: Symmetric trust updates - update only the first hop (same as timeout logic)
-            // This ensures intermediate hops receive credit for successful delivery
-            // and prevents biased metrics from updating non-existent direct links
-            uint32_t src = it->second.sourceNodeId;
-            uint32_t nextHop = it->second.nextHopId;
-            // Update metric with isDrop=false to trigger trust recovery
-            // SNR=0.0 means we don't update SNR, only trust
-            g_context.ledger.UpdateMetric(src, nextHop, 0.0, false, g_context.useBlockchain);
-            
-            // Remove from tracking
-            g_deliveredPackets.erase(it->first); // Optimization: Clean up delivered set
-            it = g_pendingPackets.erase(it);
-        } 
-        // Check for timeout
-        else if (Simulator::Now() - it->second.sendTime > timeout) {
-            // Timeout detected! Packet lost.
-            detectedDrops++;
-            
-            uint32_t src = it->second.sourceNodeId;
-            uint32_t nextHop = it->second.nextHopId;  // Use stored first hop (symmetric with success case)
-            
-            // Penalize the first hop (same hop that would be credited on success)
-            // This ensures symmetric trust updates: same hop is penalized on timeout and credited on success
-            // Update Trust (isDrop = true)
-            // SNR is 0.0 because we don't know it from a timeout
-            g_context.ledger.UpdateMetric(src, nextHop, 0.0, true, g_context.useBlockchain);
-            
-            // Remove from tracking to avoid double counting
-            it = g_pendingPackets.erase(it);
-        } else {
-            ++it;
-        }
+    // Delivered packets credit their first hop (trust recovery; SNR is not updated) and
+    // timed-out packets penalize it, so the same hop is charged either way. Outcomes
+    // arrive in flow order, then send order within a flow.
+    g_tracker.Sweep(Simulator::Now().GetNanoSeconds(), timeout.GetNanoSeconds(),
+                    [&detectedDrops](uint32_t flowIdx, uint32_t nextHop, bool isDrop) {
+        if (isDrop) detectedDrops++;
+        trustBatch.Add(g_context.activeFlows[flowIdx].first, nextHop, isDrop);
+    });
+    
+    // Same result as one UpdateMetric per outcome in scan order (see ApplyOutcomeRuns)
+    g_trustOutcomes += trustBatch.GetNumOutcomes();
+    if (g_context.authentication.IsEnabled()) {
+        // Committed once the block's signatures are verified (one report per link)
+        Time delay = g_context.authentication.Submit(Simulator::Now(), trustBatch.CountLinks());
+        Simulator::Schedule(delay, &CommitTrustBlock, std::make_shared<TrustUpdateBatch>(std::move(trustBatch)));
+        trustBatch = TrustUpdateBatch();
+    } else {
+        g_trustLinkUpdates += trustBatch.Apply(g_context.ledger, g_context.useBlockchain);
     }
     
     // MINIMIZED: AppLayer detection logging disabled for production
@@ -935,34 +4012,85 @@ void SimulationHeartbeat() {
     //     NS_LOG_INFO("AppLayer Detection: " << detectedDrops << " packets timed out. Penalties applied.");
     // }
     
+    timeoutPhase.Stop();
+    
     // 1. Topology Discovery: Build graph from current physical positions
+    PhaseScope graphPhase(ProfPhase::HeartbeatBuildGraph);
+    TakeMobilitySnapshot();
+    RecordHeartbeat();
     // Pass blackholeNodes to BuildGraph so Proposed mode can exclude them
-    g_context.routingEngine.BuildGraph(g_context.nodes, g_context.ledger, 
+    g_context.routingEngine.BuildGraph(g_context.mobility, g_context.ledger, 
                                        g_context.maxRadioRange, g_context.blackholeNodes, 
                                        g_context.defaultSnr);
+    if (g_context.mprDissemination && g_context.rank == 0) {
+        // The graph is global on every rank, so rank 0 models the whole network
+        DisseminateLedgerBlock();
+    }
+    graphPhase.Stop();
+    
+    // MANET protocol baselines discover and repair their own routes; the trust path
+    // still names the first hop that tracked packets charge
+    if (g_context.baseline.IsProtocol()) {
+        for (size_t flowIdx = 0; flowIdx < g_context.activeFlows.size(); flowIdx++) {
+            uint32_t source = g_context.activeFlows[flowIdx].first;
+            if (!g_context.IsLocal(source)) continue;
+            g_context.flowPaths[flowIdx] = g_context.routingEngine.CalculatePath(
+                source, g_context.activeFlows[flowIdx].second, &g_context.ledger);
+        }
+        Simulator::Schedule(MilliSeconds(100), &SimulationHeartbeat);
+        return;
+    }
     
-    // 2. Calculate and install routes for all active flows
-    for (const auto& flow : g_context.activeFlows) {
-        uint32_t source = flow.first;
-        uint32_t dest = flow.second;
-        
-        // Create flow ID for route stability tracking
-        uint32_t flowId = source * 1000 + dest;  // Simple flow ID encoding
+    // 2. Calculate paths for all active flows
+    // Distributed mode: each rank computes the flows whose source it owns and the
+    // paths are shared, so every flow is computed exactly once per heartbeat
+    PhaseScope routePhase(ProfPhase::HeartbeatRoutes);
+    for (size_t flowIdx = 0; flowIdx < g_context.activeFlows.size(); flowIdx++) {
+        uint32_t source = g_context.activeFlows[flowIdx].first;
+        uint32_t dest = g_context.activeFlows[flowIdx].second;
+        if (!g_context.IsLocal(source)) continue;
         
         // Calculate path using Dijkstra (with cost composition tracking)
-        std::vector<uint32_t> path = g_context.routingEngine.CalculatePath(source, dest, &g_context.ledger);
+        // Also read by the source when stamping source routes
+        g_context.SetFlowPath(flowIdx, g_context.routingEngine.CalculatePath(source, dest, &g_context.ledger));
+    }
+#ifdef NS3_MPI
+    if (g_context.distributed) {
+        PhaseScope exchangePhase(ProfPhase::HeartbeatExchange);
+        ExchangeFlowPaths();
+    }
+#endif
+    
+    // Sector antennas follow the new paths
+    if (g_context.antenna.IsEnabled()) {
+        g_context.antenna.UpdateBeams(g_context.flowPaths);
+    }
+    
+    // Isolation of detected attackers (detection itself is reported by the ledger)
+    g_context.adversary.UpdateIsolation(g_context.pathTraversals, currentTime);
+    
+    // 3. Install routes for all active flows
+    for (size_t flowIdx = 0; flowIdx < g_context.activeFlows.size(); flowIdx++) {
+        uint32_t dest = g_context.activeFlows[flowIdx].second;
+        const std::vector<uint32_t>& path = g_context.flowPaths[flowIdx];
         
         // Control Plane Metrics: Route Stability (Flapping Detection)
-        if (g_lastPaths.find(flowId) != g_lastPaths.end()) {
-            // Compare with previous path
-            const std::vector<uint32_t>& lastPath = g_lastPaths[flowId];
-            if (path != lastPath) {
-                // Path changed - increment flapping counter
-                g_routeFlaps++;
-            }
+        // Compare fingerprints (hash + hop count) instead of full paths
+        FlowRouteState& routeState = g_flowRouteState[flowIdx];
+        uint64_t pathHash = HashPath(path);
+        uint16_t hopCount = static_cast<uint16_t>(path.size());
+        if (routeState.hasPath && (pathHash != routeState.pathHash || hopCount != routeState.hopCount)) {
+            // Path changed - increment flapping counter
+            g_routeFlaps++;
+            routeState.RecordFlap(currentTime);
         }
-        // Update stored path for this flow
-        g_lastPaths[flowId] = path;
+        routeState.pathHash = pathHash;
+        routeState.hopCount = hopCount;
+        routeState.hasPath = true;
+#ifdef SIXG_PATH_DEBUG
+        routeState.inlineHops.fill(UINT32_MAX);
+        std::copy_n(path.begin(), std::min<size_t>(path.size(), kInlinePathHops), routeState.inlineHops.begin());
+#endif
         
         if (path.size() > 1) {
             std::ostringstream pathStr;
@@ -983,58 +4111,47 @@ void SimulationHeartbeat() {
                 uint32_t currentNode = path[i];
                 uint32_t nextNode = path[i + 1];
                 
+                // Distributed mode: the rank owning the node installs its routes
+                if (!g_context.IsLocal(currentNode)) {
+                    continue;
+                }
+                
                 // CRITICAL: Blackhole nodes should NOT have forwarding routes
                 // This ensures they drop packets (NO_ROUTE), which will be counted as ReliabilityDrops
                 // Source node can still have route TO blackhole (to send packets), but blackhole won't forward
-                if (g_context.blackholeNodes.find(currentNode) != g_context.blackholeNodes.end()) {
+                // (packet-level attackers keep their routes and drop in AdversaryRouting)
+                if (g_context.blackholeNodes.find(currentNode) != g_context.blackholeNodes.end() &&
+                    !g_context.adversary.IsPacketLevel()) {
                     // Skip route installation for blackhole nodes - they will drop packets
                     g_routeSkips++; // This correctly counts the number of times we prevent a route from being installed.
                     continue;
                 }
                 
-                Ptr<Node> node = g_context.nodes.Get(currentNode);
-                Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-                Ptr<Ipv4StaticRouting> staticRouting = 
-                    DynamicCast<Ipv4StaticRouting>(ipv4->GetRoutingProtocol());
+                // Source routing: the path travels in the packet, no table writes
+                // (paths that do not fit in the header still use static routes)
+                if (g_context.sourceRouting && path.size() <= kMaxSourceRouteHops) {
+                    continue;
+                }
                 
-                if (staticRouting) {
-                    // Remove old routes to this destination
-                    uint32_t numRoutes = staticRouting->GetNRoutes();
-                    for (int32_t j = numRoutes - 1; j >= 0; j--) {
-                        Ipv4RoutingTableEntry route = staticRouting->GetRoute(j);
-                        if (route.GetDest() == destIp) {
-                            staticRouting->RemoveRoute(j);
-                        }
-                    }
-                    
-                    // FIX: In Proposed mode, routing algorithm will avoid blackholes via high weights
-                    // We still install routes, but blackhole nodes will drop packets when they receive them
-                    // This allows the system to detect blackholes via trust decay
-                    // In Baseline mode, routes go through blackholes (they will drop packets)
-                    
-                    // Get next hop IP address
-                    Ipv4Address nextHopIp = g_context.ipv4Interfaces.GetAddress(nextNode);
-                    uint32_t interface = ipv4->GetInterfaceForDevice(g_context.netDevices.Get(currentNode));
-                    
-                    // Verify interface is valid
-                    if (interface == UINT32_MAX) {
-                        NS_LOG_WARN("Invalid interface for node " << currentNode);
-                        continue;
-                    }
-                    
-                    // Install route: to reach destIp, send to nextHopIp via interface
-                    // For direct path (source->dest), nextHopIp == destIp
-                    staticRouting->AddHostRouteTo(destIp, nextHopIp, interface);
-                    // MINIMIZED: Route installation logging disabled for production
-                    // NS_LOG_INFO("Route installed on node " << currentNode << ": destination " 
-                    //             << destIp << " -> next hop " << nextHopIp << " (Node " << nextNode << ") via interface " << interface);
-                } else {
-                    NS_LOG_WARN("StaticRouting not found on node " << currentNode);
+                InstallHostRoute(currentNode, nextNode, destIp);
+            }
+            
+            // End-to-end ACKs return along the reversed path (ACKs are not source routed, and
+            // blackholes withhold these routes as well)
+            if (g_context.acks.IsEnabled()) {
+                Ipv4Address sourceIp = g_context.ipv4Interfaces.GetAddress(path.front());
+                for (size_t i = path.size() - 1; i > 0; i--) {
+                    uint32_t currentNode = path[i];
+                    if (!g_context.IsLocal(currentNode)) continue;
+                    if (g_context.blackholeNodes.count(currentNode) && !g_context.adversary.IsPacketLevel()) continue;
+                    InstallHostRoute(currentNode, path[i - 1], sourceIp);
                 }
             }
         }
     }
     
+    routePhase.Stop();
+    
     // Reschedule for next heartbeat (100ms)
     Simulator::Schedule(MilliSeconds(100), &SimulationHeartbeat);
 }
@@ -1061,6 +4178,80 @@ void TimeSeriesDataOutput() {
     }
 }
 
+// ============================================================================
+// Distributed Mode Setup (Geographic Strips)
+// ============================================================================
+// ns-3 can only split a simulation across ranks along point-to-point links, so
+// each strip gets its own wireless channel and radio links that cross a strip
+// boundary are carried by portal point-to-point links. Strips and portals are
+// fixed from the initial positions; nodes keep their rank for the whole run.
+
+const double kSpeedOfLight = 299792458.0;  // m/s
+const double kOfdmPreambleS = 20e-6;       // 802.11a PLCP preamble + SIGNAL (earliest decodable reception)
+
+/**
+ * Area-wide position allocator (the same streams always yield the same positions)
+ */
+Ptr<RandomRectanglePositionAllocator> CreateAreaPositionAllocator(double sideLength, uint32_t rngRun) {
+    Ptr<RandomRectanglePositionAllocator> positionAlloc = CreateObject<RandomRectanglePositionAllocator>();
+    Ptr<UniformRandomVariable> xPos = CreateObject<UniformRandomVariable>();
+    xPos->SetAttribute("Min", DoubleValue(0.0));
+    xPos->SetAttribute("Max", DoubleValue(sideLength));
+    xPos->SetStream(rngRun * 2);  // Use RngRun for variation
+    Ptr<UniformRandomVariable> yPos = CreateObject<UniformRandomVariable>();
+    yPos->SetAttribute("Min", DoubleValue(0.0));
+    yPos->SetAttribute("Max", DoubleValue(sideLength));
+    yPos->SetStream(rngRun * 2 + 1);  // Use RngRun for variation
+    positionAlloc->SetX(xPos);
+    positionAlloc->SetY(yPos);
+    return positionAlloc;
+}
+
+/**
+ * Cut nodes into numStrips vertical strips holding equal node counts (by x)
+ */
+std::vector<uint32_t> AssignGeographicStrips(const std::vector<Vector>& positions, uint32_t numStrips) {
+    std::vector<uint32_t> order(positions.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&positions](uint32_t a, uint32_t b) {
+        return positions[a].x < positions[b].x;
+    });
+    std::vector<uint32_t> partitionOf(positions.size());
+    for (size_t k = 0; k < order.size(); k++) {
+        partitionOf[order[k]] = static_cast<uint32_t>(k * numStrips / order.size());
+    }
+    return partitionOf;
+}
+
+/**
+ * Cross-strip node pairs joined by a portal link: every node keeps its
+ * portalsPerNode nearest in-range neighbours from other strips (one-off O(N^2))
+ */
+std::set<std::pair<uint32_t, uint32_t>> SelectPortalPairs(const std::vector<Vector>& positions,
+                                                          const std::vector<uint32_t>& partitionOf,
+                                                          double maxRange, uint32_t portalsPerNode) {
+    std::set<std::pair<uint32_t, uint32_t>> pairs;
+    std::vector<std::pair<double, uint32_t>> candidates;
+    for (uint32_t i = 0; i < positions.size(); i++) {
+        candidates.clear();
+        for (uint32_t j = 0; j < positions.size(); j++) {
+            if (partitionOf[i] == partitionOf[j]) continue;
+            double distance = CalculateDistance(positions[i], positions[j]);
+            if (distance < maxRange) {
+                candidates.push_back(std::make_pair(distance, j));
+            }
+        }
+        size_t keep = std::min<size_t>(portalsPerNode, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + keep, candidates.end());
+        for (size_t k = 0; k < keep; k++) {
+            pairs.insert(std::make_pair(std::min(i, candidates[k].second), std::max(i, candidates[k].second)));
+        }
+    }
+    return pairs;
+}
+
 // ============================================================================
 // Main Function
 // ============================================================================
@@ -1079,7 +4270,57 @@ int main(int argc, char* argv[])
     bool useBlockchain = true;
     double beta = 500.0;  // Default beta for balanced cost function (calibrated to match SNR penalty scale)
     double trustFloor = 0.2;  // Default trust floor for ablation study
+    std::string trustModel = "decay";  // decay (x0.5 per drop, +0.005 per delivery) or window (outcome bitmap)
+    WindowTrustConfig windowTrust;  // trustModel=window: window length and hysteresis thresholds
+    std::string ackMode = "oracle";  // Delivery feedback: oracle (destination trace) or sack (end-to-end ACK packets)
+    double ackInterval = 100.0;  // ackMode=sack: ACK period per flow in milliseconds
     double sideLength = 300.0;  // Area side length in meters (for sparse/dense network testing)
+    bool perfCounters = false;  // Sample hardware performance counters around heartbeat phases
+    std::string routingMode = "flat";  // flat = global Dijkstra, hierarchical = two-level cluster routing, cch = contraction hierarchy
+    std::string linkCost = "snr";  // Link quality term: snr (quadratic SNR penalty) or ett (expected transmission time)
+    double clusterSize = 0.0;  // Cluster cell edge length in meters (0 = 2 x maxRadioRange)
+    double cchRangeSlack = 1.2;  // routingMode=cch: pairs within slack x maxRadioRange enter the hierarchy
+    uint32_t cchThreads = 1;  // routingMode=cch: customization threads
+    bool greedyFallback = false;  // Geographic forwarding when no static route exists
+    bool sourceRouting = false;  // Source-routed forwarding header instead of per-hop table installs
+    bool distributed = false;  // Spatially partitioned MPI run (one geographic strip per rank)
+    uint32_t portalsPerNode = 4;  // Distributed mode: cross-strip portal links per node
+    std::string trafficModel = "udpclient";  // udpclient (fixed 100 ms interval), cbr, poisson, onoff or trace
+    std::string dataRate = "81920bps";  // Per-flow rate of the cbr/poisson/onoff models (UdpClient default load)
+    uint32_t packetSize = 1024;  // Application packet size in bytes (incl. 12-byte SeqTs header)
+    double onTime = 1.0;  // Mean on-period of the onoff model in seconds
+    double offTime = 1.0;  // Mean off-period of the onoff model in seconds
+    std::string trafficTrace = "";  // "<offset_s> <size_bytes>" lines replayed by every flow (trace model)
+    double sendQuantumUs = 0.0;  // Packets due within this window share one send event (0 = one event per packet)
+    std::string attackModel = "blackhole";  // blackhole (no routes), grayhole, onoff, selective or mixed
+    double attackDropProb = 0.5;  // Grayhole drop probability (onoff/selective drop every packet they target)
+    double attackPeriod = 10.0;  // On-off attack period in seconds
+    double attackDutyCycle = 0.5;  // Fraction of each on-off period spent dropping
+    double attackTargetFraction = 0.5;  // Fraction of flows a selective attacker drops
+    bool mprDissemination = false;  // Broadcast one ledger block per heartbeat over MPR relays (counts vs flooding)
+    std::string authMode = "none";  // Trust report signatures: none, single or batch verification
+    double authCpuGhz = 3.0;  // Clock the Ed25519 cycle counts are scaled to
+    uint32_t authCores = 1;  // Cores per node available for verification
+    uint32_t authBatchSize = 64;  // Signatures per batch verification
+    std::string chainStore = "";  // Path prefix of the on-disk ledger chain (empty = disabled)
+    uint32_t chainSegmentMb = 256;  // Chain segment size before rolling over to a new file
+    std::string recordSnapshots = "";  // Heartbeat snapshot file for sixg-route-eval (empty = disabled)
+    std::string baseline = "static";  // static (heartbeat routes), aodv, olsr or dsdv (ns-3 protocol owns the routes)
+    std::string rateControl = "default";  // default (WifiHelper's manager) or ledger (LedgerRateManager)
+    double rateSnrMarginDb = 3.0;  // Margin below the ledger SNR for the rate lookup
+    uint32_t rateReportLinks = 20;  // Busiest links listed with their rate distribution
+    uint32_t numChannels = 1;  // Orthogonal channels, one radio per channel on every node
+    double channelContention = 0.5;  // Edge weight increase per conflicting link on the same channel
+    std::string antenna = "isotropic";  // isotropic (+30 dBi everywhere) or sector (beam steered at the path neighbour)
+    double sectorGainDbi = 30.0;  // Sector boresight gain
+    double sectorBeamwidthDeg = 30.0;  // Sector 3 dB beamwidth
+    double sectorSideLobeDbi = -10.0;  // Sector gain outside the main lobe
+    double sectorOmniDbi = 0.0;  // Quasi-omni gain of nodes without a beam
+    std::string obstacles = "";  // Obstacle footprints "xmin ymin xmax ymax [lossDb]" per line (empty = none)
+    double obstacleLossDb = 30.0;  // Loss of obstacles listed without their own
+    bool bodyBlockage = false;  // Every node is carried by a person whose body blocks other links
+    double bodyRadius = 0.3;  // Body disc radius in metres
+    double bodyLossDb = 20.0;  // Loss per body on a link's line of sight
     
     CommandLine cmd(__FILE__);
     cmd.AddValue("numNodes", "Number of nodes", numNodes);
@@ -1093,19 +4334,250 @@ int main(int argc, char* argv[])
     cmd.AddValue("useBlockchain", "Enable/Disable Trust logic (true=Proposed, false=Baseline)", useBlockchain);
     cmd.AddValue("beta", "Beta coefficient for trust cost (sensitivity analysis)", beta);
     cmd.AddValue("trustFloor", "Trust floor value (ablation study)", trustFloor);
+    cmd.AddValue("trustModel", "Trust update rule: decay (halve per drop, +0.005 per delivery) or window (windowed delivery ratio)", trustModel);
+    cmd.AddValue("trustWindow", "trustModel=window: outcomes per link window (1-128)", windowTrust.window);
+    cmd.AddValue("windowEnterLoss", "trustModel=window: windowed loss ratio that flags a link", windowTrust.enterLossRatio);
+    cmd.AddValue("windowExitLoss", "trustModel=window: windowed loss ratio at or below which a flagged link clears", windowTrust.exitLossRatio);
+    cmd.AddValue("windowLossRun", "trustModel=window: consecutive losses that flag a link regardless of the ratio", windowTrust.enterLossRun);
+    cmd.AddValue("windowClearRun", "trustModel=window: consecutive deliveries needed to clear a flagged link", windowTrust.exitDeliveryRun);
+    cmd.AddValue("ackMode", "Delivery feedback for trust: oracle (destination trace) or sack (cumulative + bitmap ACKs over the network)", ackMode);
+    cmd.AddValue("ackInterval", "ackMode=sack: ACK interval per flow in milliseconds", ackInterval);
     cmd.AddValue("sideLength", "Area side length in meters (for sparse/dense network testing)", sideLength);
+    cmd.AddValue("routingMode", "Route computation: flat (global Dijkstra), hierarchical (cluster-based) or cch (contraction hierarchy)", routingMode);
+    cmd.AddValue("linkCost", "Link quality term of the cost: snr (SNR penalty) or ett (ETX x packetSize / 802.11a rate)", linkCost);
+    cmd.AddValue("clusterSize", "Cluster cell edge length in meters for hierarchical routing (0 = 2 x maxRadioRange)", clusterSize);
+    cmd.AddValue("cchRangeSlack", "routingMode=cch: node pairs within this multiple of maxRadioRange are contracted (re-contract when a link appears beyond it)", cchRangeSlack);
+    cmd.AddValue("cchThreads", "routingMode=cch: threads for the per-heartbeat customization", cchThreads);
+    cmd.AddValue("greedyFallback", "Greedy geographic forwarding (trust-weighted) when no static route exists", greedyFallback);
+    cmd.AddValue("sourceRouting", "Stamp the path into each packet instead of installing per-hop static routes", sourceRouting);
+    cmd.AddValue("distributed", "Spatially partitioned MPI run, one geographic strip per rank (ns-3 built with MPI)", distributed);
+    cmd.AddValue("portalsPerNode", "Distributed mode: nearest cross-strip neighbours per node joined by portal links", portalsPerNode);
+    cmd.AddValue("trafficModel", "Traffic source: udpclient, cbr, poisson, onoff or trace", trafficModel);
+    cmd.AddValue("dataRate", "Per-flow data rate for the cbr, poisson and onoff models (e.g. 2Mbps)", dataRate);
+    cmd.AddValue("packetSize", "Application packet size in bytes", packetSize);
+    cmd.AddValue("onTime", "Mean on-period of the onoff model in seconds", onTime);
+    cmd.AddValue("offTime", "Mean off-period of the onoff model in seconds", offTime);
+    cmd.AddValue("trafficTrace", "Trace file for the trace model (<offset_s> <size_bytes> per line)", trafficTrace);
+    cmd.AddValue("sendQuantumUs", "Batch all packets due within this many microseconds into one send event", sendQuantumUs);
+    cmd.AddValue("attackModel", "Malicious behaviour: blackhole, grayhole, onoff, selective or mixed", attackModel);
+    cmd.AddValue("attackDropProb", "Drop probability of grayhole attackers", attackDropProb);
+    cmd.AddValue("attackPeriod", "Period of onoff attackers in seconds", attackPeriod);
+    cmd.AddValue("attackDutyCycle", "Fraction of each onoff period spent dropping", attackDutyCycle);
+    cmd.AddValue("attackTargetFraction", "Fraction of flows dropped by selective attackers", attackTargetFraction);
+    cmd.AddValue("chainStore", "Append every heartbeat's ledger changes to <prefix>.NNNNNN.chain (replay with sixg-chain-replay)", chainStore);
+    cmd.AddValue("chainSegmentMb", "Chain segment size in MB", chainSegmentMb);
+    cmd.AddValue("recordSnapshots", "Write positions, ledger changes and flows per heartbeat to this file (replay with sixg-route-eval)", recordSnapshots);
+    cmd.AddValue("mprDissemination", "Model ledger block broadcast over OLSR-style MPR relays and compare with flooding", mprDissemination);
+    cmd.AddValue("authMode", "Trust report authentication cost: none, single or batch (Ed25519 cycle model)", authMode);
+    cmd.AddValue("authCpuGhz", "CPU clock for the signature cost model in GHz", authCpuGhz);
+    cmd.AddValue("authCores", "Cores per node for signature verification", authCores);
+    cmd.AddValue("authBatchSize", "Signatures per batch verification (authMode=batch)", authBatchSize);
+    cmd.AddValue("baseline", "Route source: static (heartbeat routes) or an ns-3 MANET protocol: aodv, olsr, dsdv", baseline);
+    cmd.AddValue("rateControl", "WiFi rate control: default or ledger (rate from the ledger SNR, probing without it)", rateControl);
+    cmd.AddValue("rateSnrMarginDb", "SNR margin in dB below the ledger estimate for rateControl=ledger", rateSnrMarginDb);
+    cmd.AddValue("rateReportLinks", "Links listed in the [RATE_LINK] rate distribution report", rateReportLinks);
+    cmd.AddValue("numChannels", "Orthogonal 60 GHz channels (one radio each per node), links coloured over the conflict graph", numChannels);
+    cmd.AddValue("channelContention", "Multi-channel routing: edge weight increase per same-channel conflicting link", channelContention);
+    cmd.AddValue("antenna", "Antenna model: isotropic (+30 dBi) or sector (beam steered at the path neighbour)", antenna);
+    cmd.AddValue("sectorGainDbi", "Sector antenna boresight gain in dBi", sectorGainDbi);
+    cmd.AddValue("sectorBeamwidthDeg", "Sector antenna 3 dB beamwidth in degrees", sectorBeamwidthDeg);
+    cmd.AddValue("sectorSideLobeDbi", "Sector antenna gain outside the main lobe in dBi", sectorSideLobeDbi);
+    cmd.AddValue("sectorOmniDbi", "Quasi-omni gain of nodes not on any flow path in dBi", sectorOmniDbi);
+    cmd.AddValue("obstacles", "Scenario file of static obstacles, one 'xmin ymin xmax ymax [lossDb]' rectangle per line", obstacles);
+    cmd.AddValue("obstacleLossDb", "Loss in dB of obstacles listed without their own", obstacleLossDb);
+    cmd.AddValue("bodyBlockage", "Human-body blockage: each node's carrier blocks the links of other nodes", bodyBlockage);
+    cmd.AddValue("bodyRadius", "Body blockage disc radius in metres", bodyRadius);
+    cmd.AddValue("bodyLossDb", "Loss in dB per body on a link's line of sight", bodyLossDb);
+    cmd.AddValue("perfCounters", "Sample hardware performance counters (perf_event_open) per heartbeat phase", perfCounters);
     cmd.Parse(argc, argv);
     
     // Set RNG
     RngSeedManager::SetSeed(rngSeed);
     RngSeedManager::SetRun(rngRun);
     
+    BaselineProtocol baselineProtocol = BaselineProtocol::Static;
+    if (!RoutingBaseline::ParseProtocol(baseline, baselineProtocol)) {
+        NS_FATAL_ERROR("Unknown baseline '" << baseline << "' (expected static, aodv, olsr or dsdv)");
+    }
+    g_context.baseline.Configure(baselineProtocol);
+    if (g_context.baseline.IsProtocol()) {
+        if (greedyFallback || sourceRouting || distributed) {
+            NS_FATAL_ERROR("baseline=" << baseline << " cannot be combined with greedyFallback, sourceRouting or distributed");
+        }
+        if (useBlockchain) {
+            // The protocol chooses the routes, so the trust-aware costs would only be reported
+            NS_LOG_UNCOND("baseline=" << baseline << ": trust-aware routing disabled (useBlockchain=false)");
+            useBlockchain = false;
+        }
+    }
+    if (sourceRouting && numNodes > UINT16_MAX + 1u) {
+        // The header carries 16-bit node indices
+        NS_FATAL_ERROR("sourceRouting supports at most " << UINT16_MAX + 1u << " nodes (numNodes=" << numNodes << ")");
+    }
+    
     g_context.maxRadioRange = maxRadioRange;
     g_context.defaultSnr = defaultSnr;
     g_context.useBlockchain = useBlockchain;
+    g_context.greedyFallback = greedyFallback;
+    g_context.sourceRouting = sourceRouting;
+    g_context.mprDissemination = mprDissemination;
     g_context.routingEngine.SetUseBlockchain(useBlockchain);
     g_context.routingEngine.SetBeta(beta);
     g_context.ledger.SetTrustFloor(trustFloor);
+    TrustModel trustRule = TrustModel::Decay;
+    if (!ParseTrustModel(trustModel, trustRule)) {
+        NS_FATAL_ERROR("Unknown trustModel '" << trustModel << "' (expected decay or window)");
+    }
+    if (trustRule == TrustModel::Window) {
+        if (windowTrust.window == 0 || windowTrust.window > OutcomeHistory::kCapacity) {
+            NS_FATAL_ERROR("trustWindow must be between 1 and " << OutcomeHistory::kCapacity);
+        }
+        if (windowTrust.exitLossRatio > windowTrust.enterLossRatio) {
+            NS_FATAL_ERROR("windowExitLoss must not exceed windowEnterLoss (no hysteresis otherwise)");
+        }
+        g_context.ledger.SetTrustModel(trustRule, windowTrust);
+    }
+    if (ackMode != "oracle" && ackMode != "sack") {
+        NS_FATAL_ERROR("Unknown ackMode '" << ackMode << "' (expected oracle or sack)");
+    }
+    if (ackMode == "sack" && ackInterval <= 0.0) {
+        NS_FATAL_ERROR("ackInterval must be positive");
+    }
+    
+    if (routingMode != "flat" && routingMode != "hierarchical" && routingMode != "cch") {
+        NS_FATAL_ERROR("Unknown routingMode '" << routingMode << "' (expected flat, hierarchical or cch)");
+    }
+    if (routingMode == "cch" && (cchRangeSlack < 1.0 || cchThreads == 0)) {
+        NS_FATAL_ERROR("cchRangeSlack must be at least 1 and cchThreads positive");
+    }
+    if (clusterSize <= 0.0) {
+        clusterSize = 2.0 * maxRadioRange;
+    }
+    LinkCostMode costMode = LinkCostMode::Snr;
+    if (!ParseLinkCostMode(linkCost, costMode)) {
+        NS_FATAL_ERROR("Unknown linkCost '" << linkCost << "' (expected snr or ett)");
+    }
+    g_context.routingEngine.SetLinkCost(costMode, packetSize);
+    if (rateControl != "default" && rateControl != "ledger") {
+        NS_FATAL_ERROR("Unknown rateControl '" << rateControl << "' (expected default or ledger)");
+    }
+    if (numChannels < 1 || numChannels > kMaxChannels) {
+        NS_FATAL_ERROR("numChannels must be within [1, " << kMaxChannels << "]");
+    }
+    if (numChannels > 1) {
+        if (distributed || g_context.baseline.IsProtocol()) {
+            NS_FATAL_ERROR("numChannels > 1 needs the heartbeat routes of a single process (baseline=static, distributed=false)");
+        }
+        if (channelContention < 0.0) {
+            NS_FATAL_ERROR("channelContention must be non-negative");
+        }
+        g_context.channels.SetNumChannels(numChannels);
+        g_context.routingEngine.SetChannelAssigner(&g_context.channels, channelContention);
+    }
+    if (antenna != "isotropic" && antenna != "sector") {
+        NS_FATAL_ERROR("Unknown antenna '" << antenna << "' (expected isotropic or sector)");
+    }
+    if (antenna == "sector") {
+        if (g_context.baseline.IsProtocol()) {
+            NS_FATAL_ERROR("antenna=sector steers beams along the heartbeat paths (baseline=static only)");
+        }
+        if (sectorBeamwidthDeg <= 0.0 || sectorSideLobeDbi > sectorGainDbi) {
+            NS_FATAL_ERROR("sectorBeamwidthDeg must be positive and sectorSideLobeDbi at most sectorGainDbi");
+        }
+        g_context.antenna.Configure(sectorGainDbi, sectorBeamwidthDeg, sectorSideLobeDbi, sectorOmniDbi,
+                                    numNodes, &g_context.mobility);
+    }
+    bool blockage = !obstacles.empty() || bodyBlockage;
+    if (blockage) {
+        if (bodyBlockage && (bodyRadius <= 0.0 || bodyLossDb < 0.0)) {
+            NS_FATAL_ERROR("bodyRadius must be positive and bodyLossDb non-negative");
+        }
+        if (!obstacles.empty()) {
+            std::string error;
+            if (!g_context.blockage.LoadObstacles(obstacles, obstacleLossDb, error)) {
+                NS_FATAL_ERROR("cannot load obstacles: " << error);
+            }
+        }
+        g_context.blockage.Configure(bodyBlockage, bodyRadius, bodyLossDb, numNodes, &g_context.mobility);
+    }
+    
+    static const std::map<std::string, TrafficGenerator::Model> trafficModels = {
+        {"cbr", TrafficGenerator::Model::Cbr},
+        {"poisson", TrafficGenerator::Model::Poisson},
+        {"onoff", TrafficGenerator::Model::OnOff},
+        {"trace", TrafficGenerator::Model::Trace}};
+    if (trafficModel != "udpclient" && !trafficModels.count(trafficModel)) {
+        NS_FATAL_ERROR("Unknown trafficModel '" << trafficModel << "' (expected udpclient, cbr, poisson, onoff or trace)");
+    }
+    if (trafficModel == "trace" && trafficTrace.empty()) {
+        NS_FATAL_ERROR("trafficModel=trace requires --trafficTrace");
+    }
+    AuthMode auth = AuthMode::None;
+    if (!AuthenticationModel::ParseMode(authMode, auth)) {
+        NS_FATAL_ERROR("Unknown authMode '" << authMode << "' (expected none, single or batch)");
+    }
+    if (authCpuGhz <= 0.0) {
+        NS_FATAL_ERROR("authCpuGhz must be positive");
+    }
+    g_context.authentication.Configure(auth, authCpuGhz, authCores, authBatchSize);
+    
+    AttackModel attack = AttackModel::Blackhole;
+    if (!AdversaryEngine::ParseModel(attackModel, attack)) {
+        NS_FATAL_ERROR("Unknown attackModel '" << attackModel << "' (expected blackhole, grayhole, onoff, selective or mixed)");
+    }
+    if (attackPeriod <= 0.0 || attackDutyCycle < 0.0 || attackDutyCycle > 1.0) {
+        NS_FATAL_ERROR("attackPeriod must be positive and attackDutyCycle within [0, 1]");
+    }
+    g_context.adversary.Configure(attack, numNodes, (static_cast<uint64_t>(rngSeed) << 32) | rngRun,
+                                  g_context.baseline.IsProtocol());
+    g_context.ledger.SetBlackholeCallback([](uint32_t nodeId, bool flagged) {
+        g_context.adversary.OnBlackholeFlag(nodeId, flagged, Simulator::Now().GetSeconds());
+    });
+    double dataRateBps = static_cast<double>(DataRate(dataRate).GetBitRate());
+    if (dataRateBps <= 0.0 || onTime <= 0.0 || offTime < 0.0) {
+        NS_FATAL_ERROR("dataRate and onTime must be positive and offTime non-negative");
+    }
+    g_context.routingEngine.SetHierarchical(routingMode == "hierarchical", clusterSize);
+    g_context.routingEngine.SetContractionHierarchy(routingMode == "cch", cchRangeSlack, cchThreads);
+    
+    if (distributed) {
+#ifdef NS3_MPI
+        if (sourceRouting || greedyFallback) {
+            NS_FATAL_ERROR("distributed mode installs static routes only (disable sourceRouting and greedyFallback)");
+        }
+        // Granted-time-window scheduler: the heartbeat collectives need globally aligned windows
+        GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DistributedSimulatorImpl"));
+        MpiInterface::Enable(&argc, &argv);
+        g_context.distributed = true;
+        g_context.rank = MpiInterface::GetSystemId();
+        g_context.numPartitions = MpiInterface::GetSize();
+        g_context.ledger.SetDirtyTracking(true);
+        if (g_context.rank != 0) {
+            // Only rank 0 reports; totals are reduced across ranks before printing
+            std::cout.setstate(std::ios::badbit);
+            std::clog.setstate(std::ios::badbit);
+        }
+#else
+        NS_FATAL_ERROR("distributed mode requires ns-3 configured with --enable-mpi");
+#endif
+    }
+    
+    if (!chainStore.empty() || !recordSnapshots.empty()) {
+        g_context.ledger.SetDirtyTracking(true);
+    }
+    if (!chainStore.empty()) {
+        if (g_context.rank == 0) {
+            g_context.chainStore = std::make_unique<ChainWriter>(chainStore, static_cast<uint64_t>(chainSegmentMb) << 20);
+            if (g_context.chainStore->Failed()) {
+                NS_FATAL_ERROR("cannot create chain segment " << ChainSegmentPath(chainStore, 0));
+            }
+        }
+    }
+    
+    if (perfCounters) {
+        g_profiler.EnableHardwareCounters();
+        NS_LOG_UNCOND("Hardware performance counters: " << (g_profiler.HardwareEnabled() ? "enabled" : "unavailable (wall clock only)"));
+    }
     
     // Reset reliability drops counter for this simulation run
     g_reliabilityDrops = 0;
@@ -1119,7 +4591,15 @@ int main(int argc, char* argv[])
     
     // Reset Control Plane Metrics
     g_routeFlaps = 0;
-    g_lastPaths.clear();
+    g_trustOutcomes = 0;
+    g_trustLinkUpdates = 0;
+    g_disseminatedBlocks = 0;
+    g_mprTransmissions = 0;
+    g_floodTransmissions = 0;
+    g_disseminationReached = 0;
+    g_mprRecomputations = 0;
+    g_mprSetSizeSum = 0.0;
+    g_flowRouteState.clear();
     g_avgSnrCostPart = 0.0;
     g_avgTrustCostPart = 0.0;
     g_pathCalculations = 0;
@@ -1138,14 +4618,65 @@ int main(int argc, char* argv[])
     LogComponentEnable("Ipv4L3Protocol", LOG_LEVEL_WARN);
     
     NS_LOG_UNCOND("6G MANET WiGig Simulation");
-    NS_LOG_UNCOND("Routing Mode: " << (useBlockchain ? "Proposed (Blockchain-assisted)" : "Baseline (Hop Count)"));
+    if (g_context.baseline.IsProtocol()) {
+        NS_LOG_UNCOND("Routing Mode: Baseline (" << RoutingBaseline::ProtocolName(baselineProtocol) << ")");
+    } else {
+        NS_LOG_UNCOND("Routing Mode: " << (useBlockchain ? "Proposed (Blockchain-assisted)" : "Baseline (Hop Count)"));
+    }
     NS_LOG_UNCOND("Nodes: " << numNodes << ", Flows: " << numFlows << 
                   ", Blackholes: " << numBlackholes);
+    if (routingMode == "hierarchical") {
+        NS_LOG_UNCOND("Route Computation: Hierarchical (cluster cell " << clusterSize << "m)");
+    } else if (routingMode == "cch") {
+        NS_LOG_UNCOND("Route Computation: Contraction hierarchy (range slack " << cchRangeSlack << ", "
+                      << cchThreads << " customization threads)");
+    }
+    if (trustRule == TrustModel::Window) {
+        NS_LOG_UNCOND("Trust Model: " << windowTrust.window << "-outcome window, flag at " << windowTrust.enterLossRatio
+                      << " loss or " << windowTrust.enterLossRun << " losses in a row, clear at " << windowTrust.exitLossRatio
+                      << " after " << windowTrust.exitDeliveryRun << " deliveries");
+    }
+    if (ackMode == "sack") {
+        NS_LOG_UNCOND("Delivery Feedback: end-to-end ACKs every " << ackInterval << " ms (cumulative + "
+                      << AckStream::kWindowBits << "-packet bitmap, port " << kAckPort << ")");
+    }
+    if (costMode == LinkCostMode::Ett) {
+        NS_LOG_UNCOND("Link Cost: ETT (" << packetSize << "-byte packets, 802.11a rate table, ledger delivery ratio)");
+    }
+    if (antenna == "sector") {
+        NS_LOG_UNCOND("Antenna: sector " << sectorGainDbi << " dBi, " << sectorBeamwidthDeg << " deg beamwidth, side lobe "
+                      << sectorSideLobeDbi << " dBi, quasi-omni " << sectorOmniDbi << " dBi");
+    }
+    if (blockage) {
+        NS_LOG_UNCOND("Blockage: " << g_context.blockage.GetNumObstacles() << " obstacles, body blockage "
+                      << (bodyBlockage ? "on" : "off") << " (" << bodyRadius << "m discs, " << bodyLossDb << " dB each)");
+    }
+    if (numChannels > 1) {
+        NS_LOG_UNCOND("Channels: " << numChannels << " orthogonal (one radio each), conflict-graph colouring, contention "
+                      << channelContention);
+    }
+    if (rateControl == "ledger") {
+        NS_LOG_UNCOND("Rate Control: ledger SNR - " << rateSnrMarginDb << " dB, Minstrel-style probing without ledger data");
+    }
     
     // ========================================================================
     // 1. Create Nodes
     // ========================================================================
-    g_context.nodes.Create(numNodes);
+    std::vector<Vector> initialPositions;
+    if (g_context.distributed) {
+        // A second allocator with the same streams reproduces exactly the initial
+        // positions MobilityHelper assigns below; strips are cut on them
+        Ptr<RandomRectanglePositionAllocator> initialAlloc = CreateAreaPositionAllocator(sideLength, rngRun);
+        for (uint32_t i = 0; i < numNodes; i++) {
+            initialPositions.push_back(initialAlloc->GetNext());
+        }
+        g_context.partitionOf = AssignGeographicStrips(initialPositions, g_context.numPartitions);
+        for (uint32_t i = 0; i < numNodes; i++) {
+            g_context.nodes.Add(CreateObject<Node>(g_context.partitionOf[i]));
+        }
+    } else {
+        g_context.nodes.Create(numNodes);
+    }
     
     // ========================================================================
     // 2. Setup WiFi (802.11ad WiGig at 60 GHz)
@@ -1157,6 +4688,9 @@ int main(int argc, char* argv[])
     // Note: WIFI_STANDARD_80211ad is not fully supported in this NS-3 version,
     // but 60 GHz physics are correctly modeled via propagation parameters
     wifi.SetStandard(WIFI_STANDARD_80211a);
+    if (rateControl == "ledger") {
+        wifi.SetRemoteStationManager("ns3::LedgerRateManager", "SnrMarginDb", DoubleValue(rateSnrMarginDb));
+    }
     
     WifiMacHelper mac;
     mac.SetType("ns3::AdhocWifiMac");
@@ -1172,6 +4706,13 @@ int main(int argc, char* argv[])
     channel.AddPropagationLoss("ns3::LogDistancePropagationLossModel",
                                "Exponent", DoubleValue(3.5),
                                "ReferenceLoss", DoubleValue(68.0));
+    if (antenna == "sector") {
+        // Antenna gains come from the beam pattern instead of the PHY's fixed TxGain/RxGain
+        channel.AddPropagationLoss("ns3::SectorAntennaLossModel");
+    }
+    if (blockage) {
+        channel.AddPropagationLoss("ns3::BlockageLossModel");
+    }
     channel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
     
     phy.SetChannel(channel.Create());
@@ -1180,16 +4721,45 @@ int main(int argc, char* argv[])
     // Link Budget Calculator recommended: TxGain = +30 dBi, RxGain = +30 dBi
     // Total +60dB link budget improvement (vs +40dB previously)
     // This ensures connectivity at 50m grid spacing while forcing multi-hop at 150m+
-    phy.Set("TxGain", DoubleValue(30.0));  // +30 dBi transmit antenna gain (increased from 20.0)
-    phy.Set("RxGain", DoubleValue(30.0));  // +30 dBi receive antenna gain (increased from 20.0)
+    double fixedGainDbi = antenna == "sector" ? 0.0 : 30.0;
+    phy.Set("TxGain", DoubleValue(fixedGainDbi));  // +30 dBi transmit antenna gain (increased from 20.0)
+    phy.Set("RxGain", DoubleValue(fixedGainDbi));  // +30 dBi receive antenna gain (increased from 20.0)
     phy.Set("TxPowerStart", DoubleValue(10.0));  // 10 dBm transmit power
     phy.Set("TxPowerEnd", DoubleValue(10.0));
     
-    g_context.netDevices = wifi.Install(phy, mac, g_context.nodes);
+    if (g_context.distributed) {
+        // One channel per strip: ns-3 wireless channels cannot span ranks
+        std::vector<Ptr<YansWifiChannel>> stripChannels;
+        for (uint32_t p = 0; p < g_context.numPartitions; p++) {
+            stripChannels.push_back(channel.Create());
+        }
+        for (uint32_t i = 0; i < numNodes; i++) {
+            phy.SetChannel(stripChannels[g_context.partitionOf[i]]);
+            g_context.netDevices.Add(wifi.Install(phy, mac, g_context.nodes.Get(i)));
+        }
+    } else {
+        g_context.netDevices = wifi.Install(phy, mac, g_context.nodes);
+    }
+    g_context.channelDevices.push_back(g_context.netDevices);
+    for (uint32_t c = 1; c < numChannels; c++) {
+        // Separate channel objects never hear each other: orthogonal channels
+        phy.SetChannel(channel.Create());
+        g_context.channelDevices.push_back(wifi.Install(phy, mac, g_context.nodes));
+    }
+    for (const NetDeviceContainer& devices : g_context.channelDevices) {
+        for (uint32_t i = 0; i < devices.GetN(); i++) {
+            Ptr<NetDevice> device = devices.Get(i);
+            g_context.macToNode[MacKey(Mac48Address::ConvertFrom(device->GetAddress()))] = device->GetNode()->GetId();
+        }
+    }
     
     NS_LOG_UNCOND("WiFi configured: 802.11a standard with 60 GHz physics");
     NS_LOG_UNCOND("60 GHz Physics: LogDistance (Exponent=3.5, ReferenceLoss=68dB @ 1m)");
-    NS_LOG_UNCOND("6G Beamforming: TxGain=+30dBi, RxGain=+30dBi (Total +60dB link budget)");
+    if (antenna == "sector") {
+        NS_LOG_UNCOND("6G Beamforming: steered sectors (up to +" << 2 * sectorGainDbi << "dB between aligned beams)");
+    } else {
+        NS_LOG_UNCOND("6G Beamforming: TxGain=+30dBi, RxGain=+30dBi (Total +60dB link budget)");
+    }
     NS_LOG_UNCOND("TxPower: 10.0 dBm");
     NS_LOG_UNCOND("Link Budget: Ensures connectivity at 50m, forces multi-hop at 150m+");
     
@@ -1203,17 +4773,7 @@ int main(int argc, char* argv[])
     // Increased node density (30 nodes) to avoid network partitioning
     // OPTIMIZATION: Use RngRun to seed position allocator for more variation between runs
     // sideLength is now a command-line parameter (default 300.0 for Dense Network)
-    Ptr<RandomRectanglePositionAllocator> positionAlloc = CreateObject<RandomRectanglePositionAllocator>();
-    Ptr<UniformRandomVariable> xPos = CreateObject<UniformRandomVariable>();
-    xPos->SetAttribute("Min", DoubleValue(0.0));
-    xPos->SetAttribute("Max", DoubleValue(sideLength));
-    xPos->SetStream(rngRun * 2);  // Use RngRun for variation
-    Ptr<UniformRandomVariable> yPos = CreateObject<UniformRandomVariable>();
-    yPos->SetAttribute("Min", DoubleValue(0.0));
-    yPos->SetAttribute("Max", DoubleValue(sideLength));
-    yPos->SetStream(rngRun * 2 + 1);  // Use RngRun for variation
-    positionAlloc->SetX(xPos);
-    positionAlloc->SetY(yPos);
+    Ptr<RandomRectanglePositionAllocator> positionAlloc = CreateAreaPositionAllocator(sideLength, rngRun);
     
     mobility.SetPositionAllocator(positionAlloc);
     
@@ -1226,6 +4786,9 @@ int main(int argc, char* argv[])
                               "PositionAllocator", PointerValue(positionAlloc));
     
     mobility.Install(g_context.nodes);
+    for (uint32_t i = 0; i < numNodes; i++) {
+        g_context.mobilityToNode[PeekPointer(g_context.nodes.Get(i)->GetObject<MobilityModel>())] = i;
+    }
     
     NS_LOG_UNCOND("Mobility: RandomWaypoint (" << sideLength << "m x " << sideLength << "m area, " << numNodes << " nodes)");
     NS_LOG_UNCOND("Speed: 1.0-5.0 m/s (Pedestrian), Pause: 1.0s");
@@ -1235,12 +4798,83 @@ int main(int argc, char* argv[])
     // ========================================================================
     InternetStackHelper internet;
     Ipv4StaticRoutingHelper staticRouting;
-    internet.SetRoutingHelper(staticRouting);
+    Ipv4ListRoutingHelper listRouting;
+    GreedyFallbackRoutingHelper greedyRouting;
+    SourceRouteRoutingHelper sourceRouteRouting;
+    AdversaryRoutingHelper adversaryRouting;
+    AodvHelper aodv;
+    OlsrHelper olsr;
+    DsdvHelper dsdv;
+    if (g_context.baseline.IsProtocol()) {
+        // Attack hook in front of the protocol (attackers take part in discovery, then drop data)
+        listRouting.Add(adversaryRouting, 30);
+        switch (baselineProtocol) {
+        case BaselineProtocol::Aodv: listRouting.Add(aodv, 10); break;
+        case BaselineProtocol::Olsr: listRouting.Add(olsr, 10); break;
+        case BaselineProtocol::Dsdv: listRouting.Add(dsdv, 10); break;
+        case BaselineProtocol::Static: break;
+        }
+        internet.SetRoutingHelper(listRouting);
+    } else if (greedyFallback || sourceRouting || g_context.adversary.IsPacketLevel()) {
+        // Priority order: attack hook, source routes, static routes, geographic fallback
+        if (g_context.adversary.IsPacketLevel()) {
+            listRouting.Add(adversaryRouting, 30);
+        }
+        if (sourceRouting) {
+            listRouting.Add(sourceRouteRouting, 20);
+        }
+        listRouting.Add(staticRouting, 10);
+        if (greedyFallback) {
+            listRouting.Add(greedyRouting, 0);
+        }
+        internet.SetRoutingHelper(listRouting);
+    } else {
+        internet.SetRoutingHelper(staticRouting);
+    }
     internet.Install(g_context.nodes);
     
     Ipv4AddressHelper address;
     address.SetBase("10.1.0.0", "255.255.0.0");
     g_context.ipv4Interfaces = address.Assign(g_context.netDevices);
+    g_context.channelInterfaces.push_back(g_context.ipv4Interfaces);
+    for (uint32_t c = 1; c < numChannels; c++) {
+        // Channel c radios: 10.(1+c).0.0/16 (flows keep addressing the channel 0 address)
+        Ipv4AddressHelper channelAddress;
+        channelAddress.SetBase(("10." + std::to_string(1 + c) + ".0.0").c_str(), "255.255.0.0");
+        g_context.channelInterfaces.push_back(channelAddress.Assign(g_context.channelDevices[c]));
+    }
+    for (const Ipv4InterfaceContainer& interfaces : g_context.channelInterfaces) {
+        for (uint32_t i = 0; i < g_context.nodes.GetN(); i++) {
+            g_context.addressToNode[interfaces.GetAddress(i).Get()] = i;
+        }
+    }
+    
+    // Distributed mode: portal links carry the radio links that cross strip boundaries.
+    // Lookahead: nothing sent across a boundary can be decoded earlier than the
+    // propagation delay over maxRadioRange plus the OFDM preamble.
+    double lookaheadS = maxRadioRange / kSpeedOfLight + kOfdmPreambleS;
+    if (g_context.distributed) {
+        g_context.portalPairs = SelectPortalPairs(initialPositions, g_context.partitionOf, maxRadioRange, portalsPerNode);
+        PointToPointHelper portalHelper;
+        portalHelper.SetDeviceAttribute("DataRate", StringValue("6Mbps"));  // 802.11a base rate
+        portalHelper.SetChannelAttribute("Delay", TimeValue(Seconds(lookaheadS)));
+        Ipv4AddressHelper portalAddress;
+        portalAddress.SetBase("10.128.0.0", "255.255.255.252");
+        for (const auto& pair : g_context.portalPairs) {
+            NetDeviceContainer portalDevices = portalHelper.Install(g_context.nodes.Get(pair.first),
+                                                                    g_context.nodes.Get(pair.second));
+            Ipv4InterfaceContainer portalInterfaces = portalAddress.Assign(portalDevices);
+            portalAddress.NewNetwork();
+            g_context.portals[pair] = PortalLink{portalInterfaces.Get(0).second, portalInterfaces.GetAddress(1)};
+            g_context.portals[std::make_pair(pair.second, pair.first)] =
+                PortalLink{portalInterfaces.Get(1).second, portalInterfaces.GetAddress(0)};
+            g_context.addressToNode[portalInterfaces.GetAddress(0).Get()] = pair.first;
+            g_context.addressToNode[portalInterfaces.GetAddress(1).Get()] = pair.second;
+        }
+        g_context.routingEngine.SetPartitions(&g_context.partitionOf, &g_context.portalPairs);
+        NS_LOG_UNCOND("Distributed: " << g_context.numPartitions << " strips, " << g_context.portalPairs.size()
+                      << " portal links, lookahead " << lookaheadS * 1e6 << " us");
+    }
     
     // ========================================================================
     // 5. Randomize Malicious Nodes (Dynamic Detection - No Hardcoding)
@@ -1305,38 +4939,104 @@ int main(int argc, char* argv[])
         
         g_context.activeFlows.push_back(std::make_pair(source, dest));
         g_sourceToDest[source] = dest; // Map Source -> Dest for Application Layer Tracking
+        g_destToSource[dest] = source;
+        g_context.flowIndex[(static_cast<uint64_t>(source) << 32) | dest] = g_context.activeFlows.size() - 1;
         NS_LOG_UNCOND("Flow " << i << ": Node " << source << " -> Node " << dest);
     }
     
+    // Behaviour records of the malicious nodes (separate stream, drawn only for packet-level models)
+    rng->SetStream(rngRun * 30);
+    const AttackModel mixedCycle[] = {AttackModel::Grayhole, AttackModel::OnOff, AttackModel::Selective};
+    uint32_t attackerIdx = 0;
+    for (uint32_t maliciousId : g_context.blackholeNodes) {
+        AttackModel model = (attack == AttackModel::Mixed) ? mixedCycle[attackerIdx++ % 3] : attack;
+        double dropProbability = (model == AttackModel::Grayhole) ? attackDropProb : 1.0;
+        double phaseFraction = (model == AttackModel::OnOff) ? rng->GetValue(0.0, 1.0) : 0.0;
+        std::vector<uint64_t> targetedFlows;
+        if (model == AttackModel::Selective && !g_context.activeFlows.empty()) {
+            targetedFlows.assign((g_context.activeFlows.size() + 63) / 64, 0);
+            for (size_t flowIdx = 0; flowIdx < g_context.activeFlows.size(); flowIdx++) {
+                if (rng->GetValue(0.0, 1.0) < attackTargetFraction) {
+                    targetedFlows[flowIdx >> 6] |= 1ULL << (flowIdx & 63);
+                }
+            }
+        }
+        g_context.adversary.AddAttacker(maliciousId, model, dropProbability, attackPeriod, attackDutyCycle,
+                                        phaseFraction, std::move(targetedFlows));
+    }
+    
+    // Route stability state is a flat array indexed by flow index (no per-heartbeat allocation)
+    g_flowRouteState.assign(g_context.activeFlows.size(), FlowRouteState());
+    g_context.flowPaths.assign(g_context.activeFlows.size(), std::vector<uint32_t>());
+    g_context.pathTraversals.assign(numNodes, 0);
+    g_tracker.Configure(g_context.activeFlows.size());
+    if (ackMode == "sack") {
+        g_context.acks.Configure(g_context.activeFlows.size(), Seconds(ackInterval / 1000.0));
+    }
+    
     // ========================================================================
     // 7. Setup Traffic (UDP)
     // ========================================================================
-    uint16_t basePort = 5000;
     ApplicationContainer serverApps;
     ApplicationContainer clientApps;
+    std::vector<Ptr<TrafficGenerator>> generators;
+    std::shared_ptr<const std::vector<TrafficSend>> traceSends;
+    if (trafficModel == "trace") {
+        traceSends = LoadTrafficTrace(trafficTrace);  // Loaded once, replayed by every flow
+    }
     
     for (size_t i = 0; i < g_context.activeFlows.size(); i++) {
         uint32_t source = g_context.activeFlows[i].first;
         uint32_t dest = g_context.activeFlows[i].second;
         
         Ipv4Address destAddress = g_context.ipv4Interfaces.GetAddress(dest);
-        uint16_t port = basePort + i;
+        uint16_t port = kDataBasePort + i;
+        
+        // UDP Server on destination (distributed mode: applications only on the owning rank)
+        if (g_context.IsLocal(dest)) {
+            UdpServerHelper serverHelper(port);
+            ApplicationContainer serverApp = serverHelper.Install(g_context.nodes.Get(dest));
+            serverApps.Add(serverApp);
+        }
+        if (!g_context.IsLocal(source)) {
+            continue;
+        }
         
-        // UDP Server on destination
-        UdpServerHelper serverHelper(port);
-        ApplicationContainer serverApp = serverHelper.Install(g_context.nodes.Get(dest));
-        serverApps.Add(serverApp);
+        if (trafficModel != "udpclient") {
+            // Traffic generator on source (high-rate models)
+            Ptr<TrafficGenerator> generator = CreateObject<TrafficGenerator>();
+            generator->Configure(destAddress, port, trafficModels.at(trafficModel), packetSize, dataRateBps,
+                                 onTime, offTime, MicroSeconds(sendQuantumUs), traceSends);
+            g_context.nodes.Get(source)->AddApplication(generator);
+            clientApps.Add(generator);
+            generators.push_back(generator);
+            continue;
+        }
         
         // UDP Client on source
         UdpClientHelper clientHelper(destAddress, port);
         clientHelper.SetAttribute("MaxPackets", UintegerValue(UINT32_MAX));
         clientHelper.SetAttribute("Interval", TimeValue(Seconds(0.1)));
-        clientHelper.SetAttribute("PacketSize", UintegerValue(1024));
+        clientHelper.SetAttribute("PacketSize", UintegerValue(packetSize));
         
         ApplicationContainer clientApp = clientHelper.Install(g_context.nodes.Get(source));
         clientApps.Add(clientApp);
     }
     
+    // End-to-end ACK sockets: destinations send from them, sources receive on them
+    if (g_context.acks.IsEnabled()) {
+        g_context.ackSockets.assign(numNodes, Ptr<Socket>());
+        for (const auto& flow : g_context.activeFlows) {
+            for (uint32_t endpoint : {flow.first, flow.second}) {
+                if (!g_context.IsLocal(endpoint) || g_context.ackSockets[endpoint]) continue;
+                Ptr<Socket> socket = Socket::CreateSocket(g_context.nodes.Get(endpoint), UdpSocketFactory::GetTypeId());
+                socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), kAckPort));
+                socket->SetRecvCallback(MakeCallback(&AckRxCallback));
+                g_context.ackSockets[endpoint] = socket;
+            }
+        }
+    }
+    
     // Start applications after routing and ARP have time to stabilize
     // ARP needs time to resolve MAC addresses in ad-hoc networks
     double appStartTime = 1.0;  // Start after 1 second (enough for ARP and routing)
@@ -1425,24 +5125,60 @@ int main(int argc, char* argv[])
         "/NodeList/*/ApplicationList/*/$ns3::UdpClient/Tx",
         MakeCallback(&AppTxCallback)
     );
+    Config::Connect(
+        "/NodeList/*/ApplicationList/*/$ns3::TrafficGenerator/Tx",
+        MakeCallback(&AppTxCallback)
+    );
     Config::Connect(
         "/NodeList/*/ApplicationList/*/$ns3::UdpServer/Rx",
         MakeCallback(&AppRxCallback)
     );
     NS_LOG_UNCOND("  - AppTx/Rx: Connected for End-to-End ACK simulation (15% sampling, 200ms timeout)");
+    if (g_context.baseline.IsProtocol()) {
+        Config::ConnectWithoutContext(
+            "/NodeList/*/$ns3::Ipv4L3Protocol/Tx",
+            MakeCallback(&Ipv4TxCallback)
+        );
+        NS_LOG_UNCOND("  - Ipv4Tx: " << RoutingBaseline::ProtocolName(baselineProtocol) << " control overhead");
+    }
+    if (!g_context.distributed) {
+        // First transmission and first delivery of every flow are on this process
+        g_context.baseline.TrackFlows(g_context.activeFlows.size());
+    }
+    if (g_context.distributed) {
+        Config::ConnectWithoutContextFailSafe(
+            "/NodeList/*/$ns3::Ipv4L3Protocol/UnicastForward",
+            MakeCallback(&UnicastForwardCallback)
+        );
+    }
     
     // ========================================================================
     // 10. Schedule Initial Heartbeat and Time Series Output
     // ========================================================================
+    if (!recordSnapshots.empty() && g_context.rank == 0) {
+        // Flows and malicious nodes are final at this point
+        SnapshotConfig config{g_context.routingEngine.GetAlpha(), beta, maxRadioRange, defaultSnr, trustFloor, useBlockchain,
+                              trustRule == TrustModel::Window ? windowTrust.window : 0};
+        g_context.snapshotRecorder = std::make_unique<SnapshotRecorder>();
+        if (!g_context.snapshotRecorder->Open(recordSnapshots, numNodes, config, g_context.activeFlows, g_context.blackholeNodes)) {
+            NS_FATAL_ERROR("cannot create snapshot file " << recordSnapshots);
+        }
+    }
     Simulator::Schedule(Seconds(0.0), &SimulationHeartbeat);
     Simulator::Schedule(Seconds(1.0), &TimeSeriesDataOutput);  // Start time series output after 1 second
+    if (g_context.acks.IsEnabled()) {
+        Simulator::Schedule(Seconds(appStartTime) + g_context.acks.GetInterval(), &SendFlowAcks);
+    }
     
     // ========================================================================
     // 11. Run Simulation
     // ========================================================================
     NS_LOG_UNCOND("Starting simulation...");
     Simulator::Stop(Seconds(simTime));
+    auto runWallStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    double runWallTimeS = std::chrono::duration<double>(std::chrono::steady_clock::now() - runWallStart).count();
+    uint64_t executedEvents = Simulator::GetEventCount();
     
     // ========================================================================
     // 12. Collect and output metrics (Task 2: Standardize Output + New Metrics)
@@ -1464,6 +5200,11 @@ int main(int argc, char* argv[])
     
     for (auto it = stats.begin(); it != stats.end(); ++it) {
         Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(it->first);
+        // Application flows only (routing protocol control traffic is reported in [BASELINE])
+        if (t.protocol != UdpL4Protocol::PROT_NUMBER || t.destinationPort < kDataBasePort ||
+            t.destinationPort >= kDataBasePort + g_context.activeFlows.size()) {
+            continue;
+        }
         NS_LOG_UNCOND("Flow " << it->first << ": " << t.sourceAddress << " -> " 
                     << t.destinationAddress << " | TX: " << it->second.txPackets 
                     << " packets, RX: " << it->second.rxPackets << " packets");
@@ -1480,6 +5221,29 @@ int main(int argc, char* argv[])
         totalHops += it->second.timesForwarded;
     }
     
+#ifdef NS3_MPI
+    if (g_context.distributed) {
+        // FlowMonitor only matches receptions to transmissions on the same rank, so the
+        // totals come from application counters, SeqTs delays and forward traces instead
+        MpiSum(g_appTxPackets);
+        MpiSum(g_appRxPackets);
+        MpiSum(g_appTxBytes);
+        MpiSum(g_appRxBytes);
+        MpiSum(g_appDelaySumMs);
+        MpiSum(g_unicastForwards);
+        totalTxPackets = g_appTxPackets;
+        totalRxPackets = g_appRxPackets;
+        totalTxBytes = g_appTxBytes;
+        totalRxBytes = g_appRxBytes;
+        totalDelaySum = g_appDelaySumMs;
+        totalHops = g_unicastForwards;
+        ReduceDistributedCounters();
+        ReduceAdversaryStats();
+        MpiMax(runWallTimeS);
+        MpiSum(executedEvents);
+    }
+#endif
+    
     NS_LOG_UNCOND("Total Statistics:");
     NS_LOG_UNCOND("  TX Packets: " << totalTxPackets);
     NS_LOG_UNCOND("  RX Packets: " << totalRxPackets);
@@ -1515,12 +5279,41 @@ int main(int argc, char* argv[])
     NS_LOG_UNCOND("  L3 Layer Drops: " << g_l3Drops << " (routing issues)");
     NS_LOG_UNCOND("  L3 Drops by Blackholes: " << g_blackholeL3Drops);
     NS_LOG_UNCOND("  Routes Skipped: " << g_routeSkips << " (blackhole avoidance)");
+    NS_LOG_UNCOND("  Trust Updates: " << g_trustOutcomes << " outcomes in " << g_trustLinkUpdates << " batched link writes");
     NS_LOG_UNCOND("  Trust Penalties Applied: " << g_trustPenalties);
+    if (sourceRouting) {
+        NS_LOG_UNCOND("Source Routing:");
+        NS_LOG_UNCOND("  Packets Stamped: " << g_sourceRoutedPackets);
+        NS_LOG_UNCOND("  Header Bytes: " << g_sourceRouteBytes << " ("
+                      << std::fixed << std::setprecision(1)
+                      << (g_sourceRoutedPackets > 0 ? static_cast<double>(g_sourceRouteBytes) / g_sourceRoutedPackets : 0.0)
+                      << " bytes/packet)");
+        NS_LOG_UNCOND("  Relay Header Pops: " << g_sourceRouteHops);
+        NS_LOG_UNCOND("  Header Bytes on Air: " << g_sourceRouteAirBytes << " (origin and relay transmissions)");
+        NS_LOG_UNCOND("  Paths Too Long (> " << kMaxSourceRouteHops << " nodes): " << g_sourceRouteTooLong);
+    }
+    if (greedyFallback) {
+        NS_LOG_UNCOND("Greedy Geographic Fallback:");
+        NS_LOG_UNCOND("  Greedy Forwards: " << g_greedyForwards);
+        NS_LOG_UNCOND("  Perimeter Forwards: " << g_perimeterForwards);
+        NS_LOG_UNCOND("  No Usable Neighbour: " << g_greedyFailures);
+    }
     
     // Control Plane Metrics Output
     NS_LOG_UNCOND("Control Plane Metrics:");
     NS_LOG_UNCOND("  Total Route Flaps: " << g_routeFlaps << " (route stability measure)");
     
+    // Per-flow flap rate (from the ring of recent flap timestamps)
+    for (size_t i = 0; i < g_flowRouteState.size(); i++) {
+        const FlowRouteState& routeState = g_flowRouteState[i];
+        std::cout << "[FLAP_RATE] Flow=" << i
+                  << " | Src=" << g_context.activeFlows[i].first
+                  << " | Dst=" << g_context.activeFlows[i].second
+                  << " | Flaps=" << routeState.flaps
+                  << " | RecentRate=" << std::fixed << std::setprecision(3) << routeState.RecentFlapRate() << "/s"
+                  << std::endl;
+    }
+    
     // Calculate and output cost composition
     if (g_pathCalculations > 0) {
         double avgSnrPart = g_avgSnrCostPart / static_cast<double>(g_pathCalculations);
@@ -1535,6 +5328,496 @@ int main(int argc, char* argv[])
         }
     }
     
+    // Hierarchical routing summary
+    if (g_context.routingEngine.IsHierarchical()) {
+        const ClusterRouter& clusters = g_context.routingEngine.GetClusterRouter();
+        double minClusterTrust = 1.0;
+        for (uint32_t c = 0; c < clusters.GetNumClusters(); c++) {
+            minClusterTrust = std::min(minClusterTrust, clusters.GetClusterMinTrust(c));
+        }
+        uint32_t activeClusters = clusters.GetNumActiveClusters();
+        std::cout << "[CLUSTER] CellSize=" << std::fixed << std::setprecision(1) << clusters.GetCellSize()
+                  << " | ActiveClusters=" << activeClusters
+                  << " | AvgSize=" << std::fixed << std::setprecision(2)
+                  << (activeClusters > 0 ? static_cast<double>(numNodes) / activeClusters : 0.0)
+                  << " | Moves=" << clusters.GetMoves()
+                  << " | PortalLinks=" << clusters.GetPortalLinks()
+                  << " | FlatFallbacks=" << clusters.GetFallbacks()
+                  << " | MinClusterTrust=" << std::fixed << std::setprecision(3) << minClusterTrust << std::endl;
+    }
+    
+    // Contraction hierarchy summary
+    if (g_context.routingEngine.IsContracted()) {
+        const CchRouter& cch = g_context.routingEngine.GetCchRouter();
+        uint64_t customizations = cch.GetCustomizations();
+        uint64_t contractions = cch.GetContractions();
+        std::cout << "[CCH] Contractions=" << contractions
+                  << " | Customizations=" << customizations
+                  << " | Arcs=" << cch.GetNumArcs()
+                  << " | Pairs=" << cch.GetNumPairs()
+                  << " | Height=" << cch.GetHeight()
+                  << " | Threads=" << cch.GetThreads()
+                  << " | MeanContractMs=" << std::fixed << std::setprecision(3)
+                  << (contractions > 0 ? cch.GetContractNs() / contractions / 1e6 : 0.0)
+                  << " | MeanCustomizeMs=" << std::fixed << std::setprecision(3)
+                  << (customizations > 0 ? cch.GetCustomizeNs() / customizations / 1e6 : 0.0)
+                  << " | Queries=" << cch.GetQueries() << std::endl;
+    }
+    
+    // Adversary report: per-attacker reaction times, then their distributions.
+    // Times are measured from the attacker's first drop (the attack becomes observable).
+    {
+        std::vector<double> timeToDetect;
+        std::vector<double> timeToIsolate;
+        std::vector<double> dropsBetween;
+        uint64_t lostBeforeIsolation = 0;
+        for (const AdversaryBehaviour& record : g_context.adversary.GetRecords()) {
+            bool active = record.firstDropS >= 0.0;
+            double ttdS = (active && record.detectedS >= 0.0) ? std::max(0.0, record.detectedS - record.firstDropS) : -1.0;
+            double ttiS = (active && record.isolatedS >= 0.0) ? record.isolatedS - record.firstDropS : -1.0;
+            uint64_t lost = record.isolatedS >= 0.0 ? record.dropsBeforeIsolation : record.packetsDropped;
+            uint64_t between = record.isolatedS >= 0.0 ? record.dropsBeforeIsolation - record.dropsAtDetection : 0;
+            if (ttdS >= 0.0) timeToDetect.push_back(ttdS);
+            if (ttiS >= 0.0) {
+                timeToIsolate.push_back(ttiS);
+                dropsBetween.push_back(static_cast<double>(between));
+            }
+            lostBeforeIsolation += lost;
+            std::cout << "[ATTACK] Node=" << record.nodeId
+                      << " | Model=" << AdversaryEngine::ModelName(record.model)
+                      << " | Seen=" << record.packetsSeen
+                      << " | Dropped=" << record.packetsDropped
+                      << " | FirstDropS=" << std::fixed << std::setprecision(3) << record.firstDropS
+                      << " | DetectedS=" << record.detectedS
+                      << " | IsolatedS=" << record.isolatedS
+                      << " | TimeToDetectS=" << ttdS
+                      << " | TimeToIsolateS=" << ttiS
+                      << " | DropsBetween=" << between
+                      << " | LostBeforeIsolation=" << lost << std::endl;
+        }
+        // Nearest-rank percentile of an unsorted sample (0 if empty)
+        auto percentile = [](std::vector<double> values, double q) {
+            if (values.empty()) return 0.0;
+            std::sort(values.begin(), values.end());
+            size_t rank = static_cast<size_t>(std::ceil(q * values.size()));
+            return values[rank > 0 ? rank - 1 : 0];
+        };
+        auto distribution = [&percentile](const char* name, const std::vector<double>& values) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(3)
+                << " | " << name << "_P10=" << percentile(values, 0.10)
+                << " | " << name << "_P50=" << percentile(values, 0.50)
+                << " | " << name << "_P90=" << percentile(values, 0.90)
+                << " | " << name << "_Max=" << percentile(values, 1.0);
+            return out.str();
+        };
+        std::cout << "[ATTACK_SUMMARY] Model=" << AdversaryEngine::ModelName(g_context.adversary.GetModel())
+                  << " | Attackers=" << g_context.adversary.GetRecords().size()
+                  << " | Detected=" << timeToDetect.size()
+                  << " | Isolated=" << timeToIsolate.size()
+                  << " | FalseFlags=" << g_context.adversary.GetFalseFlags()
+                  << " | LostBeforeIsolation=" << lostBeforeIsolation << std::endl;
+        std::cout << "[REACTION]" << distribution("TTD", timeToDetect).substr(2)
+                  << distribution("TTI", timeToIsolate)
+                  << distribution("DropsBetween", dropsBetween) << std::endl;
+    }
+    
+    // Windowed trust model: links held at the floor and the hysteresis transitions
+    if (trustRule == TrustModel::Window) {
+        const BlockchainLedger& ledger = g_context.ledger;
+        uint32_t window = ledger.GetWindowConfig().window;
+        uint32_t flaggedLinks = 0;
+        uint32_t maxLossRun = 0;
+        double deliveryRatioSum = 0.0;
+        ledger.ForEachLink([&](uint32_t a, uint32_t b, const LinkMetric& metric) {
+            flaggedLinks += metric.windowLow ? 1 : 0;
+            maxLossRun = std::max(maxLossRun, metric.history.GetLossRun());
+            deliveryRatioSum += ledger.GetDeliveryRatio(a, b);
+        });
+        size_t links = ledger.GetNumLinks();
+        std::cout << "[TRUST_WINDOW] Window=" << window
+                  << " | Links=" << links
+                  << " | FlaggedLinks=" << flaggedLinks
+                  << " | MeanWindowDeliveryRatio=" << std::fixed << std::setprecision(3)
+                  << (links > 0 ? deliveryRatioSum / links : 0.0)
+                  << " | MaxLossRun=" << maxLossRun
+                  << " | Flags=" << ledger.GetWindowEnters()
+                  << " | Clears=" << ledger.GetWindowExits() << std::endl;
+    }
+    
+    // End-to-end ACK stream: control overhead and ACK loss
+    if (g_context.acks.IsEnabled()) {
+        const AckStream& acks = g_context.acks;
+        uint64_t acksSent = acks.GetAcksSent();
+        uint64_t ackBytes = acks.GetAckBytes();
+        uint64_t acksReceived = acks.GetAcksReceived();
+        uint64_t ackedPackets = acks.GetAckedPackets();
+        uint64_t abandonedHoles = acks.GetAbandonedHoles();
+        uint64_t overflowAcks = acks.GetOverflowAcks();
+#ifdef NS3_MPI
+        if (g_context.distributed) {
+            // Destinations and sources of a flow may live on different ranks
+            MpiSum(acksSent);
+            MpiSum(ackBytes);
+            MpiSum(acksReceived);
+            MpiSum(ackedPackets);
+            MpiSum(abandonedHoles);
+            MpiSum(overflowAcks);
+        }
+#endif
+        std::cout << "[ACK] Mode=sack"
+                  << " | IntervalMs=" << std::fixed << std::setprecision(1) << acks.GetInterval().GetSeconds() * 1000.0
+                  << " | AcksSent=" << acksSent
+                  << " | AckBytes=" << ackBytes
+                  << " | AckLossPct=" << std::fixed << std::setprecision(2)
+                  << (acksSent > 0 ? 100.0 * (1.0 - static_cast<double>(acksReceived) / acksSent) : 0.0)
+                  << " | AckedPackets=" << ackedPackets
+                  << " | AckOverheadPct=" << std::fixed << std::setprecision(2)
+                  << (totalRxBytes > 0 ? 100.0 * ackBytes / totalRxBytes : 0.0)
+                  << " | OverflowAcks=" << overflowAcks
+                  << " | AbandonedHoles=" << abandonedHoles << std::endl;
+    }
+    
+    // Ledger dissemination cost per block: MPR relays vs plain flooding
+    if (g_disseminatedBlocks > 0) {
+        double blocks = static_cast<double>(g_disseminatedBlocks);
+        std::cout << "[DISSEMINATION] Blocks=" << g_disseminatedBlocks
+                  << " | MprTxPerBlock=" << std::fixed << std::setprecision(1) << g_mprTransmissions / blocks
+                  << " | FloodTxPerBlock=" << std::fixed << std::setprecision(1) << g_floodTransmissions / blocks
+                  << " | TxSavingsPct=" << std::fixed << std::setprecision(1)
+                  << (g_floodTransmissions > 0 ? 100.0 * (1.0 - static_cast<double>(g_mprTransmissions) / g_floodTransmissions) : 0.0)
+                  << " | ReachedPerBlock=" << std::fixed << std::setprecision(1) << g_disseminationReached / blocks
+                  << " | MeanMprSetSize=" << std::fixed << std::setprecision(2) << g_mprSetSizeSum / blocks
+                  << " | MprRecomputedPerBlock=" << std::fixed << std::setprecision(1) << g_mprRecomputations / blocks << std::endl;
+    }
+    
+    // Baseline comparison: control overhead and route acquisition (single-process runs)
+    if (g_context.baseline.GetTrackedFlows() > 0) {
+        const RoutingBaseline& routes = g_context.baseline;
+        std::vector<double> acquisitionMs = routes.GetAcquisitionMs();
+        std::sort(acquisitionMs.begin(), acquisitionMs.end());
+        auto percentile = [&acquisitionMs](double q) {
+            if (acquisitionMs.empty()) return 0.0;
+            size_t rank = static_cast<size_t>(std::ceil(q * acquisitionMs.size()));
+            return acquisitionMs[rank > 0 ? rank - 1 : 0];
+        };
+        std::cout << "[BASELINE] Protocol=" << RoutingBaseline::ProtocolName(routes.GetProtocol())
+                  << " | ControlPackets=" << routes.GetControlPackets()
+                  << " | ControlBytes=" << routes.GetControlBytes()
+                  << " | ControlPerDataPacket=" << std::fixed << std::setprecision(3)
+                  << (totalRxPackets > 0 ? static_cast<double>(routes.GetControlPackets()) / totalRxPackets : 0.0)
+                  << " | ControlBytesPerDataByte=" << std::fixed << std::setprecision(3)
+                  << (totalRxBytes > 0 ? static_cast<double>(routes.GetControlBytes()) / totalRxBytes : 0.0)
+                  << " | AcquiredFlows=" << acquisitionMs.size() << "/" << routes.GetTrackedFlows()
+                  << " | AcquisitionMs_P50=" << std::fixed << std::setprecision(3) << percentile(0.5)
+                  << " | AcquisitionMs_P90=" << percentile(0.9)
+                  << " | AcquisitionMs_Max=" << percentile(1.0)
+                  << " | PDR=" << std::fixed << std::setprecision(2) << pdrPercent << std::endl;
+    }
+    
+    // Trust report authentication (verification throughput and commit delay per node)
+    if (g_context.authentication.IsEnabled()) {
+        const AuthenticationModel& auth = g_context.authentication;
+        uint64_t reports = auth.GetReports();
+        uint64_t blocks = auth.GetBlocks();
+        double verifyCpuNs = auth.GetVerifyCpuNs();
+        double commitDelaySumNs = auth.GetCommitDelaySumNs();
+        double maxCommitDelayNs = auth.GetMaxCommitDelayNs();
+#ifdef NS3_MPI
+        if (g_context.distributed) {
+            // Each rank verifies the reports of its own strip
+            MpiSum(reports);
+            MpiSum(blocks);
+            MpiSum(verifyCpuNs);
+            MpiSum(commitDelaySumNs);
+            MpiMax(maxCommitDelayNs);
+        }
+#endif
+        double capacityNs = simTime * 1e9 * auth.GetCores() * g_context.numPartitions;
+        std::cout << "[AUTH] Mode=" << AuthenticationModel::ModeName(auth.GetMode())
+                  << " | Reports=" << reports
+                  << " | Blocks=" << blocks
+                  << " | VerifyCpuMs=" << std::fixed << std::setprecision(2) << verifyCpuNs / 1e6
+                  << " | SigsPerCpuS=" << std::fixed << std::setprecision(0)
+                  << (verifyCpuNs > 0.0 ? (reports + blocks) / (verifyCpuNs / 1e9) : 0.0)
+                  << " | Utilisation=" << std::fixed << std::setprecision(3) << verifyCpuNs / capacityNs
+                  << " | MeanCommitMs=" << std::fixed << std::setprecision(3)
+                  << (blocks > 0 ? commitDelaySumNs / blocks / 1e6 : 0.0)
+                  << " | MaxCommitMs=" << std::fixed << std::setprecision(3) << maxCommitDelayNs / 1e6 << std::endl;
+    }
+    
+    // Ledger-informed rate control (rate distribution overall and on the busiest links)
+    if (rateControl == "ledger") {
+        struct RateLink {
+            uint32_t node;
+            uint32_t peer;
+            const LinkRateStats* stats;  // Owned by the node's manager
+        };
+        LinkRateStats total;
+        std::vector<RateLink> links;
+        for (uint32_t i = 0; i < g_context.netDevices.GetN(); i++) {
+            Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(g_context.netDevices.Get(i));
+            if (!device) continue;
+            Ptr<LedgerRateManager> manager = DynamicCast<LedgerRateManager>(device->GetRemoteStationManager());
+            if (!manager) continue;
+            for (const auto& link : manager->GetLinkStats()) {
+                const LinkRateStats& stats = link.second;
+                for (size_t r = 0; r < total.frames.size(); r++) {
+                    total.frames[r] += stats.frames[r];
+                }
+                total.ledgerFrames += stats.ledgerFrames;
+                total.probeFrames += stats.probeFrames;
+                total.failures += stats.failures;
+                total.lostFrames += stats.lostFrames;
+                total.rateMbpsSum += stats.rateMbpsSum;
+                if (stats.GetFrames() > 0) {
+                    links.push_back({manager->GetNodeId(), link.first, &stats});
+                }
+            }
+        }
+#ifdef NS3_MPI
+        if (g_context.distributed) {
+            // Each rank sends the frames of its own strip
+            for (uint64_t& frames : total.frames) {
+                MpiSum(frames);
+            }
+            MpiSum(total.ledgerFrames);
+            MpiSum(total.probeFrames);
+            MpiSum(total.failures);
+            MpiSum(total.lostFrames);
+            MpiSum(total.rateMbpsSum);
+        }
+#endif
+        uint64_t frames = total.GetFrames();
+        std::cout << "[RATE] Control=ledger"
+                  << " | MarginDb=" << std::fixed << std::setprecision(1) << rateSnrMarginDb
+                  << " | Frames=" << frames
+                  << " | MeanRateMbps=" << std::fixed << std::setprecision(2)
+                  << (frames > 0 ? total.rateMbpsSum / frames : 0.0)
+                  << " | LedgerPct=" << std::fixed << std::setprecision(2)
+                  << (frames > 0 ? 100.0 * total.ledgerFrames / frames : 0.0)
+                  << " | ProbePct=" << (frames > 0 ? 100.0 * total.probeFrames / frames : 0.0)
+                  << " | Failures=" << total.failures
+                  << " | LostFrames=" << total.lostFrames
+                  << " | PHYDrops=" << g_phyDrops;
+        for (size_t r = 0; r < total.frames.size(); r++) {
+            std::cout << " | " << LinkRateStats::kRatesMbps[r] << "Mbps=" << total.frames[r];
+        }
+        std::cout << std::endl;
+        
+        // Busiest links of this process (rank 0's strip in distributed mode)
+        size_t shown = std::min<size_t>(rateReportLinks, links.size());
+        std::partial_sort(links.begin(), links.begin() + shown, links.end(),
+                          [](const RateLink& a, const RateLink& b) { return a.stats->GetFrames() > b.stats->GetFrames(); });
+        for (size_t l = 0; l < shown; l++) {
+            const LinkRateStats& stats = *links[l].stats;
+            uint64_t linkFrames = stats.GetFrames();
+            std::cout << "[RATE_LINK] " << links[l].node << "->" << links[l].peer
+                      << " | Frames=" << linkFrames
+                      << " | MeanRateMbps=" << std::fixed << std::setprecision(2) << stats.rateMbpsSum / linkFrames
+                      << " | LedgerPct=" << std::fixed << std::setprecision(2) << 100.0 * stats.ledgerFrames / linkFrames
+                      << " | Failures=" << stats.failures
+                      << " | LostFrames=" << stats.lostFrames
+                      << " | Rates=";
+            const char* separator = "";
+            for (size_t r = 0; r < stats.frames.size(); r++) {
+                if (stats.frames[r] == 0) continue;
+                std::cout << separator << LinkRateStats::kRatesMbps[r] << ":" << stats.frames[r];
+                separator = ",";
+            }
+            std::cout << std::endl;
+        }
+    }
+    
+    // Traffic engine summary (offered vs delivered load, send events per packet) and the
+    // cost of tracking the sampled packets (ring memory, heartbeat sweep time)
+    {
+        uint64_t trackedPackets = g_tracker.GetTracked();
+        uint64_t peakPending = g_tracker.GetPeakPending();
+        uint64_t trackerBytes = g_tracker.GetBytes();
+        uint64_t ringGrowths = g_tracker.GetGrowths();
+        uint64_t sweeps = g_tracker.GetSweeps();
+        double sweepNs = g_tracker.GetSweepNs();
+#ifdef NS3_MPI
+        if (g_context.distributed) {
+            MpiSum(trackedPackets);
+            MpiSum(peakPending);
+            MpiSum(trackerBytes);
+            MpiSum(ringGrowths);
+            MpiMax(sweepNs);
+        }
+#endif
+        std::cout << "[TRAFFIC] Model=" << trafficModel
+                  << " | Flows=" << g_context.activeFlows.size();
+        if (!generators.empty()) {
+            double activeS = appStopTime - appStartTime;
+            double offeredBps = 0.0;
+            uint64_t sentPackets = 0;
+            uint64_t sendFailures = 0;
+            uint64_t sendEvents = 0;
+            for (const auto& generator : generators) {
+                offeredBps += generator->GetOfferedRateBps(activeS);
+                sentPackets += generator->GetSentPackets();
+                sendFailures += generator->GetSendFailures();
+                sendEvents += generator->GetSendEvents();
+            }
+#ifdef NS3_MPI
+            if (g_context.distributed) {
+                MpiSum(sentPackets);
+                MpiSum(sendFailures);
+                MpiSum(sendEvents);
+            }
+#endif
+            std::cout << " | OfferedMbps=" << std::fixed << std::setprecision(3) << offeredBps / 1e6
+                      << " | DeliveredMbps=" << std::fixed << std::setprecision(3)
+                      << (activeS > 0.0 ? totalRxBytes * 8.0 / activeS / 1e6 : 0.0)
+                      << " | SentPackets=" << sentPackets
+                      << " | SendFailures=" << sendFailures
+                      << " | PacketsPerEvent=" << std::fixed << std::setprecision(2)
+                      << (sendEvents > 0 ? static_cast<double>(sentPackets) / sendEvents : 0.0);
+        }
+        // Peak pending and ring memory are summed over ranks; sweep time is the slowest rank's
+        std::cout << " | TrackedPackets=" << trackedPackets
+                  << " | PeakPending=" << peakPending
+                  << " | TrackerKB=" << std::fixed << std::setprecision(1) << trackerBytes / 1024.0
+                  << " | RingGrowths=" << ringGrowths
+                  << " | SweepUsPerHeartbeat=" << std::fixed << std::setprecision(2)
+                  << (sweeps > 0 ? sweepNs / sweeps / 1e3 : 0.0) << std::endl;
+    }
+    
+    // Directional antennas (steered beams and the cost of the gain lookups)
+    if (g_context.antenna.IsEnabled()) {
+        const SectorAntennaModel& model = g_context.antenna;
+        uint64_t lookups = model.GetLookups();
+        uint64_t angleMisses = model.GetAngleMisses();
+        uint64_t trainedLookups = model.GetTrainedLookups();
+#ifdef NS3_MPI
+        if (g_context.distributed) {
+            MpiSum(lookups);
+            MpiSum(angleMisses);
+            MpiSum(trainedLookups);
+        }
+#endif
+        std::cout << "[ANTENNA] Model=sector"
+                  << " | GainDbi=" << sectorGainDbi
+                  << " | BeamwidthDeg=" << sectorBeamwidthDeg
+                  << " | SideLobeDbi=" << sectorSideLobeDbi
+                  << " | SteeredNodes=" << model.GetSteeredNodes() << "/" << numNodes
+                  << " | BeamChanges=" << model.GetBeamChanges()
+                  << " | TrainedLinks=" << model.GetTrainedLinks()
+                  << " | GainLookups=" << lookups
+                  << " | TrainedLookupPct=" << std::fixed << std::setprecision(2)
+                  << (lookups > 0 ? 100.0 * trainedLookups / lookups : 0.0)
+                  << " | AngleCacheHitPct=" << std::fixed << std::setprecision(2)
+                  << (lookups > 0 ? std::max(0.0, 100.0 * (1.0 - static_cast<double>(angleMisses) / lookups)) : 0.0)
+                  << " | PHYDrops=" << g_phyDrops
+                  << " | PDR=" << std::fixed << std::setprecision(2) << pdrPercent << std::endl;
+    }
+    
+    // Obstacle and body blockage (line-of-sight test cost and how often links were blocked)
+    if (g_context.blockage.IsEnabled()) {
+        const BlockageModel& model = g_context.blockage;
+        uint64_t lookups = model.GetLookups();
+        uint64_t tests = model.GetTests();
+        uint64_t blockedTests = model.GetBlockedTests();
+        double testNs = model.GetTestNs();
+#ifdef NS3_MPI
+        if (g_context.distributed) {
+            MpiSum(lookups);
+            MpiSum(tests);
+            MpiSum(blockedTests);
+            MpiSum(testNs);
+        }
+#endif
+        std::cout << "[BLOCKAGE] Obstacles=" << model.GetNumObstacles()
+                  << " | BvhNodes=" << model.GetBvhNodes()
+                  << " | BodyBlockage=" << (bodyBlockage ? 1 : 0)
+                  << " | GridCells=" << model.GetGridCells()
+                  << " | LossLookups=" << lookups
+                  << " | LosTests=" << tests
+                  << " | CacheHitPct=" << std::fixed << std::setprecision(2)
+                  << (lookups > 0 ? std::max(0.0, 100.0 * (1.0 - static_cast<double>(tests) / lookups)) : 0.0)
+                  << " | BlockedPct=" << std::fixed << std::setprecision(2)
+                  << (tests > 0 ? 100.0 * blockedTests / tests : 0.0)
+                  << " | BodyCrossings=" << model.GetBodyCrossings()
+                  << " | NsPerTest=" << std::fixed << std::setprecision(1) << (tests > 0 ? testNs / tests : 0.0)
+                  << " | PHYDrops=" << g_phyDrops
+                  << " | PDR=" << std::fixed << std::setprecision(2) << pdrPercent << std::endl;
+    }
+    
+    // Multi-channel operation (capacity against channel count: compare DeliveredMbps across --numChannels)
+    if (numChannels > 1) {
+        const ChannelAssigner& channels = g_context.channels;
+        std::pair<uint64_t, uint64_t> conflicts = channels.GetConflictTotals();
+        double activeS = appStopTime - appStartTime;
+        std::cout << "[CHANNELS] Channels=" << numChannels
+                  << " | Links=" << channels.GetNumLinks()
+                  << " | LinksPerChannel=";
+        for (size_t c = 0; c < channels.GetLoad().size(); c++) {
+            std::cout << (c > 0 ? "/" : "") << channels.GetLoad()[c];
+        }
+        std::cout << " | SameChannelConflictPct=" << std::fixed << std::setprecision(2)
+                  << (conflicts.second > 0 ? 100.0 * conflicts.first / conflicts.second : 0.0)
+                  << " | RecolouredPerUpdate=" << std::fixed << std::setprecision(2)
+                  << (channels.GetUpdates() > 0 ? static_cast<double>(channels.GetRecoloured()) / channels.GetUpdates() : 0.0)
+                  << " | RefreshedPerUpdate=" << std::fixed << std::setprecision(2)
+                  << (channels.GetUpdates() > 0 ? static_cast<double>(channels.GetRefreshed()) / channels.GetUpdates() : 0.0)
+                  << " | Contention=" << channelContention
+                  << " | DeliveredMbps=" << std::fixed << std::setprecision(3)
+                  << (activeS > 0.0 ? totalRxBytes * 8.0 / activeS / 1e6 : 0.0)
+                  << " | PDR=" << std::fixed << std::setprecision(2) << pdrPercent << std::endl;
+    }
+    
+    if (g_context.chainStore) {
+        g_context.chainStore->Close();  // Drains the group-commit queue and seals the last segment
+        std::cout << "[CHAIN] Prefix=" << chainStore
+                  << " | Blocks=" << g_context.chainStore->GetBlocks()
+                  << " | Bytes=" << g_context.chainStore->GetBytes()
+                  << " | Segments=" << g_context.chainStore->GetSegments()
+                  << " | GroupCommits=" << g_context.chainStore->GetGroupCommits()
+                  << " | WriteErrors=" << (g_context.chainStore->Failed() ? 1 : 0) << std::endl;
+    }
+    
+    if (g_context.snapshotRecorder) {
+        g_context.snapshotRecorder->Close();
+        std::cout << "[SNAPSHOTS] File=" << recordSnapshots
+                  << " | Heartbeats=" << g_context.snapshotRecorder->GetFrames()
+                  << " | Bytes=" << g_context.snapshotRecorder->GetBytes() << std::endl;
+    }
+    
+    // Heartbeat phase and trace-callback profile (wall clock + optional hardware counters)
+    g_profiler.Report(perfCounters);
+    
+    uint64_t peakRssKb = GetPeakRssKb();
+#ifdef NS3_MPI
+    if (g_context.distributed) {
+        MpiMax(peakRssKb);
+    }
+#endif
+    
+    // Run-level performance summary (parsed by run_mpi_scaling.sh)
+    std::cout << "[PERF] WallTimeS=" << std::fixed << std::setprecision(3) << runWallTimeS
+              << " | SimTimeS=" << std::fixed << std::setprecision(1) << simTime
+              << " | Events=" << executedEvents
+              << " | EventsPerSec=" << std::fixed << std::setprecision(0)
+              << (runWallTimeS > 0.0 ? static_cast<double>(executedEvents) / runWallTimeS : 0.0)
+              << " | PeakRssKb=" << peakRssKb << std::endl;
+    
+    if (g_context.distributed) {
+        std::vector<uint32_t> localNodes(g_context.numPartitions, 0);
+        for (uint32_t p : g_context.partitionOf) {
+            localNodes[p]++;
+        }
+        std::cout << "[MPI] Ranks=" << g_context.numPartitions
+                  << " | PortalLinks=" << g_context.portalPairs.size()
+                  << " | LookaheadUs=" << std::fixed << std::setprecision(3) << lookaheadS * 1e6
+                  << " | MinRankNodes=" << *std::min_element(localNodes.begin(), localNodes.end())
+                  << " | MaxRankNodes=" << *std::max_element(localNodes.begin(), localNodes.end())
+                  << " | DeliveryRecords=" << g_mpiDeliveryRecords
+                  << " | LedgerRecords=" << g_mpiLedgerRecords
+                  << " | PathWords=" << g_mpiPathWords << std::endl;
+    }
+    
     // Output detailed drop summary for log analysis
     std::cout << "[DROP_SUMMARY] RunID=" << rngRun 
               << " | Mode=" << (useBlockchain ? "Proposed" : "Baseline")
@@ -1564,6 +5847,11 @@ int main(int argc, char* argv[])
               << avgHopCount << ", " << g_routeSkips << std::endl; // Use g_routeSkips as the value for ReliabilityDrops
     
     Simulator::Destroy();
+#ifdef NS3_MPI
+    if (g_context.distributed) {
+        MpiInterface::Disable();
+    }
+#endif
     
     NS_LOG_UNCOND("Simulation complete!");
     